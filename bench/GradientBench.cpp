@@ -38,6 +38,16 @@ static const SkColor gColors[] = {
 static const SkColor gShallowColors[] = { 0xFF555555, 0xFF444444 };
 static const SkScalar gPos[] = {0.25f, 0.75f};
 
+// COLRv1 color lines have a handful of unevenly spaced stops, often with hard stops.
+static const SkScalar gColrPos[] = {0, 0.15f, 0.4f, 0.4f, 0.8f, 1};
+
+// Enough unevenly spaced stops for the interval lookup to be indexed.
+static const SkScalar gManyPos[] = {
+    0,     0.02f, 0.05f, 0.06f, 0.10f, 0.13f, 0.15f, 0.20f, 0.22f, 0.25f, 0.29f, 0.30f,
+    0.35f, 0.37f, 0.40f, 0.44f, 0.47f, 0.50f, 0.52f, 0.57f, 0.60f, 0.62f, 0.66f, 0.70f,
+    0.71f, 0.75f, 0.80f, 0.82f, 0.86f, 0.90f, 0.95f, 1,
+};
+
 // We have several special-cases depending on the number (and spacing) of colors, so
 // try to exercise those here.
 static const GradData gGradData[] = {
@@ -46,6 +56,8 @@ static const GradData gGradData[] = {
     { 3, gColors, nullptr, "_3color" },
     { 2, gShallowColors, nullptr, "_shallow" },
     { 2, gColors, gPos, "_pos" },
+    { SK_ARRAY_COUNT(gColrPos), gColors, gColrPos, "_colrv1" },
+    { SK_ARRAY_COUNT(gManyPos), gColors, gManyPos, "_manystops" },
 };
 
 /// Ignores scale
@@ -72,6 +84,17 @@ static sk_sp<SkShader> MakeSweep(const SkPoint pts[2], const GradData& data,
     return SkGradientShader::MakeSweep(center.fX, center.fY, data.fColors, data.fPos, data.fCount);
 }
 
+/// Ignores scale
+static sk_sp<SkShader> MakeSweepWindow(const SkPoint pts[2], const GradData& data,
+                                       SkTileMode tm, float scale) {
+    // Part of a turn, as COLRv1 fonts usually sweep.
+    SkPoint center;
+    center.set(SkScalarAve(pts[0].fX, pts[1].fX),
+               SkScalarAve(pts[0].fY, pts[1].fY));
+    return SkGradientShader::MakeSweep(center.fX, center.fY, data.fColors, data.fPos,
+                                       data.fCount, tm, 45, 300, 0, nullptr);
+}
+
 /// Ignores scale
 static sk_sp<SkShader> MakeConical(const SkPoint pts[2], const GradData& data,
                                    SkTileMode tm, float scale) {
@@ -140,6 +163,7 @@ static const struct {
     { MakeConicalZeroRad,         "conicalZero" },
     { MakeConicalOutside,         "conicalOut" },
     { MakeConicalOutsideZeroRad,  "conicalOutZero" },
+    { MakeSweepWindow,            "sweepWindow" },
 };
 
 enum GradType { // these must match the order in gGrads
@@ -149,7 +173,8 @@ enum GradType { // these must match the order in gGrads
     kConical_GradType,
     kConicalZero_GradType,
     kConicalOut_GradType,
-    kConicalOutZero_GradType
+    kConicalOutZero_GradType,
+    kSweepWindow_GradType
 };
 
 enum GeomType {
@@ -266,6 +291,12 @@ DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[2], SkTileMode::
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[0], SkTileMode::kMirror); )
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[1], SkTileMode::kMirror); )
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[2], SkTileMode::kMirror); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[5]); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[5], SkTileMode::kRepeat); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[5], SkTileMode::kMirror); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[6]); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[6], SkTileMode::kRepeat); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[6], SkTileMode::kMirror); )
 
 DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[0]); )
 DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[1]); )
@@ -280,9 +311,14 @@ DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[0], SkTileMode::
 
 DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[0], SkTileMode::kMirror); )
 DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[0], SkTileMode::kRepeat); )
+DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[5], SkTileMode::kMirror); )
+DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[6], SkTileMode::kRepeat); )
 DEF_BENCH( return new GradientBench(kSweep_GradType); )
 DEF_BENCH( return new GradientBench(kSweep_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kSweep_GradType, gGradData[2]); )
+DEF_BENCH( return new GradientBench(kSweepWindow_GradType); )
+DEF_BENCH( return new GradientBench(kSweepWindow_GradType, gGradData[5]); )
+DEF_BENCH( return new GradientBench(kSweepWindow_GradType, gGradData[5], SkTileMode::kRepeat); )
 DEF_BENCH( return new GradientBench(kConical_GradType); )
 DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[2]); )
@@ -353,3 +389,42 @@ private:
 
 DEF_BENCH( return new Gradient2Bench(false); )
 DEF_BENCH( return new Gradient2Bench(true); )
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Draws glyph sized gradients which all share one color line, each with a shader of its own,
+// as COLRv1 glyphs do.
+class GradientColorLineBench : public Benchmark {
+    SkString fName;
+    GradData fData;
+
+public:
+    GradientColorLineBench(GradData data) : fData(data) {
+        fName.printf("gradient_colorline%s", data.fName);
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        SkPaint paint;
+        this->setupPaint(&paint);
+
+        const SkRect r = SkRect::MakeWH(16, 16);
+        for (int i = 0; i < loops; i++) {
+            const SkScalar x = SkIntToScalar(i % 32);
+            const SkPoint pts[] = {{ x, 0 }, { x + 16, 16 }};
+            paint.setShader(SkGradientShader::MakeLinear(pts, fData.fColors, fData.fPos,
+                                                         fData.fCount, SkTileMode::kClamp));
+            canvas->drawRect(r, paint);
+        }
+    }
+
+private:
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH( return new GradientColorLineBench(gGradData[5]); )
+DEF_BENCH( return new GradientColorLineBench(gGradData[6]); )
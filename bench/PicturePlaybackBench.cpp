@@ -7,8 +7,10 @@
 #include <memory>
 
 #include "bench/Benchmark.h"
+#include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkPictureRecorder.h"
@@ -16,6 +18,7 @@
 #include "include/core/SkRect.h"
 #include "include/core/SkString.h"
 #include "include/utils/SkRandom.h"
+#include "include/utils/SkTiledPicturePlayback.h"
 
 // This is designed to emulate about 4 screens of textual content
 
@@ -97,3 +100,81 @@ DEF_BENCH( return new TiledPlaybackBench(kNone,     kRandom); )
 DEF_BENCH( return new TiledPlaybackBench(kNone,     kTiled ); )
 DEF_BENCH( return new TiledPlaybackBench(kRTree,    kRandom); )
 DEF_BENCH( return new TiledPlaybackBench(kRTree,    kTiled ); )
+
+// Large pictures, like maps or documents exported to raster, played back through one canvas on
+// one thread, or split into tiles drawn in parallel by SkTiledPicturePlayback.
+class ParallelPlaybackBench : public Benchmark {
+public:
+    // threads == 0 plays back through one canvas on this thread; otherwise tiles are drawn on a
+    // FIFO or work stealing pool of that many threads.
+    ParallelPlaybackBench(int threads, bool workStealing)
+        : fThreads(threads)
+        , fWorkStealing(workStealing) {
+        if (fThreads == 0) {
+            fName = "parallel_playback_direct";
+        } else {
+            fName.printf("parallel_playback_tiled_%dthreads%s", fThreads,
+                         fWorkStealing ? "_workstealing" : "");
+        }
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        constexpr int kSize = 4096;
+        fPixels.allocN32Pixels(kSize, kSize);
+
+        SkRTreeFactory factory;
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(kSize, kSize, &factory);
+            SkRandom rand;
+            for (int i = 0; i < 50000; i++) {
+                SkRect r = SkRect::MakeXYWH(rand.nextRangeScalar(0, kSize),
+                                            rand.nextRangeScalar(0, kSize),
+                                            rand.nextRangeScalar(0, 256),
+                                            rand.nextRangeScalar(0, 256));
+                SkPaint paint;
+                paint.setAntiAlias(true);
+                paint.setColor(rand.nextU() | 0x80000000);
+                if (i % 2) {
+                    canvas->drawRect(r, paint);
+                } else {
+                    canvas->drawOval(r, paint);
+                }
+            }
+        fPic = recorder.finishRecordingAsPicture();
+
+        if (fThreads > 0) {
+            fExecutor = fWorkStealing ? SkExecutor::MakeWorkStealingThreadPool(fThreads)
+                                      : SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            fPixels.eraseColor(SK_ColorWHITE);
+            if (fExecutor) {
+                SkTiledPicturePlayback::Draw(fPixels.pixmap(), fPic.get(), nullptr, *fExecutor);
+            } else {
+                SkCanvas canvas(fPixels);
+                fPic->playback(&canvas);
+            }
+        }
+    }
+
+private:
+    int                         fThreads;
+    bool                        fWorkStealing;
+    SkString                    fName;
+    SkBitmap                    fPixels;
+    sk_sp<SkPicture>            fPic;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
+DEF_BENCH( return new ParallelPlaybackBench(0, false); )
+DEF_BENCH( return new ParallelPlaybackBench(1, false); )
+DEF_BENCH( return new ParallelPlaybackBench(4, false); )
+DEF_BENCH( return new ParallelPlaybackBench(8, false); )
+DEF_BENCH( return new ParallelPlaybackBench(4, true); )
+DEF_BENCH( return new ParallelPlaybackBench(8, true); )
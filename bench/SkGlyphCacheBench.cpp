@@ -9,9 +9,11 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkTypeface.h"
 #include "src/core/SkRemoteGlyphCache.h"
+#include "src/core/SkStrikeCache.h"
 #include "src/core/SkStrikeSpec.h"
 #include "src/core/SkTLazy.h"
 #include "src/core/SkTaskGroup.h"
@@ -112,10 +114,127 @@ private:
     SkString fName;
 };
 
+// Generates color glyph images on many threads at once. Each thread uses its own strike cache, so
+// every image comes from a scaler context. The threads either share one typeface, or each thread
+// has its own typeface (backed by the same font file).
+class SkScalerContextContentionBench : public Benchmark {
+public:
+    SkScalerContextContentionBench(int threads, bool sharedTypeface)
+        : fThreads(threads), fSharedTypeface(sharedTypeface) { }
+
+protected:
+    const char* onGetName() override {
+        fName.printf("SkScalerContextContention_%dthreads_%s", fThreads,
+                     fSharedTypeface ? "shared_typeface" : "typeface_per_thread");
+        return fName.c_str();
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads, false);
+        for (int i = 0; i < fThreads; i++) {
+            fTypefaces.push_back(fSharedTypeface && i > 0
+                                         ? fTypefaces.front()
+                                         : MakeResourceAsTypeface("fonts/colrv1_samples.ttf"));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fTypefaces.front()) {
+            return;
+        }
+        static constexpr SkGlyphID kGlyphs[] = {19, 33, 34, 35, 20, 21, 22, 23, 24, 25};
+        SkPackedGlyphID packedIDs[SK_ARRAY_COUNT(kGlyphs)];
+        for (size_t i = 0; i < SK_ARRAY_COUNT(kGlyphs); i++) {
+            packedIDs[i] = SkPackedGlyphID{kGlyphs[i]};
+        }
+
+        for (int work = 0; work < loops; work++) {
+            SkTaskGroup(*fExecutor).batch(fThreads, [&](int threadIndex) {
+                SkStrikeCache strikeCache;
+                SkFont font(fTypefaces[threadIndex], 48);
+                auto strikeSpec = SkStrikeSpec::MakeMask(
+                        font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                        SkScalerContextFlags::kNone, SkMatrix::I());
+                SkBulkGlyphMetricsAndImages images{strikeSpec.findOrCreateStrike(&strikeCache)};
+                (void)images.glyphs(SkMakeSpan(packedIDs));
+            });
+        }
+    }
+
+private:
+    using INHERITED = Benchmark;
+    const int fThreads;
+    const bool fSharedTypeface;
+    std::unique_ptr<SkExecutor> fExecutor;
+    std::vector<sk_sp<SkTypeface>> fTypefaces;
+    SkString fName;
+};
+
+// Measures generating COLRv1 glyph images, which are small and dominated by fixed per-glyph costs.
+class SkColrV1GlyphImageBench : public Benchmark {
+public:
+    SkColrV1GlyphImageBench(SkScalar size) : fSize(size) { }
+
+protected:
+    const char* onGetName() override {
+        fName.printf("SkColrV1GlyphImage_%g", fSize);
+        return fName.c_str();
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        fTypeface = MakeResourceAsTypeface("fonts/colrv1_samples.ttf");
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fTypeface) {
+            return;
+        }
+        static constexpr SkGlyphID kGlyphs[] = {19, 33, 34, 35, 20, 21, 22, 23, 24, 25};
+        SkPackedGlyphID packedIDs[SK_ARRAY_COUNT(kGlyphs)];
+        for (size_t i = 0; i < SK_ARRAY_COUNT(kGlyphs); i++) {
+            packedIDs[i] = SkPackedGlyphID{kGlyphs[i]};
+        }
+
+        SkFont font(fTypeface, fSize);
+        auto strikeSpec = SkStrikeSpec::MakeMask(
+                font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+        for (int work = 0; work < loops; work++) {
+            // A fresh strike cache so that every glyph image is generated again.
+            SkStrikeCache strikeCache;
+            SkBulkGlyphMetricsAndImages images{strikeSpec.findOrCreateStrike(&strikeCache)};
+            (void)images.glyphs(SkMakeSpan(packedIDs));
+        }
+    }
+
+private:
+    using INHERITED = Benchmark;
+    const SkScalar fSize;
+    sk_sp<SkTypeface> fTypeface;
+    SkString fName;
+};
+
 DEF_BENCH( return new SkGlyphCacheBasic(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheBasic(32 * 1024 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(32 * 1024 * 1024); )
+DEF_BENCH( return new SkScalerContextContentionBench(1, true); )
+DEF_BENCH( return new SkScalerContextContentionBench(8, true); )
+DEF_BENCH( return new SkScalerContextContentionBench(16, true); )
+DEF_BENCH( return new SkScalerContextContentionBench(1, false); )
+DEF_BENCH( return new SkScalerContextContentionBench(8, false); )
+DEF_BENCH( return new SkScalerContextContentionBench(16, false); )
+DEF_BENCH( return new SkColrV1GlyphImageBench(16); )
+DEF_BENCH( return new SkColrV1GlyphImageBench(48); )
+DEF_BENCH( return new SkColrV1GlyphImageBench(128); )
 
 namespace {
 class DiscardableManager : public SkStrikeServer::DiscardableHandleManager,
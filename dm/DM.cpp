@@ -1416,6 +1416,8 @@ struct Task {
 
 static SkTDArray<skiatest::Test>* gParallelTests = new SkTDArray<skiatest::Test>;
 static SkTDArray<skiatest::Test>* gSerialTests   = new SkTDArray<skiatest::Test>;
+// CPU tests which must not run at the same time as any other work.
+static SkTDArray<skiatest::Test>* gSingleThreadedTests = new SkTDArray<skiatest::Test>;
 
 static void gather_tests() {
     if (!FLAGS_src.contains("tests")) {
@@ -1430,6 +1432,8 @@ static void gather_tests() {
         }
         if (test.needsGpu && FLAGS_gpu) {
             gSerialTests->push_back(test);
+        } else if (test.serial && FLAGS_cpu) {
+            gSingleThreadedTests->push_back(test);
         } else if (!test.needsGpu && FLAGS_cpu) {
             gParallelTests->push_back(test);
         }
@@ -1524,9 +1528,11 @@ int main(int argc, char** argv) {
         return 1;
     }
     gather_tests();
-    gPending = gSrcs->count() * gSinks->count() + gParallelTests->count() + gSerialTests->count();
+    gPending = gSrcs->count() * gSinks->count() + gParallelTests->count() + gSerialTests->count() +
+               gSingleThreadedTests->count();
     info("%d srcs * %d sinks + %d tests == %d tasks\n",
-         gSrcs->count(), gSinks->count(), gParallelTests->count() + gSerialTests->count(),
+         gSrcs->count(), gSinks->count(),
+         gParallelTests->count() + gSerialTests->count() + gSingleThreadedTests->count(),
          gPending);
 
     // Kick off as much parallel work as we can, making note of any serial work we'll need to do.
@@ -1564,6 +1570,7 @@ int main(int argc, char** argv) {
     gDefinitelyThreadSafeWork->wait();
 
     // At this point we're back in single-threaded land.
+    for (skiatest::Test& test : *gSingleThreadedTests) { run_test(test, grCtxOptions); }
 
     // We'd better have run everything.
     SkASSERT(gPending == 0);
@@ -103,6 +103,12 @@ public:
      */
     SkRect getBounds();
 
+    /**
+     *  Return approximately how many bytes would be freed if this drawable is destroyed.
+     *  The base implementation returns 0 to indicate that this is unknown.
+     */
+    virtual size_t approximateBytesUsed();
+
     /**
      *  Calling this invalidates the previous generation ID, and causes a new one to be computed
      *  the next time getGenerationID() is called. Typically this is called by the object itself,
@@ -21,6 +21,11 @@ public:
                                                           bool allowBorrowing = true);
     static std::unique_ptr<SkExecutor> MakeLIFOThreadPool(int threads = 0,
                                                           bool allowBorrowing = true);
+    // Like the above, but each thread keeps its own work, running what it added most recently
+    // first, and steals the oldest work of other threads when it runs out. This scales better
+    // with many threads, and with work that adds more work.
+    static std::unique_ptr<SkExecutor> MakeWorkStealingThreadPool(int threads = 0,
+                                                                  bool allowBorrowing = true);
 
     // There is always a default SkExecutor available by calling SkExecutor::GetDefault().
     static SkExecutor& GetDefault();
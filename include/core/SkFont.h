@@ -414,6 +414,18 @@ public:
         this->getWidthsBounds(glyphs, count, nullptr, bounds, paint);
     }
 
+    /** Retrieves bounds for each glyph in glyphs which contain everything it draws, without
+        rounding them out to whole pixels. They are not the exact ink: color glyphs are measured
+        from their COLRv1 ClipBox, which the font only promises to contain the glyph, or else from
+        the outlines of their paint graph, so measuring them scan converts nothing. Other glyphs,
+        and every glyph of an emboldened font, get the bounds getBounds() returns without a paint.
+
+        @param glyphs  array of glyph indices to be measured
+        @param count   number of glyphs
+        @param bounds  returns bounds for each glyph relative to (0, 0)
+     */
+    void getConservativeBounds(const SkGlyphID glyphs[], int count, SkRect bounds[]) const;
+
     /** Retrieves the positions for each glyph, beginning at the specified origin. The caller
         must allocated at least count number of elements in the pos[] array.
 
@@ -8,6 +8,7 @@
 #ifndef SkFontArguments_DEFINED
 #define SkFontArguments_DEFINED
 
+#include "include/core/SkColor.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkTypes.h"
 
@@ -22,7 +23,28 @@ struct SkFontArguments {
         int coordinateCount;
     };
 
-    SkFontArguments() : fCollectionIndex(0), fVariationDesignPosition{nullptr, 0} {}
+    /** Specify a palette to use and overrides for palette entries.
+     *
+     *  `overrides` is a list of pairs of palette entry index and color.
+     *  The overriden palette entries will use the associated color.
+     *  Override pairs with palette entry indices out of range will not be applied.
+     *  Later override entries override earlier ones.
+     */
+    struct Palette {
+        struct Override {
+            int index;
+            SkColor color;
+        };
+        int index;
+        const Override* overrides;
+        int overrideCount;
+    };
+
+    SkFontArguments()
+            : fCollectionIndex(0)
+            , fVariationDesignPosition{nullptr, 0}
+            , fPalette{0, nullptr, 0}
+            , fHasPalette(false) {}
 
     /** Specify the index of the desired font.
      *
@@ -47,6 +69,21 @@ struct SkFontArguments {
         return *this;
     }
 
+    /** Specify a color palette to use, by its index into the font's CPAL table, and overrides
+     *  for entries of that palette. An index out of range selects the first palette. A clone
+     *  made with arguments that do not specify a palette keeps the palette of its original.
+     *
+     *  @param palette its overrides are not copied. They must remain valid for life of
+     *                 SkFontArguments.
+     */
+    SkFontArguments& setPalette(Palette palette) {
+        fPalette.index = palette.index;
+        fPalette.overrides = palette.overrides;
+        fPalette.overrideCount = palette.overrideCount;
+        fHasPalette = true;
+        return *this;
+    }
+
     int getCollectionIndex() const {
         return fCollectionIndex;
     }
@@ -54,9 +91,17 @@ struct SkFontArguments {
     VariationPosition getVariationDesignPosition() const {
         return fVariationDesignPosition;
     }
+
+    Palette getPalette() const { return fPalette; }
+
+    /** Returns true if setPalette() was called. */
+    bool hasPalette() const { return fHasPalette; }
+
 private:
     int fCollectionIndex;
     VariationPosition fVariationDesignPosition;
+    Palette fPalette;
+    bool fHasPalette;
 };
 
 #endif
@@ -73,6 +73,20 @@ public:
      */
     static void PurgeFontCache();
 
+    /**
+     *  Keep the glyphs of the font cache in directory, so that they can be reused by later
+     *  processes. Strikes are read from the directory when they are created and written to it
+     *  when they are purged, or when SaveFontCache() is called. Passing nullptr stops using the
+     *  directory. Returns false if the directory can not be used.
+     */
+    static bool SetFontCacheDirectory(const char directory[]);
+
+    /**
+     *  Write the glyphs which were added to the font cache since they were last read or written
+     *  to the font cache directory. Does nothing if there is no font cache directory.
+     */
+    static void SaveFontCache();
+
     /**
      *  This function returns the memory used for temporary images and other resources.
      */
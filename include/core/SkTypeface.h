@@ -409,6 +409,14 @@ protected:
 
     virtual bool onComputeBounds(SkRect*) const;
 
+    /** For each of the count glyphs which is a color glyph whose bounds are known without
+     *  scan converting it, e.g. from its COLRv1 ClipBox, sets found[i] and sets bounds[i] to
+     *  bounds at a text size of 1 which contain everything it draws. Other entries are left
+     *  alone. The default finds none.
+     */
+    virtual void onGetColorGlyphBounds(const SkGlyphID glyphs[], int count, SkRect bounds[],
+                                       bool found[]) const;
+
     virtual void* onGetCTFontRef() const { return nullptr; }
 
 private:
@@ -431,7 +439,7 @@ private:
 
     friend class SkFontPriv;       // GetDefaultTypeface
     friend class SkPaintPriv;      // GetDefaultTypeface
-    friend class SkFont;           // getGlyphToUnicodeMap
+    friend class SkFont;           // getGlyphToUnicodeMap, onGetColorGlyphBounds
 
 private:
     SkFontID            fUniqueID;
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTypeface_freetype_DEFINED
+#define SkTypeface_freetype_DEFINED
+
+#include "include/core/SkTypes.h"
+
+#include <cstddef>
+
+/**
+ *  Configures the pool of additional FT_Faces which lets scaler contexts of one FreeType
+ *  typeface rasterize on different threads at the same time, instead of taking turns on the
+ *  typeface's one face.
+ *
+ *  A scaler context, and so a strike, checks out a face when it is made and keeps it until it is
+ *  destroyed, because its FT_Size belongs to that face. Once a typeface has maxFacesPerTypeface
+ *  faces open, counting its own, or the pooled faces of all typefaces take byteLimit bytes,
+ *  further scaler contexts share the typeface's face and take turns on it. So
+ *  maxFacesPerTypeface should be one more than the number of strikes of one typeface which are
+ *  expected to rasterize at the same time, e.g. the number of sizes drawn on different threads.
+ *
+ *  Faces returned by destroyed scaler contexts stay open for reuse, unless the limits were
+ *  lowered below what is open. The default of one face per typeface disables the pool.
+ */
+SK_API void SkTypeface_SetFreeTypeFacePoolLimits(int maxFacesPerTypeface, size_t byteLimit);
+
+/** Returns the memory FreeType allocated for the pooled faces which are currently open. */
+SK_API size_t SkTypeface_GetFreeTypeFacePoolBytesUsed();
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTiledPicturePlayback_DEFINED
+#define SkTiledPicturePlayback_DEFINED
+
+#include "include/core/SkTypes.h"
+
+class SkExecutor;
+class SkMatrix;
+class SkPicture;
+class SkPixmap;
+class SkSurfaceProps;
+
+/**
+ *  Plays a picture back into raster pixels on several threads at once.
+ *
+ *  The pixels are split into square tiles, and each tile is drawn by its own task, through its
+ *  own canvas clipped to the tile. Every canvas draws straight into the shared pixels in the
+ *  same device coordinates, so dithering, shaders and layers come out as they would through
+ *  one canvas. Paths which cross the edge of a tile may rasterize a little differently, as
+ *  they do under any clip which cuts through them.
+ *
+ *  Pictures recorded with an SkRTreeFactory only replay the ops which touch each tile; without
+ *  one, every tile replays every op. The picture and the images it holds are shared by all the
+ *  tiles, never copied.
+ *
+ *  A saveLayer with a backdrop filter reads the pixels around its layer, which other tiles may
+ *  be drawing at the same time. Pictures which make one, directly or in the pictures and
+ *  drawables they draw, are drawn through one canvas on the calling thread instead.
+ */
+class SK_API SkTiledPicturePlayback {
+public:
+    static constexpr int kDefaultTileSize = 256;
+
+    /**
+     *  Draws the picture into dst, transformed by matrix (identity if nullptr), and returns once
+     *  every tile is drawn. The tiles run on executor; the calling thread may help draw them.
+     *  Returns false, drawing nothing, if dst is not a raster format SkCanvas can draw into.
+     */
+    static bool Draw(const SkPixmap& dst, const SkPicture* picture, const SkMatrix* matrix,
+                     SkExecutor& executor, int tileSize = kDefaultTileSize,
+                     const SkSurfaceProps* props = nullptr);
+};
+
+#endif
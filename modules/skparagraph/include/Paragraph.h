@@ -69,6 +69,10 @@ public:
     // Experimental API that allows fast way to update "immutable" paragraph
     virtual void updateTextAlign(TextAlign textAlign) = 0;
     virtual void updateText(size_t from, SkString text) = 0;
+    // Replaces the text in [from:to) with text (in the style of the text before it), keeping
+    // as much of the last layout as possible for the next one. Edits that would split
+    // a placeholder are ignored
+    virtual void replaceText(size_t from, size_t to, SkString text) = 0;
     virtual void updateFontSize(size_t from, size_t to, SkScalar fontSize) = 0;
     virtual void updateForegroundPaint(size_t from, size_t to, SkPaint paint) = 0;
     virtual void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) = 0;
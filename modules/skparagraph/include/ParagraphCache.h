@@ -2,9 +2,14 @@
 #ifndef ParagraphCache_DEFINED
 #define ParagraphCache_DEFINED
 
+#include "include/core/SkExecutor.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkScalar.h"
 #include "include/private/SkMutex.h"
 #include "src/core/SkLRUCache.h"
+#include <atomic>
 #include <functional>  // std::function
+#include <memory>
 
 #define PARAGRAPH_CACHE_STATS
 
@@ -21,12 +26,22 @@ enum InternalState {
   kDrawn = 7
 };
 
+class Paragraph;
 class ParagraphImpl;
 class ParagraphCacheKey;
 class ParagraphCacheValue;
 
 bool operator==(const ParagraphCacheKey& a, const ParagraphCacheKey& b);
 
+/**
+ *  Keeps the shaping results of recently laid out paragraphs. The cache is split into shards,
+ *  picked by the hash of a paragraph's key, each with a lock of its own, so that paragraphs laid
+ *  out on different threads rarely wait for each other. Keys are built and hashed, and cached
+ *  results are copied into paragraphs, outside of the locks.
+ *
+ *  The cache is bounded by the approximate number of bytes its entries hold, split evenly between
+ *  the shards; each shard evicts its least recently used entries when it goes over its share.
+ */
 class ParagraphCache {
 public:
     ParagraphCache();
@@ -37,41 +52,84 @@ public:
     bool updateParagraph(ParagraphImpl* paragraph);
     bool findParagraph(ParagraphImpl* paragraph);
 
+    // The default budget is kDefaultByteLimit. Lowering it evicts entries right away.
+    void setByteLimit(size_t bytes);
+    size_t byteLimit() const { return fByteLimit.load(std::memory_order_relaxed); }
+    size_t bytesUsed() const;
+
+    /**
+     *  Lays paragraph out at width on executor, so that its shaping results are in the cache by
+     *  the time a copy of it is laid out for real, e.g. before it is scrolled into view.
+     *  paragraph should be built with the FontCollection that owns this cache. It is deleted
+     *  once it has been laid out. executor must outlive the layout.
+     */
+    void prefill(std::unique_ptr<Paragraph> paragraph, SkScalar width,
+                 SkExecutor& executor = SkExecutor::GetDefault());
+    // Blocks until every paragraph passed to prefill() so far has been laid out, running tasks
+    // of executor meanwhile.
+    void waitForPrefill(SkExecutor& executor = SkExecutor::GetDefault());
+
+    struct ShardStats {
+        int    fRequests;
+        int    fMisses;
+        int    fEvictions;
+        int    fCount;
+        size_t fBytesUsed;
+    };
+    static constexpr int kShardCount = 8;
+    ShardStats shardStats(int shard) const;
+
     // For testing
     void setChecker(std::function<void(ParagraphImpl* impl, const char*, bool)> checker) {
         fChecker = std::move(checker);
     }
     void printStatistics();
-    void turnOn(bool value) { fCacheIsOn = value; }
-    int count() { return fLRUCacheMap.count(); }
+    void turnOn(bool value) { fCacheIsOn.store(value, std::memory_order_relaxed); }
+    int count();
 
     bool isPossiblyTextEditing(ParagraphImpl* paragraph);
 
+    static constexpr size_t kDefaultByteLimit = 8 * 1024 * 1024;
+
  private:
 
     struct Entry;
-    void updateFrom(const ParagraphImpl* paragraph, Entry* entry);
+    struct Shard;
+    class Prefill;
     void updateTo(ParagraphImpl* paragraph, const Entry* entry);
+    Shard& shardFor(uint32_t hash) { return fShards[hash % kShardCount]; }
+    void purgeAsNeeded(Shard* shard, size_t limit) SK_REQUIRES(shard->fMutex);
 
-     mutable SkMutex fParagraphMutex;
-     std::function<void(ParagraphImpl* impl, const char*, bool)> fChecker;
-
-    static const int kMaxEntries = 128;
+    std::function<void(ParagraphImpl* impl, const char*, bool)> fChecker;
 
     struct KeyHash {
-        uint32_t mix(uint32_t hash, uint32_t data) const;
         uint32_t operator()(const ParagraphCacheKey& key) const;
     };
 
-    SkLRUCache<ParagraphCacheKey, std::unique_ptr<Entry>, KeyHash> fLRUCacheMap;
-    bool fCacheIsOn;
-    ParagraphCacheValue* fLastCachedValue;
+    struct Shard {
+        Shard();
+        ~Shard();
 
+        SkMutex fMutex;
+        SkLRUCache<ParagraphCacheKey, sk_sp<Entry>, KeyHash> fLRUCacheMap SK_GUARDED_BY(fMutex);
+        size_t fBytesUsed SK_GUARDED_BY(fMutex) = 0;
+        int fEvictions SK_GUARDED_BY(fMutex) = 0;
 #ifdef PARAGRAPH_CACHE_STATS
-    int fTotalRequests;
-    int fCacheMisses;
-    int fHashMisses; // cache hit but hash table missed
+        std::atomic<int> fTotalRequests{0};
+        std::atomic<int> fCacheMisses{0};
 #endif
+    };
+
+    std::unique_ptr<Shard[]> fShards;
+    std::atomic<size_t> fByteLimit{kDefaultByteLimit};
+    std::atomic<bool> fCacheIsOn{true};
+
+    // The last paragraph added, used to spot text that is being edited.
+    SkMutex fLastCachedMutex;
+    sk_sp<Entry> fLastCachedValue SK_GUARDED_BY(fLastCachedMutex);
+
+    SkMutex fPrefillMutex;
+    sk_sp<Prefill> fPrefill SK_GUARDED_BY(fPrefillMutex);
 };
 
 }  // namespace textlayout
@@ -239,6 +239,48 @@ void OneLineShaper::finish(const Block& block, SkScalar height, SkScalar& advanc
         SkDEBUGF("Last range mismatch: %zu - %zu\n", lastTextEnd, blockText.end);
         SkASSERT(false);
     }
+
+    // Everything is in fRuns now; the next block should not have to skip these
+    fResolvedBlocks.clear();
+}
+
+bool OneLineShaper::reuseShapedBlock(const Block& block, uint8_t bidiLevel, SkScalar& advanceX) {
+    auto& reusable = fParagraph->fReusableBlocks;
+
+    // Blocks come in text order, and so do the shaped blocks kept by the edit
+    while (fNextReusableBlock < reusable.size() &&
+           reusable[fNextReusableBlock].fText.start < block.fRange.start) {
+        ++fNextReusableBlock;
+    }
+    if (fNextReusableBlock == reusable.size() ||
+        !(reusable[fNextReusableBlock].fText == block.fRange) ||
+        reusable[fNextReusableBlock].fBidiLevel != bidiLevel) {
+        fReusingPrefix = false;
+        return false;
+    }
+
+    auto& shaped = fParagraph->fShapedBlocks.push_back(reusable[fNextReusableBlock++]);
+    auto shift = advanceX - shaped.fAdvanceX;
+    auto firstRun = shaped.fFirstRun;
+    shaped.fAdvanceX = advanceX;
+    shaped.fFirstRun = fParagraph->fRuns.size();
+    for (size_t i = firstRun; i < firstRun + shaped.fRunCount; ++i) {
+        auto& run = fParagraph->fRuns.emplace_back(std::move(fParagraph->fReusableRuns[i]));
+        run.fOwner = fParagraph;
+        run.fIndex = fParagraph->fRuns.size() - 1;
+        run.fOffset.fX += shift;
+        for (auto& position : run.fPositions) {
+            position.fX += shift;
+        }
+        fParagraph->fFontSwitches.emplace_back(run.fTextRange.start, run.fFont);
+    }
+    fUnresolvedGlyphs += shaped.fUnresolvedGlyphs;
+    advanceX += shaped.fWidth;
+
+    if (fReusingPrefix) {
+        fParagraph->fReusedTextEnd = block.fRange.end;
+    }
+    return true;
 }
 
 // Make it [left:right) regardless of a text direction
@@ -570,6 +612,20 @@ bool OneLineShaper::iterateThroughShapingRegions(const ShapeVisitor& shape) {
                 auto blockRange = fParagraph->findAllBlocks(textRange);
                 SkSpan<Block> styleSpan(fParagraph->blocks(blockRange));
 
+                // An edited paragraph is shaped line by line so that the lines an edit
+                // did not touch can keep their runs (see ParagraphImpl::replaceText)
+                if (fParagraph->fEdited) {
+                    for (auto index = start + 1; index < end; ++index) {
+                        if (fParagraph->codeUnitHasProperty(index, CodeUnitFlags::kHardLineBreakBefore)) {
+                            if (!shape(TextRange(start, index), styleSpan, advanceX, start, bidiRegion.level)) {
+                                return false;
+                            }
+                            start = index;
+                        }
+                    }
+                    textRange = TextRange(start, end);
+                }
+
                 // Shape the text between placeholders
                 if (!shape(textRange, styleSpan, advanceX, start, bidiRegion.level)) {
                     return false;
@@ -628,17 +684,26 @@ bool OneLineShaper::shape() {
             [this, limitlessWidth]
             (TextRange textRange, SkSpan<Block> styleSpan, SkScalar& advanceX, TextIndex textStart, uint8_t defaultBidiLevel) {
 
-        // Set up the shaper and shape the next
-        auto shaper = SkShaper::MakeShapeDontWrapOrReorder();
-        if (shaper == nullptr) {
-            // For instance, loadICU does not work. We have to stop the process
-            return false;
+        // Set up the shaper (once for all the regions) and shape the next
+        if (fShaper == nullptr) {
+            fShaper = SkShaper::MakeShapeDontWrapOrReorder();
+            if (fShaper == nullptr) {
+                // For instance, loadICU does not work. We have to stop the process
+                return false;
+            }
         }
+        auto& shaper = fShaper;
 
         iterateThroughFontStyles(textRange, styleSpan,
                 [this, &shaper, defaultBidiLevel, limitlessWidth, &advanceX]
                 (Block block, SkTArray<SkShaper::Feature> features) {
+            if (fParagraph->fEdited && this->reuseShapedBlock(block, defaultBidiLevel, advanceX)) {
+                return;
+            }
             auto blockSpan = SkSpan<Block>(&block, 1);
+            auto blockAdvanceX = advanceX;
+            auto blockFirstRun = fParagraph->fRuns.size();
+            auto blockUnresolvedGlyphs = fUnresolvedGlyphs;
 
             // Start from the beginning (hoping that it's a simple case one block - one run)
             fHeight = block.fStyle.getHeightOverride() ? block.fStyle.getHeight() : 0;
@@ -707,6 +772,15 @@ bool OneLineShaper::shape() {
             });
 
             this->finish(block, fHeight, advanceX);
+
+            fParagraph->fShapedBlocks.push_back({block.fRange,
+                                                 defaultBidiLevel,
+                                                 !features.empty(),
+                                                 blockAdvanceX,
+                                                 advanceX - blockAdvanceX,
+                                                 blockFirstRun,
+                                                 fParagraph->fRuns.size() - blockFirstRun,
+                                                 fUnresolvedGlyphs - blockUnresolvedGlyphs});
         });
 
         return true;
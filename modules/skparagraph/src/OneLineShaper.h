@@ -21,7 +21,9 @@ public:
         , fUseHalfLeading(false)
         , fAdvance(SkPoint::Make(0.0f, 0.0f))
         , fUnresolvedGlyphs(0)
-        , fUniqueRunId(paragraph->fRuns.size()){ }
+        , fUniqueRunId(paragraph->fRuns.size())
+        , fNextReusableBlock(0)
+        , fReusingPrefix(true) { }
 
     bool shape();
 
@@ -72,6 +74,9 @@ private:
 #endif
     void finish(const Block& block, SkScalar height, SkScalar& advanceX);
 
+    // Takes the runs of block from the last shaping of an edited paragraph, if it has them
+    bool reuseShapedBlock(const Block& block, uint8_t bidiLevel, SkScalar& advanceX);
+
     void beginLine() override {}
     void runInfo(const RunInfo&) override {}
     void commitRunInfo() override {}
@@ -107,6 +112,9 @@ private:
     SkVector fAdvance;
     size_t fUnresolvedGlyphs;
     size_t fUniqueRunId;
+    std::unique_ptr<SkShaper> fShaper;
+    size_t fNextReusableBlock;
+    bool fReusingPrefix;
 
     // TODO: Something that is not thead-safe since we don't need it
     std::shared_ptr<Run> fCurrentRun;
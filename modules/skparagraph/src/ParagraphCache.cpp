@@ -1,6 +1,8 @@
 // Copyright 2019 Google LLC.
+#include <climits>
 #include <memory>
 
+#include "include/core/SkExecutor.h"
 #include "modules/skparagraph/include/ParagraphCache.h"
 #include "modules/skparagraph/src/ParagraphImpl.h"
 
@@ -29,12 +31,19 @@ public:
         : fText(paragraph->fText.c_str(), paragraph->fText.size())
         , fPlaceholders(paragraph->fPlaceholders)
         , fTextStyles(paragraph->fTextStyles)
-        , fParagraphStyle(paragraph->paragraphStyle()) { }
+        , fParagraphStyle(paragraph->paragraphStyle())
+        , fHash(this->computeHash()) { }
 
     SkString fText;
     SkTArray<Placeholder, true> fPlaceholders;
     SkTArray<Block, true> fTextStyles;
     ParagraphStyle fParagraphStyle;
+    // Computed once, before any shard is locked.
+    uint32_t fHash;
+
+private:
+    static uint32_t mix(uint32_t hash, uint32_t data);
+    uint32_t computeHash() const;
 };
 
 class ParagraphCacheValue {
@@ -48,6 +57,28 @@ public:
         , fUTF8IndexForUTF16Index(paragraph->fUTF8IndexForUTF16Index)
         , fUTF16IndexForUTF8Index(paragraph->fUTF16IndexForUTF8Index) { }
 
+    // Approximate number of bytes held by the value, which is what the cache budgets.
+    size_t bytesUsed() const {
+        size_t bytes = sizeof(ParagraphCacheValue) + fKey.fText.size() +
+                       fKey.fPlaceholders.size() * sizeof(Placeholder) +
+                       fKey.fTextStyles.size() * sizeof(Block);
+        for (const Run& run : fRuns) {
+            // The glyph arrays of a run are part of sizeof(Run) up to kPreallocatedGlyphs, and
+            // only allocate beyond that.
+            bytes += sizeof(Run);
+            if (run.size() > Run::kPreallocatedGlyphs) {
+                bytes += run.size() * (sizeof(SkGlyphID) + 2 * sizeof(SkPoint) + sizeof(uint32_t) +
+                                       sizeof(SkRect) + sizeof(SkScalar));
+            }
+        }
+        bytes += fCodeUnitProperties.size() * sizeof(CodeUnitFlags) +
+                 fWords.size() * sizeof(size_t) +
+                 fBidiRegions.size() * sizeof(SkUnicode::BidiRegion) +
+                 fUTF8IndexForUTF16Index.size() * sizeof(TextIndex) +
+                 fUTF16IndexForUTF8Index.size() * sizeof(size_t);
+        return bytes;
+    }
+
     // Input == key
     ParagraphCacheKey fKey;
 
@@ -61,16 +92,16 @@ public:
     SkTArray<size_t, true> fUTF16IndexForUTF8Index;
 };
 
-uint32_t ParagraphCache::KeyHash::mix(uint32_t hash, uint32_t data) const {
+uint32_t ParagraphCacheKey::mix(uint32_t hash, uint32_t data) {
     hash += data;
     hash += (hash << 10);
     hash ^= (hash >> 6);
     return hash;
 }
 
-uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const {
+uint32_t ParagraphCacheKey::computeHash() const {
     uint32_t hash = 0;
-    for (auto& ph : key.fPlaceholders) {
+    for (auto& ph : fPlaceholders) {
         if (ph.fRange.width() == 0) {
             continue;
         }
@@ -85,7 +116,7 @@ uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const
         }
     }
 
-    for (auto& ts : key.fTextStyles) {
+    for (auto& ts : fTextStyles) {
         if (ts.fStyle.isPlaceholder()) {
             continue;
         }
@@ -105,10 +136,10 @@ uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const
         hash = mix(hash, SkGoodHash()(ts.fRange));
     }
 
-    hash = mix(hash, SkGoodHash()(relax(key.fParagraphStyle.getHeight())));
-    hash = mix(hash, SkGoodHash()(key.fParagraphStyle.getTextDirection()));
+    hash = mix(hash, SkGoodHash()(relax(fParagraphStyle.getHeight())));
+    hash = mix(hash, SkGoodHash()(fParagraphStyle.getTextDirection()));
 
-    auto& strutStyle = key.fParagraphStyle.getStrutStyle();
+    auto& strutStyle = fParagraphStyle.getStrutStyle();
     if (strutStyle.getStrutEnabled()) {
         hash = mix(hash, SkGoodHash()(relax(strutStyle.getHeight())));
         hash = mix(hash, SkGoodHash()(relax(strutStyle.getLeading())));
@@ -121,11 +152,18 @@ uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const
         }
     }
 
-    hash = mix(hash, SkGoodHash()(key.fText));
+    hash = mix(hash, SkGoodHash()(fText));
     return hash;
 }
 
+uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const {
+    return key.fHash;
+}
+
 bool operator==(const ParagraphCacheKey& a, const ParagraphCacheKey& b) {
+    if (a.fHash != b.fHash) {
+        return false;
+    }
     if (a.fText.size() != b.fText.size()) {
         return false;
     }
@@ -187,22 +225,27 @@ bool operator==(const ParagraphCacheKey& a, const ParagraphCacheKey& b) {
     return true;
 }
 
-struct ParagraphCache::Entry {
+struct ParagraphCache::Entry : public SkNVRefCnt<Entry> {
 
-    Entry(ParagraphCacheValue* value) : fValue(value) {}
+    Entry(ParagraphCacheValue* value) : fValue(value), fBytesUsed(value->bytesUsed()) {}
     std::unique_ptr<ParagraphCacheValue> fValue;
+    const size_t fBytesUsed;
+};
+
+ParagraphCache::Shard::Shard() : fLRUCacheMap(INT_MAX) { }
+ParagraphCache::Shard::~Shard() { }
+
+// Counts the prefills in flight. Tasks hold a ref, so that a cache which is destroyed by the
+// last of its prefilled paragraphs never has to wait for the task doing so.
+class ParagraphCache::Prefill : public SkNVRefCnt<Prefill> {
+public:
+    std::atomic<int> fPending{0};
 };
 
 ParagraphCache::ParagraphCache()
     : fChecker([](ParagraphImpl* impl, const char*, bool){ })
-    , fLRUCacheMap(kMaxEntries)
-    , fCacheIsOn(true)
-    , fLastCachedValue(nullptr)
-#ifdef PARAGRAPH_CACHE_STATS
-    , fTotalRequests(0)
-    , fCacheMisses(0)
-    , fHashMisses(0)
-#endif
+    , fShards(new Shard[kShardCount])
+    , fPrefill(sk_make_sp<Prefill>())
 { }
 
 ParagraphCache::~ParagraphCache() { }
@@ -223,89 +266,209 @@ void ParagraphCache::updateTo(ParagraphImpl* paragraph, const Entry* entry) {
 
 void ParagraphCache::printStatistics() {
     SkDebugf("--- Paragraph Cache ---\n");
-    SkDebugf("Total requests: %d\n", fTotalRequests);
-    SkDebugf("Cache misses: %d\n", fCacheMisses);
-    SkDebugf("Cache miss %%: %f\n", (fTotalRequests > 0) ? 100.f * fCacheMisses / fTotalRequests : 0.f);
-    int cacheHits = fTotalRequests - fCacheMisses;
-    SkDebugf("Hash miss %%: %f\n", (cacheHits > 0) ? 100.f * fHashMisses / cacheHits : 0.f);
+    int totalRequests = 0;
+    int cacheMisses = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        ShardStats stats = this->shardStats(i);
+        SkDebugf("Shard %d: %d requests, %d misses, %d evictions, %d entries, %zu bytes\n",
+                 i, stats.fRequests, stats.fMisses, stats.fEvictions, stats.fCount,
+                 stats.fBytesUsed);
+        totalRequests += stats.fRequests;
+        cacheMisses += stats.fMisses;
+    }
+    SkDebugf("Total requests: %d\n", totalRequests);
+    SkDebugf("Cache misses: %d\n", cacheMisses);
+    SkDebugf("Cache miss %%: %f\n", (totalRequests > 0) ? 100.f * cacheMisses / totalRequests : 0.f);
     SkDebugf("---------------------\n");
 }
 
+ParagraphCache::ShardStats ParagraphCache::shardStats(int index) const {
+    SkASSERT(0 <= index && index < kShardCount);
+    Shard& shard = fShards[index];
+    ShardStats stats = {0, 0, 0, 0, 0};
+#ifdef PARAGRAPH_CACHE_STATS
+    stats.fRequests = shard.fTotalRequests.load(std::memory_order_relaxed);
+    stats.fMisses = shard.fCacheMisses.load(std::memory_order_relaxed);
+#endif
+    SkAutoMutexExclusive lock(shard.fMutex);
+    stats.fEvictions = shard.fEvictions;
+    stats.fCount = shard.fLRUCacheMap.count();
+    stats.fBytesUsed = shard.fBytesUsed;
+    return stats;
+}
+
+int ParagraphCache::count() {
+    int count = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        count += fShards[i].fLRUCacheMap.count();
+    }
+    return count;
+}
+
+size_t ParagraphCache::bytesUsed() const {
+    size_t bytes = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        bytes += fShards[i].fBytesUsed;
+    }
+    return bytes;
+}
+
+void ParagraphCache::setByteLimit(size_t bytes) {
+    fByteLimit.store(bytes, std::memory_order_relaxed);
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        this->purgeAsNeeded(&fShards[i], bytes / kShardCount);
+    }
+}
+
+void ParagraphCache::purgeAsNeeded(Shard* shard, size_t limit) {
+    while (shard->fBytesUsed > limit && shard->fLRUCacheMap.count() > 0) {
+        sk_sp<Entry> evicted = shard->fLRUCacheMap.removeLeastRecentlyUsed();
+        shard->fBytesUsed -= evicted->fBytesUsed;
+        shard->fEvictions += 1;
+    }
+}
+
 void ParagraphCache::abandon() {
     this->reset();
 }
 
 void ParagraphCache::reset() {
-    SkAutoMutexExclusive lock(fParagraphMutex);
+    for (int i = 0; i < kShardCount; ++i) {
+        Shard& shard = fShards[i];
+        SkAutoMutexExclusive lock(shard.fMutex);
 #ifdef PARAGRAPH_CACHE_STATS
-    fTotalRequests = 0;
-    fCacheMisses = 0;
-    fHashMisses = 0;
+        shard.fTotalRequests = 0;
+        shard.fCacheMisses = 0;
 #endif
-    fLRUCacheMap.reset();
+        shard.fLRUCacheMap.reset();
+        shard.fBytesUsed = 0;
+        shard.fEvictions = 0;
+    }
+    SkAutoMutexExclusive lock(fLastCachedMutex);
     fLastCachedValue = nullptr;
 }
 
 bool ParagraphCache::findParagraph(ParagraphImpl* paragraph) {
-    if (!fCacheIsOn) {
+    if (!fCacheIsOn.load(std::memory_order_relaxed)) {
         return false;
     }
+    ParagraphCacheKey key(paragraph);
+    Shard& shard = this->shardFor(key.fHash);
 #ifdef PARAGRAPH_CACHE_STATS
-    ++fTotalRequests;
+    shard.fTotalRequests.fetch_add(1, std::memory_order_relaxed);
 #endif
-    SkAutoMutexExclusive lock(fParagraphMutex);
-    ParagraphCacheKey key(paragraph);
-    std::unique_ptr<Entry>* entry = fLRUCacheMap.find(key);
+    sk_sp<Entry> entry;
+    {
+        SkAutoMutexExclusive lock(shard.fMutex);
+        if (sk_sp<Entry>* found = shard.fLRUCacheMap.find(key)) {
+            entry = *found;
+        }
+    }
 
     if (!entry) {
         // We have a cache miss
 #ifdef PARAGRAPH_CACHE_STATS
-        ++fCacheMisses;
+        shard.fCacheMisses.fetch_add(1, std::memory_order_relaxed);
 #endif
         fChecker(paragraph, "missingParagraph", true);
         return false;
     }
-    updateTo(paragraph, entry->get());
+    // Entries are immutable, so they can be copied from while other threads use the shard.
+    updateTo(paragraph, entry.get());
     fChecker(paragraph, "foundParagraph", true);
     return true;
 }
 
 bool ParagraphCache::updateParagraph(ParagraphImpl* paragraph) {
-    if (!fCacheIsOn) {
+    if (!fCacheIsOn.load(std::memory_order_relaxed)) {
         return false;
     }
+    ParagraphCacheKey key(paragraph);
+    Shard& shard = this->shardFor(key.fHash);
 #ifdef PARAGRAPH_CACHE_STATS
-    ++fTotalRequests;
+    shard.fTotalRequests.fetch_add(1, std::memory_order_relaxed);
 #endif
-    SkAutoMutexExclusive lock(fParagraphMutex);
-
-    ParagraphCacheKey key(paragraph);
-    std::unique_ptr<Entry>* entry = fLRUCacheMap.find(key);
-    if (!entry) {
-        // isTooMuchMemoryWasted(paragraph) not needed for now
-        if (isPossiblyTextEditing(paragraph)) {
-            // Skip this paragraph
+    {
+        SkAutoMutexExclusive lock(shard.fMutex);
+        if (shard.fLRUCacheMap.find(key)) {
+            // We do not have to update the paragraph
             return false;
         }
-        ParagraphCacheValue* value = new ParagraphCacheValue(paragraph);
-        fLRUCacheMap.insert(key, std::make_unique<Entry>(value));
-        fChecker(paragraph, "addedParagraph", true);
-        fLastCachedValue = value;
-        return true;
-    } else {
-        // We do not have to update the paragraph
+    }
+    // isTooMuchMemoryWasted(paragraph) not needed for now
+    if (isPossiblyTextEditing(paragraph)) {
+        // Skip this paragraph
         return false;
     }
+
+    // Copy the results before taking the lock; another thread may add the same paragraph
+    // meanwhile, in which case ours is dropped.
+    auto entry = sk_make_sp<Entry>(new ParagraphCacheValue(paragraph));
+    {
+        SkAutoMutexExclusive lock(shard.fMutex);
+        if (shard.fLRUCacheMap.find(key)) {
+            return false;
+        }
+        shard.fLRUCacheMap.insert(std::move(key), entry);
+        shard.fBytesUsed += entry->fBytesUsed;
+        this->purgeAsNeeded(&shard, this->byteLimit() / kShardCount);
+    }
+    fChecker(paragraph, "addedParagraph", true);
+    SkAutoMutexExclusive lock(fLastCachedMutex);
+    fLastCachedValue = std::move(entry);
+    return true;
+}
+
+void ParagraphCache::prefill(std::unique_ptr<Paragraph> paragraph, SkScalar width,
+                             SkExecutor& executor) {
+    if (!paragraph) {
+        return;
+    }
+    sk_sp<Prefill> prefill;
+    {
+        SkAutoMutexExclusive lock(fPrefillMutex);
+        prefill = fPrefill;
+    }
+    prefill->fPending.fetch_add(1, std::memory_order_relaxed);
+    // SkExecutor takes a std::function, which must be copyable.
+    Paragraph* raw = paragraph.release();
+    executor.add([prefill, raw, width] {
+        std::unique_ptr<Paragraph> paragraph(raw);
+        paragraph->layout(width);
+        // This may drop the last ref to the FontCollection owning the cache.
+        paragraph.reset();
+        prefill->fPending.fetch_add(-1, std::memory_order_release);
+    });
+}
+
+void ParagraphCache::waitForPrefill(SkExecutor& executor) {
+    sk_sp<Prefill> prefill;
+    {
+        SkAutoMutexExclusive lock(fPrefillMutex);
+        prefill = fPrefill;
+    }
+    // Like SkTaskGroup::wait(), help the executor rather than block one of its threads.
+    while (prefill->fPending.load(std::memory_order_acquire) > 0) {
+        executor.borrow();
+    }
 }
 
 // Special situation: (very) long paragraph that is close to the last formatted paragraph
 #define NOCACHE_PREFIX_LENGTH 40
 bool ParagraphCache::isPossiblyTextEditing(ParagraphImpl* paragraph) {
-    if (fLastCachedValue == nullptr) {
+    sk_sp<Entry> last;
+    {
+        SkAutoMutexExclusive lock(fLastCachedMutex);
+        last = fLastCachedValue;
+    }
+    if (last == nullptr) {
         return false;
     }
 
-    auto& lastText = fLastCachedValue->fKey.fText;
+    auto& lastText = last->fValue->fKey.fText;
     auto& text = paragraph->fText;
 
     if ((lastText.size() < NOCACHE_PREFIX_LENGTH) || (text.size() < NOCACHE_PREFIX_LENGTH)) {
@@ -77,6 +77,9 @@ ParagraphImpl::ParagraphImpl(const SkString& text,
         , fStrutMetrics(false)
         , fOldWidth(0)
         , fOldHeight(0)
+        , fEdited(false)
+        , fReusableLinesWidth(0)
+        , fReusedTextEnd(0)
         , fUnicode(std::move(unicode))
 {
     SkASSERT(fUnicode);
@@ -122,8 +125,12 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
         fWidth = floorWidth;
         fState = kMarked;
     } else if (fState >= kLineBroken && fOldWidth != floorWidth) {
-        // We can use the results from SkShaper but have to do EVERYTHING ELSE again
-        fState = kShaped;
+        // Neither the runs nor the clusters (nor their letter and word spacing) depend on
+        // the width; we only have to break the text into lines again
+        for (auto& run : fRuns) {
+            run.resetJustificationShifts();
+        }
+        fState = kMarked;
     } else {
         // Nothing changed case: we can reuse the data from the last layout
     }
@@ -137,6 +144,7 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
         this->fUTF16IndexForUTF8Index.reset();
         this->fRuns.reset();
         if (!this->shapeTextIntoEndlessLine()) {
+            this->forgetReusableLayout();
             this->resetContext();
             // TODO: merge the two next calls - they always come together
             this->resolveStrut();
@@ -179,7 +187,8 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
         this->resolveStrut();
         this->computeEmptyMetrics();
         this->fLines.reset();
-        this->breakShapedTextIntoLines(floorWidth);
+        auto keptLines = this->restoreReusableLines(floorWidth);
+        this->breakShapedTextIntoLines(floorWidth, keptLines);
         fState = kLineBroken;
     }
 
@@ -479,8 +488,12 @@ bool ParagraphImpl::shapeTextIntoEndlessLine() {
         return false;
     }
 
+    fShapedBlocks.reset();
+    fReusedTextEnd = 0;
+
     // Check the font-resolved text against the cache
-    if (fFontCollection->getParagraphCache()->findParagraph(this)) {
+    // (an edited paragraph is shaped differently and keeps what it can by itself)
+    if (!fEdited && fFontCollection->getParagraphCache()->findParagraph(this)) {
         return true;
     }
 
@@ -494,6 +507,10 @@ bool ParagraphImpl::shapeTextIntoEndlessLine() {
     auto result = oneLineShaper.shape();
     fUnresolvedGlyphs = oneLineShaper.unresolvedGlyphs();
 
+    // Whatever the edit left and the shaper did not take is useless now
+    fReusableBlocks.reset();
+    fReusableRuns.reset();
+
     // It's possible that one grapheme includes few runs; we cannot handle it
     // so we break graphemes by the runs instead
     // It's not the ideal solution and has to be revisited later
@@ -503,14 +520,27 @@ bool ParagraphImpl::shapeTextIntoEndlessLine() {
 
     if (!result) {
         return false;
-    } else {
+    } else if (!fEdited) {
         // Add the paragraph to the cache
         fFontCollection->getParagraphCache()->updateParagraph(this);
-        return true;
     }
+    return true;
 }
 
-void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth) {
+void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth, size_t keptLines) {
+    SkASSERT(keptLines == fLines.size() && keptLines <= fLineIntrinsicWidths.size());
+    fLineIntrinsicWidths.pop_back_n(fLineIntrinsicWidths.size() - keptLines);
+
+    TextWrapper::KeptLines kept;
+    if (keptLines > 0) {
+        const auto& last = fLines.back();
+        kept.fCount = keptLines;
+        kept.fNextCluster = last.clustersWithSpaces().end;
+        kept.fHeight = last.offset().fY + last.height();
+        kept.fMinIntrinsicWidth = fLineIntrinsicWidths.back().fMin;
+        kept.fMaxIntrinsicWidth = fLineIntrinsicWidths.back().fMax;
+    }
+
     TextWrapper textWrapper;
     textWrapper.breakTextIntoLines(
             this,
@@ -534,7 +564,8 @@ void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth) {
                 }
 
                 fLongestLine = std::max(fLongestLine, nearlyZero(advance.fX) ? widthWithSpaces : advance.fX);
-            });
+            },
+            keptLines > 0 ? &kept : nullptr);
 
     fHeight = textWrapper.height();
     fWidth = maxWidth;
@@ -956,11 +987,174 @@ SkString ParagraphImpl::getEllipsis() const {
 void ParagraphImpl::updateText(size_t from, SkString text) {
   fText.remove(from, from + text.size());
   fText.insert(from, text);
+  this->forgetReusableLayout();
   fState = kUnknown;
   fOldWidth = 0;
   fOldHeight = 0;
 }
 
+void ParagraphImpl::replaceText(size_t from, size_t to, SkString text) {
+    SkASSERT(from <= to && to <= fText.size());
+    for (auto& placeholder : fPlaceholders) {
+        auto range = placeholder.fRange;
+        if (from == to ? range.start < from && from < range.end
+                       : range.start < to && from < range.end) {
+            SkDEBUGF("Cannot replace [%zu:%zu) inside a placeholder\n", from, to);
+            return;
+        }
+    }
+
+    // The inserted text takes the style of the text before it (or after it, at the start)
+    auto receiver = fTextStyles.size();
+    for (size_t i = 0; i < fTextStyles.size(); ++i) {
+        auto& block = fTextStyles[i];
+        if (!block.fStyle.isPlaceholder() && block.fRange.start < from && from <= block.fRange.end) {
+            receiver = i;
+            break;
+        }
+    }
+    for (size_t i = 0; receiver == fTextStyles.size() && i < fTextStyles.size(); ++i) {
+        if (!fTextStyles[i].fStyle.isPlaceholder() && fTextStyles[i].fRange.end > from) {
+            receiver = i;
+        }
+    }
+    for (size_t i = fTextStyles.size(); receiver == fTextStyles.size() && i > 0; --i) {
+        if (!fTextStyles[i - 1].fStyle.isPlaceholder()) {
+            receiver = i - 1;
+        }
+    }
+    if (receiver == fTextStyles.size()) {
+        SkDEBUGF("No text style for the replacement\n");
+        return;
+    }
+
+    // Indexes after the replaced text move with the end of it
+    auto move = [from, to, size = text.size()](TextIndex index) {
+        SkASSERT(index >= to);
+        return index - to + from + size;
+    };
+    auto sameSize = to - from == text.size();
+
+    // Keep the runs of all the blocks outside of the replaced text, as they were shaped
+    // (before any spacing or justification); the blocks with font features only if they stay
+    // where they are, since the features are bound to text positions
+    auto shaped = fState >= kShaped;
+    auto blocks = shaped ? std::move(fShapedBlocks) : std::move(fReusableBlocks);
+    auto runs = shaped ? std::move(fRuns) : std::move(fReusableRuns);
+    fShapedBlocks.reset();
+    fReusableBlocks.reset();
+    fRuns.reset();
+    fReusableRuns.reset();
+    for (auto& block : blocks) {
+        auto before = block.fText.end <= from;
+        auto after = block.fText.start >= to && (sameSize || !block.fHasFeatures);
+        if (!before && !after) {
+            continue;
+        }
+        auto& kept = fReusableBlocks.push_back(block);
+        kept.fFirstRun = fReusableRuns.size();
+        if (!before) {
+            kept.fText = TextRange(move(block.fText.start), move(block.fText.end));
+        }
+        for (size_t i = block.fFirstRun; i < block.fFirstRun + block.fRunCount; ++i) {
+            auto& run = fReusableRuns.emplace_back(std::move(runs[i]));
+            run.resetJustificationShifts();
+            run.resetShifts();
+            run.fAdvance.fX = run.posX(run.size()) - run.fOffset.fX;
+            run.fClusterRange = EMPTY_CLUSTERS;
+            if (!before) {
+                run.fTextRange = TextRange(move(run.fTextRange.start), move(run.fTextRange.end));
+                run.fClusterStart = move(run.fClusterStart);
+            }
+        }
+    }
+
+    // Keep the lines up to the last hard line break before the replaced text
+    // (but never the last line, the replacement may continue it)
+    if (fState >= kLineBroken && this->canKeepLines()) {
+        size_t keptLines = 0;
+        for (size_t i = 0; i + 1 < fLines.size() && fLines[i].textWithNewlines().end <= from; ++i) {
+            auto clusters = fLines[i].clustersWithSpaces();
+            if (clusters.width() > 0 && fClusters[clusters.end - 1].isHardBreak()) {
+                keptLines = i + 1;
+            }
+        }
+        fReusableLines.reset();
+        for (size_t i = 0; i < keptLines; ++i) {
+            fReusableLines.emplace_back(std::move(fLines[i]));
+        }
+        fReusableLinesWidth = fOldWidth;
+    } else if (!fReusableLines.empty() && fReusableLines.back().textWithNewlines().end > from) {
+        // Lines kept by an edit that is not laid out yet; we cannot tell which of them end
+        // with a hard line break anymore
+        fReusableLines.reset();
+    }
+    fLines.reset();
+    fClusters.reset();
+    fPicture = nullptr;
+
+    // Move the styles and the placeholders; they keep their order (and their indexes)
+    for (size_t i = receiver; i < fTextStyles.size(); ++i) {
+        auto& range = fTextStyles[i].fRange;
+        range.start = i == receiver ? std::min(range.start, from)
+                                    : move(std::max(range.start, to));
+        range.end = move(std::max(range.end, to));
+    }
+    TextIndex textBefore = 0;
+    for (auto& placeholder : fPlaceholders) {
+        if (placeholder.fRange.start >= to) {
+            placeholder.fRange = TextRange(move(placeholder.fRange.start),
+                                           move(placeholder.fRange.end));
+        }
+        placeholder.fTextBefore = TextRange(textBefore, placeholder.fRange.start);
+        textBefore = placeholder.fRange.end;
+    }
+
+    fText.remove(from, to - from);
+    fText.insert(from, text);
+    fEdited = true;
+    fState = kUnknown;
+    fOldWidth = 0;
+    fOldHeight = 0;
+}
+
+bool ParagraphImpl::canKeepLines() const {
+    // Justification changes the lines themselves, limits and ellipsis depend on the lines
+    // before, and placeholders are not recorded as shaped blocks
+    return fParagraphStyle.unlimited_lines() && !fParagraphStyle.ellipsized() &&
+           fParagraphStyle.effective_align() != TextAlign::kJustify &&
+           fPlaceholders.size() <= 1;
+}
+
+size_t ParagraphImpl::restoreReusableLines(SkScalar maxWidth) {
+    auto count = fReusableLines.size();
+    // The lines only fit the same width, if all their runs were reused
+    // and there is some text left to break after them
+    if (count == 0 || maxWidth != fReusableLinesWidth || !this->canKeepLines() ||
+        count > fLineIntrinsicWidths.size() ||
+        fReusableLines.back().textWithNewlines().end > fReusedTextEnd ||
+        fReusableLines.back().clustersWithSpaces().end + 1 >= fClusters.size()) {
+        fReusableLines.reset();
+        return 0;
+    }
+
+    for (auto& line : fReusableLines) {
+        line.resetFormatting();
+        auto widthWithSpaces = line.width() + line.spacesWidth();
+        fLongestLine = std::max(fLongestLine, nearlyZero(line.width()) ? widthWithSpaces : line.width());
+        fMaxWidthWithTrailingSpaces = std::max(fMaxWidthWithTrailingSpaces, widthWithSpaces);
+        fLines.emplace_back(std::move(line));
+    }
+    fReusableLines.reset();
+    return count;
+}
+
+void ParagraphImpl::forgetReusableLayout() {
+    fReusableBlocks.reset();
+    fReusableRuns.reset();
+    fReusableLines.reset();
+}
+
 void ParagraphImpl::updateFontSize(size_t from, size_t to, SkScalar fontSize) {
 
   SkASSERT(from == 0 && to == fText.size());
@@ -972,6 +1166,7 @@ void ParagraphImpl::updateFontSize(size_t from, size_t to, SkScalar fontSize) {
     textStyle.fStyle.setFontSize(fontSize);
   }
 
+  this->forgetReusableLayout();
   fState = kUnknown;
   fOldWidth = 0;
   fOldHeight = 0;
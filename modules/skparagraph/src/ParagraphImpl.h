@@ -180,7 +180,10 @@ public:
     Block& block(BlockIndex blockIndex);
     SkTArray<ResolvedFontDescriptor> resolvedFonts() const { return fFontSwitches; }
 
-    void markDirty() override { fState = kUnknown; }
+    void markDirty() override {
+        this->forgetReusableLayout();
+        fState = kUnknown;
+    }
 
     int32_t unresolvedGlyphs() override;
 
@@ -197,12 +200,14 @@ public:
     void buildClusterTable();
     void spaceGlyphs();
     bool shapeTextIntoEndlessLine();
-    void breakShapedTextIntoLines(SkScalar maxWidth);
+    // The first keptLines of fLines are already broken and stay as they are
+    void breakShapedTextIntoLines(SkScalar maxWidth, size_t keptLines = 0);
     void paintLinesIntoPicture(SkScalar x, SkScalar y);
     void paintLines(SkCanvas* canvas, SkScalar x, SkScalar y);
 
     void updateTextAlign(TextAlign textAlign) override;
     void updateText(size_t from, SkString text) override;
+    void replaceText(size_t from, size_t to, SkString text) override;
     void updateFontSize(size_t from, size_t to, SkScalar fontSize) override;
     void updateForegroundPaint(size_t from, size_t to, SkPaint paint) override;
     void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) override;
@@ -236,6 +241,13 @@ private:
 
     void computeEmptyMetrics();
 
+    // Lines can only be kept across an edit if formatting one does not depend on the others
+    bool canKeepLines() const;
+    // Moves the lines kept by the last edit back to fLines if they still fit the paragraph;
+    // returns how many
+    size_t restoreReusableLines(SkScalar maxWidth);
+    void forgetReusableLayout();
+
     // Input
     SkTArray<StyleBlock<SkScalar>> fLetterSpaceStyles;
     SkTArray<StyleBlock<SkScalar>> fWordSpaceStyles;
@@ -273,6 +285,34 @@ private:
     SkScalar fOldHeight;
     SkScalar fMaxWidthWithTrailingSpaces;
 
+    // The runs of every shaped block are recorded so that replaceText can keep those it does
+    // not touch (and the lines before it, up to a hard line break). Once edited, the text is
+    // shaped line by line, so that a block is never longer than a line
+    struct ShapedBlock {
+        TextRange fText;
+        uint8_t fBidiLevel;
+        bool fHasFeatures;
+        SkScalar fAdvanceX;
+        SkScalar fWidth;
+        size_t fFirstRun;
+        size_t fRunCount;
+        size_t fUnresolvedGlyphs;
+    };
+    struct LineIntrinsicWidths {
+        // Intrinsic widths of the paragraph up to and including the line
+        SkScalar fMin;
+        SkScalar fMax;
+    };
+    bool fEdited;
+    SkTArray<ShapedBlock, true> fShapedBlocks;                  // kShaped
+    SkTArray<LineIntrinsicWidths, true> fLineIntrinsicWidths;   // kLineBroken
+    // Left by replaceText for the next layout
+    SkTArray<ShapedBlock, true> fReusableBlocks;
+    SkTArray<Run, false> fReusableRuns;
+    SkTArray<TextLine, false> fReusableLines;
+    SkScalar fReusableLinesWidth;
+    TextIndex fReusedTextEnd;
+
     std::unique_ptr<SkUnicode> fUnicode;
 };
 }  // namespace textlayout
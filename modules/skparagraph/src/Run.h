@@ -54,6 +54,9 @@ class DirText {
 
 class Run {
 public:
+    // The glyph arrays hold this many glyphs without allocating.
+    static constexpr int kPreallocatedGlyphs = 128;
+
     Run(ParagraphImpl* owner,
         const SkShaper::RunHandler::RunInfo& info,
         size_t firstChar,
@@ -182,13 +185,13 @@ private:
     SkVector fOffset;
     TextIndex fClusterStart;
     SkShaper::RunHandler::Range fUtf8Range;
-    SkSTArray<128, SkGlyphID, true> fGlyphs;
-    SkSTArray<128, SkPoint, true> fPositions;
-    SkSTArray<128, SkPoint, true> fJustificationShifts; // For justification (current and prev shifts)
-    SkSTArray<128, uint32_t, true> fClusterIndexes;
-    SkSTArray<128, SkRect, true> fBounds;
+    SkSTArray<kPreallocatedGlyphs, SkGlyphID, true> fGlyphs;
+    SkSTArray<kPreallocatedGlyphs, SkPoint, true> fPositions;
+    SkSTArray<kPreallocatedGlyphs, SkPoint, true> fJustificationShifts; // For justification (current and prev shifts)
+    SkSTArray<kPreallocatedGlyphs, uint32_t, true> fClusterIndexes;
+    SkSTArray<kPreallocatedGlyphs, SkRect, true> fBounds;
 
-    SkSTArray<128, SkScalar, true> fShifts;  // For formatting (letter/word spacing)
+    SkSTArray<kPreallocatedGlyphs, SkScalar, true> fShifts;  // For formatting (letter/word spacing)
 
     SkFontMetrics fFontMetrics;
     const SkScalar fHeightMultiplier;
@@ -60,7 +60,7 @@ public:
     TextRange textWithNewlines() const { return fTextIncludingNewlines; }
     TextRange text() const { return fText; }
     ClusterRange clusters() const { return fClusterRange; }
-    ClusterRange clustersWithSpaces() { return fGhostClusterRange; }
+    ClusterRange clustersWithSpaces() const { return fGhostClusterRange; }
     Run* ellipsis() const { return fEllipsis.get(); }
     InternalLineMetrics sizes() const { return fSizes; }
     bool empty() const { return fTextExcludingSpaces.empty(); }
@@ -87,6 +87,12 @@ public:
     void iterateThroughClustersInGlyphsOrder(bool reverse, bool includeGhosts, const ClustersVisitor& visitor) const;
 
     void format(TextAlign align, SkScalar maxWidth);
+    // Undoes format() and forgets the painted text blobs (for a line kept across an edit)
+    void resetFormatting() {
+        fShift = 0;
+        fTextBlobCache.clear();
+        fTextBlobCachePopulated = false;
+    }
     SkRect paint(SkCanvas* canvas, SkScalar x, SkScalar y);
     void visit(SkScalar x, SkScalar y);
     void ensureTextBlobCachePopulated();
@@ -260,7 +260,8 @@ std::tuple<Cluster*, size_t, SkScalar> TextWrapper::trimStartSpaces(Cluster* end
 // TODO: refactor the code for line ending (with/without ellipsis)
 void TextWrapper::breakTextIntoLines(ParagraphImpl* parent,
                                      SkScalar maxWidth,
-                                     const AddLineToParagraph& addLine) {
+                                     const AddLineToParagraph& addLine,
+                                     const KeptLines* keptLines) {
     fHeight = 0;
     fMinIntrinsicWidth = std::numeric_limits<SkScalar>::min();
     fMaxIntrinsicWidth = std::numeric_limits<SkScalar>::min();
@@ -280,9 +281,20 @@ void TextWrapper::breakTextIntoLines(ParagraphImpl* parent,
     bool firstLine = true; // We only interested in fist line if we have to disable the first ascent
 
     SkScalar softLineMaxIntrinsicWidth = 0;
-    fEndLine = TextStretch(span.begin(), span.begin(), parent->strutForceHeight());
     auto end = span.end() - 1;
     auto start = span.begin();
+    auto first = start;
+    if (keptLines != nullptr) {
+        // Start as if the text after the last kept hard line break was a paragraph of its own
+        SkASSERT(keptLines->fNextCluster < span.size() - 1);
+        first = start + keptLines->fNextCluster;
+        fLineNumber += keptLines->fCount;
+        fHeight = keptLines->fHeight;
+        fMinIntrinsicWidth = keptLines->fMinIntrinsicWidth;
+        fMaxIntrinsicWidth = keptLines->fMaxIntrinsicWidth;
+        firstLine = keptLines->fCount == 0;
+    }
+    fEndLine = TextStretch(first, first, parent->strutForceHeight());
     InternalLineMetrics maxRunMetrics;
     bool needEllipsis = false;
     while (fEndLine.endCluster() != end) {
@@ -384,6 +396,7 @@ void TextWrapper::breakTextIntoLines(ParagraphImpl* parent,
         softLineMaxIntrinsicWidth += widthWithSpaces;
 
         fMaxIntrinsicWidth = std::max(fMaxIntrinsicWidth, softLineMaxIntrinsicWidth);
+        parent->fLineIntrinsicWidths.push_back({fMinIntrinsicWidth, fMaxIntrinsicWidth});
         if (fHardLineBreak) {
             softLineMaxIntrinsicWidth = 0;
         }
@@ -483,6 +496,7 @@ void TextWrapper::breakTextIntoLines(ParagraphImpl* parent,
                 needEllipsis);
         fHeight += fEndLine.metrics().height();
         parent->lines().back().setMaxRunMetrics(maxRunMetrics);
+        parent->fLineIntrinsicWidths.push_back({fMinIntrinsicWidth, fMaxIntrinsicWidth});
     }
 }
 
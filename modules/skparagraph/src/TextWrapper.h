@@ -179,9 +179,18 @@ public:
                                                   SkVector advance,
                                                   InternalLineMetrics metrics,
                                                   bool addEllipsis)>;
+    // Lines already in the paragraph (ending with a hard line break); breaking resumes after them
+    struct KeptLines {
+        size_t fCount;
+        ClusterIndex fNextCluster;
+        SkScalar fHeight;
+        SkScalar fMinIntrinsicWidth;
+        SkScalar fMaxIntrinsicWidth;
+    };
     void breakTextIntoLines(ParagraphImpl* parent,
                             SkScalar maxWidth,
-                            const AddLineToParagraph& addLine);
+                            const AddLineToParagraph& addLine,
+                            const KeptLines* keptLines = nullptr);
 
     SkScalar height() const { return fHeight; }
     SkScalar minIntrinsicWidth() const { return fMinIntrinsicWidth; }
@@ -3,6 +3,7 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFontMgr.h"
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkImageEncoder.h"
@@ -5126,6 +5127,210 @@ DEF_TEST(SkParagraph_CacheStyles, reporter) {
     test(2, false);
 }
 
+DEF_TEST(SkParagraph_CacheByteLimit, reporter) {
+    ParagraphCache cache;
+    cache.turnOn(true);
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setColor(SK_ColorBLACK);
+
+    const int kCount = 20;
+    for (int i = 0; i < kCount; ++i) {
+        SkString text = SkStringPrintf("text%d", i);
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text.c_str(), text.size());
+        builder.pop();
+        auto paragraph = builder.Build();
+        auto impl = static_cast<ParagraphImpl*>(paragraph.get());
+        REPORTER_ASSERT(reporter, !cache.findParagraph(impl));
+        REPORTER_ASSERT(reporter, cache.updateParagraph(impl));
+    }
+    REPORTER_ASSERT(reporter, cache.count() == kCount);
+
+    int count = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < ParagraphCache::kShardCount; ++i) {
+        ParagraphCache::ShardStats stats = cache.shardStats(i);
+        count += stats.fCount;
+        bytes += stats.fBytesUsed;
+        REPORTER_ASSERT(reporter, stats.fEvictions == 0);
+    }
+    REPORTER_ASSERT(reporter, count == kCount);
+    REPORTER_ASSERT(reporter, bytes > 0 && bytes == cache.bytesUsed());
+
+    // Each shard drops its least recently used paragraphs to get under its share of the budget.
+    cache.setByteLimit(bytes / 2);
+    REPORTER_ASSERT(reporter, cache.count() < kCount);
+    REPORTER_ASSERT(reporter, cache.bytesUsed() <= bytes / 2);
+    cache.setByteLimit(0);
+    REPORTER_ASSERT(reporter, cache.count() == 0);
+    int evictions = 0;
+    for (int i = 0; i < ParagraphCache::kShardCount; ++i) {
+        evictions += cache.shardStats(i).fEvictions;
+    }
+    REPORTER_ASSERT(reporter, evictions == kCount);
+}
+
+DEF_TEST(SkParagraph_CachePrefill, reporter) {
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+    ParagraphCache* cache = fontCollection->getParagraphCache();
+    cache->turnOn(true);
+    cache->reset();
+
+    ParagraphStyle paragraph_style;
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setColor(SK_ColorBLACK);
+
+    auto build = [&](const char* text) {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        return builder.Build();
+    };
+
+    cache->prefill(build("scrolled into view"), TestCanvasWidth);
+    cache->prefill(build("a little later"), TestCanvasWidth);
+    cache->waitForPrefill();
+    REPORTER_ASSERT(reporter, cache->count() == 2);
+
+    auto paragraph = build("scrolled into view");
+    REPORTER_ASSERT(reporter, cache->findParagraph(static_cast<ParagraphImpl*>(paragraph.get())));
+
+    // Paragraphs are laid out in parallel on a thread pool.
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    constexpr int kPooled = 16;
+    for (int i = 0; i < kPooled; ++i) {
+        cache->prefill(build(SkStringPrintf("prefilled on a pool %d", i).c_str()),
+                       TestCanvasWidth, *executor);
+    }
+    cache->waitForPrefill(*executor);
+    REPORTER_ASSERT(reporter, cache->count() == 2 + kPooled);
+    for (int i = 0; i < kPooled; ++i) {
+        paragraph = build(SkStringPrintf("prefilled on a pool %d", i).c_str());
+        REPORTER_ASSERT(reporter,
+                        cache->findParagraph(static_cast<ParagraphImpl*>(paragraph.get())));
+    }
+}
+
+DEF_TEST(SkParagraph_ReplaceText, reporter) {
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+
+    ParagraphStyle paragraph_style;
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setFontSize(20);
+    text_style.setColor(SK_ColorBLACK);
+
+    auto build = [&](const char* text) {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        auto paragraph = builder.Build();
+        paragraph->layout(200);
+        return paragraph;
+    };
+
+    // Every edit must lay out exactly as the edited text built from scratch
+    auto check = [&](Paragraph* edited, const char* text) {
+        auto expected = build(text);
+        auto impl = static_cast<ParagraphImpl*>(edited);
+        REPORTER_ASSERT(reporter, std::string(impl->text().data(), impl->text().size()) == text);
+        REPORTER_ASSERT(reporter, edited->lineNumber() == expected->lineNumber());
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(edited->getHeight(), expected->getHeight()));
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(edited->getMaxIntrinsicWidth(),
+                                                      expected->getMaxIntrinsicWidth()));
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(edited->getMinIntrinsicWidth(),
+                                                      expected->getMinIntrinsicWidth()));
+        std::vector<LineMetrics> editedLines, expectedLines;
+        edited->getLineMetrics(editedLines);
+        expected->getLineMetrics(expectedLines);
+        REPORTER_ASSERT(reporter, editedLines.size() == expectedLines.size());
+        for (size_t i = 0; i < std::min(editedLines.size(), expectedLines.size()); ++i) {
+            REPORTER_ASSERT(reporter, editedLines[i].fStartIndex == expectedLines[i].fStartIndex);
+            REPORTER_ASSERT(reporter, editedLines[i].fEndIndex == expectedLines[i].fEndIndex);
+            REPORTER_ASSERT(reporter,
+                            std::abs(editedLines[i].fWidth - expectedLines[i].fWidth) < EPSILON100);
+            REPORTER_ASSERT(reporter,
+                            std::abs(editedLines[i].fBaseline - expectedLines[i].fBaseline) < EPSILON100);
+        }
+    };
+
+    auto paragraph = build("First line\nSecond line\nThe third line is long enough to wrap");
+    // Replace a word in the last line; the first two lines are kept
+    paragraph->replaceText(33, 37, SkString("paragraph"));
+    paragraph->layout(200);
+    check(paragraph.get(), "First line\nSecond line\nThe third paragraph is long enough to wrap");
+
+    // Edit the next to last line, then insert and delete at both ends before laying out
+    paragraph->replaceText(18, 22, SkString("row"));
+    paragraph->layout(200);
+    check(paragraph.get(), "First line\nSecond row\nThe third paragraph is long enough to wrap");
+    paragraph->replaceText(0, 0, SkString("Zeroth line\n"));
+    paragraph->replaceText(76, 76, SkString("\nLast"));
+    paragraph->replaceText(12, 18, SkString());
+    paragraph->layout(200);
+    check(paragraph.get(), "Zeroth line\nline\nSecond row\nThe third paragraph is long enough to wrap\nLast");
+
+    // A narrower width only breaks the lines again
+    paragraph->layout(100);
+    auto expected = build("Zeroth line\nline\nSecond row\nThe third paragraph is long enough to wrap\nLast");
+    expected->layout(100);
+    REPORTER_ASSERT(reporter, paragraph->lineNumber() == expected->lineNumber());
+    REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getHeight(), expected->getHeight()));
+}
+
+DEF_TEST(SkParagraph_RelayoutWidth, reporter) {
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+
+    ParagraphStyle paragraph_style;
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setFontSize(20);
+    text_style.setColor(SK_ColorBLACK);
+    text_style.setLetterSpacing(2);
+    text_style.setWordSpacing(5);
+    const char* text = "Letter and word spacing must only be added once, whatever the width";
+
+    auto build = [&]() {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        return builder.Build();
+    };
+
+    auto expected = build();
+    expected->layout(300);
+    auto paragraph = build();
+    paragraph->layout(300);
+    auto impl = static_cast<ParagraphImpl*>(paragraph.get());
+    auto runs = impl->runs().data();
+
+    // Changing the width keeps the runs as they are
+    paragraph->layout(150);
+    paragraph->layout(300);
+    REPORTER_ASSERT(reporter, impl->runs().data() == runs);
+    REPORTER_ASSERT(reporter, paragraph->lineNumber() == expected->lineNumber());
+    REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getHeight(), expected->getHeight()));
+    REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getMaxIntrinsicWidth(),
+                                                  expected->getMaxIntrinsicWidth()));
+    REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getLongestLine(),
+                                                  expected->getLongestLine()));
+}
+
 DEF_TEST(SkParagraph_EmptyParagraphWithLineBreak, reporter) {
     sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
     if (!fontCollection->fontsFound()) return;
@@ -49,6 +49,28 @@ public:
     static std::unique_ptr<SkShaper> MakeShapeThenWrap(sk_sp<SkFontMgr> = nullptr);
     static std::unique_ptr<SkShaper> MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr> = nullptr);
     static void PurgeHarfBuzzCache();
+
+    // Shaping with HarfBuzz keeps the HarfBuzz faces of recently used typefaces, shared by all
+    // threads, and each thread keeps the HarfBuzz fonts it used last. Changing the number of
+    // faces kept purges the caches. At least 16 faces are kept.
+    static void SetHarfBuzzCacheCapacity(int faceCount);
+    // Shaped runs are kept, and replayed without shaping them again, while they fit in bytes.
+    // The default of 0 keeps none.
+    static void SetHarfBuzzShapeCacheLimit(size_t bytes);
+    struct HarfBuzzCacheStats {
+        // Faces found in and added to the face cache, when a thread did not have the font.
+        uint64_t fHits;
+        uint64_t fMisses;
+        uint64_t fEvictions;
+        int      fFaceCount;
+        int      fCapacity;
+        uint64_t fShapeHits;
+        uint64_t fShapeMisses;
+        size_t   fShapeBytesUsed;
+        // Fonts found in the cache of the shaping thread, without looking up their face.
+        uint64_t fFontHits;
+    };
+    static HarfBuzzCacheStats GetHarfBuzzCacheStats();
     #endif
     #ifdef SK_SHAPER_CORETEXT_AVAILABLE
     static std::unique_ptr<SkShaper> MakeCoreText();
@@ -28,16 +28,23 @@
 #include "include/private/SkTo.h"
 #include "modules/skshaper/include/SkShaper.h"
 #include "modules/skunicode/include/SkUnicode.h"
+#include "src/core/SkFontPriv.h"
 #include "src/core/SkLRUCache.h"
+#include "src/core/SkOpts.h"
 #include "src/core/SkTDPQueue.h"
+#include "src/core/SkTLazy.h"
 #include "src/utils/SkUTF.h"
 
 #include <hb.h>
 #include <hb-ot.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cstring>
 #include <memory>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 // HB_FEATURE_GLOBAL_START and HB_FEATURE_GLOBAL_END were not added until HarfBuzz 2.0
 // They would have always worked, they just hadn't been named yet.
@@ -1259,40 +1266,373 @@ void ShapeDontWrapOrReorder::wrap(char const * const utf8, size_t utf8Bytes,
     handler->commitLine();
 }
 
-class HBLockedFaceCache {
+// An HBFace is expensive (it sanitizes the bits), so faces are shared by every shaper on every
+// thread. The cache is split into shards by font id, so that shaping on many threads does not
+// serialize on a single mutex, and faces are made outside of any lock.
+class HBFaceCache {
 public:
-    HBLockedFaceCache(SkLRUCache<SkFontID, HBFace>& lruCache, SkMutex& mutex)
-        : fLRUCache(lruCache), fMutex(mutex)
-    {
-        fMutex.acquire();
+    static HBFaceCache& Get() {
+        static HBFaceCache* gCache = new HBFaceCache;
+        return *gCache;
     }
-    HBLockedFaceCache(const HBLockedFaceCache&) = delete;
-    HBLockedFaceCache& operator=(const HBLockedFaceCache&) = delete;
-    HBLockedFaceCache(HBLockedFaceCache&&) = delete;
-    HBLockedFaceCache& operator=(HBLockedFaceCache&&) = delete;
 
-    ~HBLockedFaceCache() {
-        fMutex.release();
+    // Returns a new reference to the face of typeface, or nullptr if it cannot be made.
+    HBFace findOrMake(const SkTypeface& typeface) {
+        const SkFontID fontId = typeface.uniqueID();
+        Shard& shard = this->shard(fontId);
+        {
+            SkAutoMutexExclusive lock(shard.fMutex);
+            if (HBFace* found = shard.fFaces->find(fontId)) {
+                shard.fHits++;
+                return HBFace(hb_face_reference(found->get()));
+            }
+            shard.fMisses++;
+        }
+
+        HBFace face = create_hb_face(typeface);
+        if (!face) {
+            return nullptr;
+        }
+        SkAutoMutexExclusive lock(shard.fMutex);
+        // Another thread may have made the same face in the meantime; keep the first one.
+        HBFace* cached = shard.fFaces->find(fontId);
+        if (!cached) {
+            const int count = shard.fFaces->count();
+            cached = shard.fFaces->insert(fontId, std::move(face));
+            shard.fEvictions += count + 1 - shard.fFaces->count();
+        }
+        return HBFace(hb_face_reference(cached->get()));
+    }
+
+    // Drops every cached face; capacity is the number of faces kept afterwards.
+    void reset(int capacity) {
+        fCapacity.store(capacity, std::memory_order_relaxed);
+        for (int i = 0; i < kShardCount; ++i) {
+            SkAutoMutexExclusive lock(fShards[i].fMutex);
+            fShards[i].fFaces = std::make_unique<SkLRUCache<SkFontID, HBFace>>(
+                    shard_capacity(capacity, i));
+        }
+    }
+    void reset() { this->reset(fCapacity.load(std::memory_order_relaxed)); }
+
+    SkShaper::HarfBuzzCacheStats stats() {
+        SkShaper::HarfBuzzCacheStats stats = {};
+        stats.fCapacity = fCapacity.load(std::memory_order_relaxed);
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive lock(shard.fMutex);
+            stats.fHits      += shard.fHits;
+            stats.fMisses    += shard.fMisses;
+            stats.fEvictions += shard.fEvictions;
+            stats.fFaceCount += shard.fFaces->count();
+        }
+        return stats;
+    }
+
+private:
+    // The size of 100 here is completely arbitrary and used to match libtxt.
+    static constexpr int kDefaultCapacity = 100;
+    static constexpr int kShardCount = 16;
+
+    struct Shard {
+        SkMutex fMutex;
+        std::unique_ptr<SkLRUCache<SkFontID, HBFace>> fFaces SK_GUARDED_BY(fMutex);
+        uint64_t fHits      SK_GUARDED_BY(fMutex) = 0;
+        uint64_t fMisses    SK_GUARDED_BY(fMutex) = 0;
+        uint64_t fEvictions SK_GUARDED_BY(fMutex) = 0;
+    };
+
+    HBFaceCache() { this->reset(kDefaultCapacity); }
+
+    // The shards split capacity between them, so that they keep capacity faces in all. Each
+    // keeps at least one face though, so a capacity below kShardCount keeps kShardCount faces.
+    static int shard_capacity(int capacity, int shardIndex) {
+        return std::max(1, capacity / kShardCount + (shardIndex < capacity % kShardCount));
+    }
+
+    Shard& shard(SkFontID fontId) { return fShards[SkGoodHash()(fontId) % kShardCount]; }
+
+    Shard fShards[kShardCount];
+    std::atomic<int> fCapacity{kDefaultCapacity};
+};
+
+// An HBFont is fairly inexpensive, but shaping a paragraph makes one per run, so each thread
+// keeps the fonts it used last. The font of a run depends on all of its SkFont, not only on its
+// typeface. The caches of all threads are listed, so that purging drops their fonts, and with
+// them their references to faces, right away.
+class HBFontCache {
+public:
+    static HBFontCache& ForThisThread() {
+        static thread_local HBFontCache gCache;
+        return gCache;
+    }
+
+    // Returns a new reference to the font for font, or nullptr if it cannot be made.
+    HBFont findOrMake(const SkFont& font) {
+        {
+            // Only Purge() and AddStats() take this lock from another thread, so it is cheap.
+            SkAutoMutexExclusive lock(fMutex);
+            for (const Entry& entry : fEntries) {
+                if (entry.fHBFont && entry.fFont == font) {
+                    fHits++;
+                    return HBFont(hb_font_reference(entry.fHBFont.get()));
+                }
+            }
+        }
+
+        HBFace face = HBFaceCache::Get().findOrMake(*font.getTypeface());
+        if (!face) {
+            return nullptr;
+        }
+        HBFont hbFont = create_hb_font(font, face);
+        if (!hbFont) {
+            return nullptr;
+        }
+        // Replace the entries in turn; runs usually alternate between a few fonts.
+        SkAutoMutexExclusive lock(fMutex);
+        fEntries[fNext] = {font, HBFont(hb_font_reference(hbFont.get()))};
+        fNext = (fNext + 1) % kMaxCount;
+        return hbFont;
+    }
+
+    // Drops the fonts of every thread.
+    static void Purge() {
+        Threads& threads = Threads::Get();
+        SkAutoMutexExclusive lock(threads.fMutex);
+        for (HBFontCache* cache : threads.fCaches) {
+            SkAutoMutexExclusive cacheLock(cache->fMutex);
+            for (Entry& entry : cache->fEntries) {
+                entry = Entry();
+            }
+        }
     }
 
-    HBFace* find(SkFontID fontId) {
-        return fLRUCache.find(fontId);
+    // Adds the fonts found in the caches of all threads, past and present, to stats.
+    static void AddStats(SkShaper::HarfBuzzCacheStats* stats) {
+        Threads& threads = Threads::Get();
+        SkAutoMutexExclusive lock(threads.fMutex);
+        stats->fFontHits = threads.fExitedHits;
+        for (HBFontCache* cache : threads.fCaches) {
+            SkAutoMutexExclusive cacheLock(cache->fMutex);
+            stats->fFontHits += cache->fHits;
+        }
     }
-    HBFace* insert(SkFontID fontId, HBFace hbFace) {
-        return fLRUCache.insert(fontId, std::move(hbFace));
+
+private:
+    static constexpr int kMaxCount = 8;
+
+    struct Entry {
+        SkFont fFont;
+        HBFont fHBFont;
+    };
+
+    // The caches of the threads which are alive.
+    struct Threads {
+        static Threads& Get() {
+            static Threads* gThreads = new Threads;
+            return *gThreads;
+        }
+
+        SkMutex fMutex;
+        std::vector<HBFontCache*> fCaches SK_GUARDED_BY(fMutex);
+        uint64_t fExitedHits SK_GUARDED_BY(fMutex) = 0;
+    };
+
+    HBFontCache() {
+        Threads& threads = Threads::Get();
+        SkAutoMutexExclusive lock(threads.fMutex);
+        threads.fCaches.push_back(this);
     }
+
+    ~HBFontCache() {
+        Threads& threads = Threads::Get();
+        SkAutoMutexExclusive lock(threads.fMutex);
+        threads.fCaches.erase(std::find(threads.fCaches.begin(), threads.fCaches.end(), this));
+        SkAutoMutexExclusive cacheLock(fMutex);
+        threads.fExitedHits += fHits;
+    }
+
+    SkMutex fMutex;
+    Entry fEntries[kMaxCount] SK_GUARDED_BY(fMutex);
+    int fNext SK_GUARDED_BY(fMutex) = 0;
+    uint64_t fHits SK_GUARDED_BY(fMutex) = 0;
+};
+
+// Shaped runs, kept while SkShaper::SetHarfBuzzShapeCacheLimit() allows it. A run is keyed by
+// everything hb_shape() sees: its text and the context HarfBuzz looks at around it, its font,
+// features, script, language and direction. Clusters are kept relative to the start of the run.
+class ShapeCache {
+public:
+    class Key {
+    public:
+        Key(const char* utf8, size_t utf8Bytes, const char* utf8Start, const char* utf8End,
+            const SkFont& font, bool leftToRight, SkFourByteTag script, const char* language,
+            SkSpan<const hb_feature_t> features)
+        {
+            // HarfBuzz only keeps this many code points of context on each side of the run.
+            constexpr int kContextLength = 5;
+            const char* contextStart = utf8Start;
+            for (int i = 0; i < kContextLength && contextStart > utf8; ++i) {
+                do {
+                    --contextStart;
+                } while (contextStart > utf8 && (*contextStart & 0xC0) == 0x80);
+            }
+            const char* contextEnd = utf8End;
+            for (int i = 0; i < kContextLength && contextEnd < utf8 + utf8Bytes; ++i) {
+                utf8_next(&contextEnd, utf8 + utf8Bytes);
+            }
+
+            struct Header {
+                SkFontID fTypefaceID;
+                SkScalar fSize, fScaleX, fSkewX;
+                uint32_t fFlags, fEdging, fHinting;
+                SkFourByteTag fScript;
+                uint32_t fLeftToRight;
+                uint32_t fPrecontextBytes, fTextBytes, fPostcontextBytes, fFeatureCount;
+            } header;
+            memset(&header, 0, sizeof(header));
+            header.fTypefaceID = font.getTypeface() ? font.getTypeface()->uniqueID() : 0;
+            header.fSize = font.getSize();
+            header.fScaleX = font.getScaleX();
+            header.fSkewX = font.getSkewX();
+            header.fFlags = SkFontPriv::Flags(font);
+            header.fEdging = (uint32_t)font.getEdging();
+            header.fHinting = (uint32_t)font.getHinting();
+            header.fScript = script;
+            header.fLeftToRight = leftToRight;
+            header.fPrecontextBytes = SkToU32(utf8Start - contextStart);
+            header.fTextBytes = SkToU32(utf8End - utf8Start);
+            header.fPostcontextBytes = SkToU32(contextEnd - utf8End);
+            header.fFeatureCount = SkToU32(features.size());
+
+            const size_t languageBytes = language ? strlen(language) : 0;
+            fBytes.reserve(sizeof(header) + (contextEnd - contextStart) + languageBytes +
+                           features.size() * sizeof(hb_feature_t));
+            this->write(&header, sizeof(header));
+            this->write(contextStart, contextEnd - contextStart);
+            // Feature ranges are made relative to the run, like the clusters.
+            const unsigned runOffset = SkToUInt(utf8Start - utf8);
+            for (hb_feature_t feature : features) {
+                if (feature.start != HB_FEATURE_GLOBAL_START) {
+                    feature.start -= runOffset;
+                }
+                if (feature.end != HB_FEATURE_GLOBAL_END) {
+                    feature.end -= runOffset;
+                }
+                const uint32_t fields[] = {feature.tag, feature.value, feature.start, feature.end};
+                this->write(fields, sizeof(fields));
+            }
+            this->write(language, languageBytes);
+            fHash = SkOpts::hash(fBytes.data(), fBytes.size());
+        }
+
+        bool operator==(const Key& that) const {
+            return fHash == that.fHash && fBytes == that.fBytes;
+        }
+        size_t bytesUsed() const { return sizeof(Key) + fBytes.capacity(); }
+
+        struct Hash {
+            uint32_t operator()(const Key& key) const { return key.fHash; }
+        };
+
+    private:
+        void write(const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            fBytes.insert(fBytes.end(), bytes, bytes + size);
+        }
+
+        std::vector<uint8_t> fBytes;
+        uint32_t fHash;
+    };
+
+    static ShapeCache& Get() {
+        static ShapeCache* gCache = new ShapeCache;
+        return *gCache;
+    }
+
+    bool enabled() const { return fLimit.load(std::memory_order_relaxed) > 0; }
+
+    // Copies the cached glyphs of key into run, whose range must already be set. Returns false
+    // if key is not in the cache.
+    bool find(const Key& key, ShapedRun* run) {
+        SkAutoMutexExclusive lock(fMutex);
+        const Value* found = fRuns.find(key);
+        if (!found) {
+            fMisses++;
+            return false;
+        }
+        fHits++;
+        run->fGlyphs.reset(new ShapedGlyph[found->fNumGlyphs]);
+        run->fNumGlyphs = found->fNumGlyphs;
+        run->fAdvance = found->fAdvance;
+        for (size_t i = 0; i < found->fNumGlyphs; ++i) {
+            run->fGlyphs[i] = found->fGlyphs[i];
+            run->fGlyphs[i].fCluster += run->fUtf8Range.begin();
+        }
+        return true;
+    }
+
+    void add(const Key& key, const ShapedRun& run) {
+        Value value;
+        value.fGlyphs.reset(new ShapedGlyph[run.fNumGlyphs]);
+        value.fNumGlyphs = run.fNumGlyphs;
+        value.fAdvance = run.fAdvance;
+        value.fBytesUsed = sizeof(Value) + key.bytesUsed() + run.fNumGlyphs * sizeof(ShapedGlyph);
+        for (size_t i = 0; i < run.fNumGlyphs; ++i) {
+            value.fGlyphs[i] = run.fGlyphs[i];
+            value.fGlyphs[i].fCluster -= run.fUtf8Range.begin();
+        }
+
+        SkAutoMutexExclusive lock(fMutex);
+        const size_t limit = fLimit.load(std::memory_order_relaxed);
+        if (value.fBytesUsed > limit || fRuns.find(key)) {
+            return;
+        }
+        fBytesUsed += value.fBytesUsed;
+        fRuns.insert(key, std::move(value));
+        this->purgeAsNeeded(limit);
+    }
+
+    void setLimit(size_t bytes) {
+        SkAutoMutexExclusive lock(fMutex);
+        fLimit.store(bytes, std::memory_order_relaxed);
+        this->purgeAsNeeded(bytes);
+    }
+
     void reset() {
-        fLRUCache.reset();
+        SkAutoMutexExclusive lock(fMutex);
+        fRuns.reset();
+        fBytesUsed = 0;
     }
+
+    void addStats(SkShaper::HarfBuzzCacheStats* stats) {
+        SkAutoMutexExclusive lock(fMutex);
+        stats->fShapeHits = fHits;
+        stats->fShapeMisses = fMisses;
+        stats->fShapeBytesUsed = fBytesUsed;
+    }
+
 private:
-    SkLRUCache<SkFontID, HBFace>& fLRUCache;
-    SkMutex& fMutex;
+    struct Value {
+        std::unique_ptr<ShapedGlyph[]> fGlyphs;
+        size_t fNumGlyphs;
+        SkVector fAdvance;
+        size_t fBytesUsed;
+    };
+
+    void purgeAsNeeded(size_t limit) SK_REQUIRES(fMutex) {
+        while (fBytesUsed > limit) {
+            fBytesUsed -= fRuns.removeLeastRecentlyUsed().fBytesUsed;
+        }
+    }
+
+    SkMutex fMutex;
+    // Bounded by bytes rather than by count.
+    SkLRUCache<Key, Value, Key::Hash> fRuns SK_GUARDED_BY(fMutex){INT_MAX};
+    size_t fBytesUsed SK_GUARDED_BY(fMutex) = 0;
+    uint64_t fHits    SK_GUARDED_BY(fMutex) = 0;
+    uint64_t fMisses  SK_GUARDED_BY(fMutex) = 0;
+    std::atomic<size_t> fLimit{0};
 };
-static HBLockedFaceCache get_hbFace_cache() {
-    static SkMutex gHBFaceCacheMutex;
-    static SkLRUCache<SkFontID, HBFace> gHBFaceCache(100);
-    return HBLockedFaceCache(gHBFaceCache, gHBFaceCacheMutex);
-}
 
 ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
                                   size_t const utf8Bytes,
@@ -1308,6 +1648,35 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     ShapedRun run(RunHandler::Range(utf8Start - utf8, utf8runLength),
                   font.currentFont(), bidi.currentLevel(), nullptr, 0);
 
+    SkSTArray<32, hb_feature_t> hbFeatures;
+    for (const auto& feature : SkMakeSpan(features, featuresSize)) {
+        if (feature.end < SkTo<size_t>(utf8Start - utf8) ||
+                          SkTo<size_t>(utf8End   - utf8)  <= feature.start)
+        {
+            continue;
+        }
+        if (feature.start <= SkTo<size_t>(utf8Start - utf8) &&
+                             SkTo<size_t>(utf8End   - utf8) <= feature.end)
+        {
+            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
+                                   HB_FEATURE_GLOBAL_START, HB_FEATURE_GLOBAL_END});
+        } else {
+            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
+                                   SkTo<unsigned>(feature.start), SkTo<unsigned>(feature.end)});
+        }
+    }
+
+    ShapeCache& shapeCache = ShapeCache::Get();
+    SkTLazy<ShapeCache::Key> shapeKey;
+    if (shapeCache.enabled()) {
+        shapeKey.init(utf8, utf8Bytes, utf8Start, utf8End, font.currentFont(),
+                      is_LTR(bidi.currentLevel()), script.currentScript(),
+                      language.currentLanguage(), SkMakeSpan(hbFeatures.data(), hbFeatures.size()));
+        if (shapeCache.find(*shapeKey, &run)) {
+            return run;
+        }
+    }
+
     hb_buffer_t* buffer = fBuffer.get();
     SkAutoTCallVProc<hb_buffer_t, hb_buffer_clear_contents> autoClearBuffer(buffer);
     hb_buffer_set_content_type(buffer, HB_BUFFER_CONTENT_TYPE_UNICODE);
@@ -1345,44 +1714,12 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     hb_buffer_set_language(buffer, hbLanguage);
     hb_buffer_guess_segment_properties(buffer);
 
-    // TODO: better cache HBFace (data) / hbfont (typeface)
-    // An HBFace is expensive (it sanitizes the bits).
-    // An HBFont is fairly inexpensive.
-    // An HBFace is actually tied to the data, not the typeface.
-    // The size of 100 here is completely arbitrary and used to match libtxt.
-    HBFont hbFont;
-    {
-        HBLockedFaceCache cache = get_hbFace_cache();
-        SkFontID dataId = font.currentFont().getTypeface()->uniqueID();
-        HBFace* hbFaceCached = cache.find(dataId);
-        if (!hbFaceCached) {
-            HBFace hbFace(create_hb_face(*font.currentFont().getTypeface()));
-            hbFaceCached = cache.insert(dataId, std::move(hbFace));
-        }
-        hbFont = create_hb_font(font.currentFont(), *hbFaceCached);
-    }
+    // TODO: An HBFace is actually tied to the data, not the typeface.
+    HBFont hbFont = HBFontCache::ForThisThread().findOrMake(font.currentFont());
     if (!hbFont) {
         return run;
     }
 
-    SkSTArray<32, hb_feature_t> hbFeatures;
-    for (const auto& feature : SkMakeSpan(features, featuresSize)) {
-        if (feature.end < SkTo<size_t>(utf8Start - utf8) ||
-                          SkTo<size_t>(utf8End   - utf8)  <= feature.start)
-        {
-            continue;
-        }
-        if (feature.start <= SkTo<size_t>(utf8Start - utf8) &&
-                             SkTo<size_t>(utf8End   - utf8) <= feature.end)
-        {
-            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
-                                   HB_FEATURE_GLOBAL_START, HB_FEATURE_GLOBAL_END});
-        } else {
-            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
-                                   SkTo<unsigned>(feature.start), SkTo<unsigned>(feature.end)});
-        }
-    }
-
     hb_shape(hbFont.get(), buffer, hbFeatures.data(), hbFeatures.size());
     unsigned len = hb_buffer_get_length(buffer);
     if (len == 0) {
@@ -1430,6 +1767,9 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     }
     run.fAdvance = runAdvance;
 
+    if (shapeKey.isValid()) {
+        shapeCache.add(*shapeKey, run);
+    }
     return run;
 }
 
@@ -1516,6 +1856,23 @@ std::unique_ptr<SkShaper> SkShaper::MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr>
 }
 
 void SkShaper::PurgeHarfBuzzCache() {
-    HBLockedFaceCache cache = get_hbFace_cache();
-    cache.reset();
+    HBFaceCache::Get().reset();
+    HBFontCache::Purge();
+    ShapeCache::Get().reset();
+}
+
+void SkShaper::SetHarfBuzzCacheCapacity(int faceCount) {
+    HBFaceCache::Get().reset(std::max(faceCount, 1));
+    HBFontCache::Purge();
+}
+
+void SkShaper::SetHarfBuzzShapeCacheLimit(size_t bytes) {
+    ShapeCache::Get().setLimit(bytes);
+}
+
+SkShaper::HarfBuzzCacheStats SkShaper::GetHarfBuzzCacheStats() {
+    SkShaper::HarfBuzzCacheStats stats = HBFaceCache::Get().stats();
+    HBFontCache::AddStats(&stats);
+    ShapeCache::Get().addStats(&stats);
+    return stats;
 }
@@ -88,6 +88,11 @@ public:
 
     void paintMasks(SkDrawableGlyphBuffer* drawables, const SkPaint& paint) const override;
 
+    void paintDrawables(SkDrawableGlyphBuffer* drawables,
+                        SkScalar scale,
+                        SkPoint origin,
+                        const SkPaint& paint) const override;
+
     static bool ComputeMaskBounds(const SkRect& devPathBounds, const SkIRect* clipBounds,
                                   const SkMaskFilter* filter, const SkMatrix* filterMatrix,
                                   SkIRect* bounds);
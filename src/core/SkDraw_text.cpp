@@ -6,6 +6,8 @@
  */
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkDrawable.h"
 #include "src/core/SkDraw.h"
 #include "src/core/SkFontPriv.h"
 #include "src/core/SkMatrixProvider.h"
@@ -124,6 +126,34 @@ void SkDraw::paintPaths(SkDrawableGlyphBuffer* drawables,
     }
 }
 
+void SkDraw::paintDrawables(SkDrawableGlyphBuffer* drawables,
+                            SkScalar scale,
+                            SkPoint origin,
+                            const SkPaint& paint) const {
+    for (auto [variant, pos] : drawables->drawable()) {
+        SkDrawable* drawable = variant.glyph()->drawable();
+        SkMatrix m;
+        SkPoint translate = origin + pos;
+        m.setScaleTranslate(scale, scale, translate.x(), translate.y());
+        m.postConcat(fMatrixProvider->localToDevice());
+
+        // Render only the part of the glyph inside the clip, then draw it like a color mask.
+        SkIRect bounds;
+        if (!bounds.intersect(m.mapRect(drawable->getBounds()).roundOut(), fRC->getBounds())) {
+            continue;
+        }
+        SkBitmap bm;
+        if (!bm.tryAllocN32Pixels(bounds.width(), bounds.height())) {
+            continue;
+        }
+        bm.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(bm);
+        canvas.translate(-bounds.x(), -bounds.y());
+        drawable->draw(&canvas, &m);
+        this->drawSprite(bm, bounds.x(), bounds.y(), paint);
+    }
+}
+
 void SkDraw::drawGlyphRunList(const SkGlyphRunList& glyphRunList,
                               const SkPaint& paint,
                               SkGlyphRunListPainter* glyphPainter) const {
@@ -62,6 +62,10 @@ SkRect SkDrawable::getBounds() {
     return this->onGetBounds();
 }
 
+size_t SkDrawable::approximateBytesUsed() {
+    return 0;
+}
+
 void SkDrawable::notifyDrawingChanged() {
     fGenerationID = 0;
 }
@@ -10,7 +10,9 @@
 #include "include/private/SkSemaphore.h"
 #include "include/private/SkSpinlock.h"
 #include "include/private/SkTArray.h"
+#include <atomic>
 #include <deque>
+#include <memory>
 #include <thread>
 
 #if defined(SK_BUILD_FOR_WIN)
@@ -139,6 +141,152 @@ private:
     bool                  fAllowBorrowing;
 };
 
+// A deque of work owned by one thread of an SkWorkStealingThreadPool. Its owner adds and takes work
+// at the back, so it runs the work it added most recently, whose data is most likely still in its
+// cache; other threads steal from the front. Work is kept in a ring that only grows, so adding
+// work does not allocate once the pool is warm.
+class SkWorkDeque {
+public:
+    void push_back(std::function<void(void)> work) {
+        SkAutoSpinlock lock(fLock);
+        if (fCount == fCapacity) {
+            this->grow();
+        }
+        fSlots[(fHead + fCount++) & (fCapacity - 1)] = std::move(work);
+    }
+
+    bool pop_back(std::function<void(void)>* work) {
+        SkAutoSpinlock lock(fLock);
+        if (fCount == 0) {
+            return false;
+        }
+        *work = std::move(fSlots[(fHead + --fCount) & (fCapacity - 1)]);
+        return true;
+    }
+
+    bool pop_front(std::function<void(void)>* work) {
+        SkAutoSpinlock lock(fLock);
+        if (fCount == 0) {
+            return false;
+        }
+        *work = std::move(fSlots[fHead]);
+        fHead = (fHead + 1) & (fCapacity - 1);
+        fCount--;
+        return true;
+    }
+
+private:
+    void grow() {
+        const int capacity = fCapacity ? 2 * fCapacity : 16;
+        std::unique_ptr<std::function<void(void)>[]> slots(
+                new std::function<void(void)>[capacity]);
+        for (int i = 0; i < fCount; i++) {
+            slots[i] = std::move(fSlots[(fHead + i) & (fCapacity - 1)]);
+        }
+        fSlots = std::move(slots);
+        fCapacity = capacity;
+        fHead = 0;
+    }
+
+    // Held only to move one std::function in or out, so a spinlock is enough.
+    SkSpinlock fLock;
+    std::unique_ptr<std::function<void(void)>[]> fSlots;
+    int fHead = 0,
+        fCount = 0,
+        fCapacity = 0;
+};
+
+// An SkWorkStealingThreadPool gives each of its threads a deque of work, rather than sharing one
+// list behind one lock. Work added by a pool thread goes to its own deque, other work is dealt
+// round robin, and a thread out of work steals from the others. fWorkAvailable still counts all
+// the queued work, so a thread which takes a count is sure to find work in some deque.
+//
+// Thieves take whole std::functions, which cannot be copied racily, so the deques are short
+// spinlocked critical sections rather than lock-free Chase-Lev deques; with one lock per thread
+// they are rarely contended.
+class SkWorkStealingThreadPool final : public SkExecutor {
+public:
+    SkWorkStealingThreadPool(int threads, bool allowBorrowing)
+            : fDeques(new SkWorkDeque[threads])
+            , fDequeCount(threads)
+            , fAllowBorrowing(allowBorrowing) {
+        for (int i = 0; i < threads; i++) {
+            fThreads.emplace_back(&Loop, this, i);
+        }
+    }
+
+    ~SkWorkStealingThreadPool() override {
+        // Signal each thread that it's time to shut down, then wait for each to do so.
+        for (int i = 0; i < fThreads.count(); i++) {
+            this->add(nullptr);
+        }
+        for (int i = 0; i < fThreads.count(); i++) {
+            fThreads[i].join();
+        }
+    }
+
+    void add(std::function<void(void)> work) override {
+        int deque;
+        if (gCurrentPool == this) {
+            deque = gCurrentDeque;
+        } else {
+            deque = (int)(fNextDeque.fetch_add(1, std::memory_order_relaxed) % fDequeCount);
+        }
+        fDeques[deque].push_back(std::move(work));
+        fWorkAvailable.signal(1);
+    }
+
+    void borrow() override {
+        if (fAllowBorrowing && fWorkAvailable.try_wait()) {
+            // Borrowing threads own no deque, so they only steal.
+            SkAssertResult(this->do_work(gCurrentPool == this ? gCurrentDeque : -1));
+        }
+    }
+
+private:
+    // This method should be called only when fWorkAvailable indicates there's work to do.
+    // home is the deque of the calling thread, or -1 if it has none.
+    bool do_work(int home) {
+        std::function<void(void)> work;
+        bool found = home >= 0 && fDeques[home].pop_back(&work);
+        // Another thread may have taken the work we were signaled for, but then there is work
+        // it was signaled for left in some deque, so keep looking.
+        for (int victim = home; !found;) {
+            victim = (victim + 1) % fDequeCount;
+            found = fDeques[victim].pop_front(&work);
+        }
+
+        if (!work) {
+            return false;  // This is Loop()'s signal to shut down.
+        }
+
+        work();
+        return true;
+    }
+
+    static void Loop(SkWorkStealingThreadPool* pool, int deque) {
+        gCurrentPool  = pool;
+        gCurrentDeque = deque;
+        do {
+            pool->fWorkAvailable.wait();
+        } while (pool->do_work(deque));
+    }
+
+    // The pool and deque of the calling thread, if it is one of a pool's threads.
+    static thread_local SkWorkStealingThreadPool* gCurrentPool;
+    static thread_local int                       gCurrentDeque;
+
+    SkTArray<std::thread>          fThreads;
+    std::unique_ptr<SkWorkDeque[]> fDeques;
+    const int                      fDequeCount;
+    std::atomic<unsigned>          fNextDeque{0};
+    SkSemaphore                    fWorkAvailable;
+    bool                           fAllowBorrowing;
+};
+
+thread_local SkWorkStealingThreadPool* SkWorkStealingThreadPool::gCurrentPool  = nullptr;
+thread_local int                       SkWorkStealingThreadPool::gCurrentDeque = 0;
+
 std::unique_ptr<SkExecutor> SkExecutor::MakeFIFOThreadPool(int threads, bool allowBorrowing) {
     using WorkList = std::deque<std::function<void(void)>>;
     return std::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores(),
@@ -149,3 +297,8 @@ std::unique_ptr<SkExecutor> SkExecutor::MakeLIFOThreadPool(int threads, bool all
     return std::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores(),
                                                     allowBorrowing);
 }
+std::unique_ptr<SkExecutor> SkExecutor::MakeWorkStealingThreadPool(int threads,
+                                                                   bool allowBorrowing) {
+    return std::make_unique<SkWorkStealingThreadPool>(threads > 0 ? threads : num_cores(),
+                                                      allowBorrowing);
+}
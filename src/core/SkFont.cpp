@@ -230,6 +230,37 @@ void SkFont::getWidthsBounds(const SkGlyphID glyphIDs[],
     }
 }
 
+void SkFont::getConservativeBounds(const SkGlyphID glyphIDs[], int count, SkRect bounds[]) const {
+    SkAutoSTMalloc<64, bool> found(count);
+    sk_bzero(found.get(), count * sizeof(bool));
+    if (!this->isEmbolden()) {
+        this->getTypefaceOrDefault()->onGetColorGlyphBounds(glyphIDs, count, bounds, found.get());
+    }
+
+    const SkMatrix textMatrix = SkFontPriv::MakeTextMatrix(*this);
+    SkAutoSTMalloc<64, SkGlyphID> others(count);
+    int otherCount = 0;
+    for (int i = 0; i < count; ++i) {
+        if (found[i]) {
+            textMatrix.mapRect(&bounds[i]);
+        } else {
+            others[otherCount++] = glyphIDs[i];
+        }
+    }
+    if (otherCount == 0) {
+        return;
+    }
+
+    // Measure the rest in one batch, and scatter their bounds back in place.
+    SkAutoSTMalloc<64, SkRect> otherBounds(otherCount);
+    this->getBounds(others.get(), otherCount, otherBounds.get(), nullptr);
+    for (int i = 0, j = 0; i < count; ++i) {
+        if (!found[i]) {
+            bounds[i] = otherBounds[j++];
+        }
+    }
+}
+
 void SkFont::getPos(const SkGlyphID glyphIDs[], int count, SkPoint pos[], SkPoint origin) const {
     SkStrikeSpec strikeSpec = SkStrikeSpec::MakeCanonicalized(*this);
     SkBulkGlyphMetrics metrics{strikeSpec};
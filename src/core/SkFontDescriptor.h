@@ -15,6 +15,8 @@
 #include "include/private/SkNoncopyable.h"
 #include "include/private/SkTemplates.h"
 
+#include <vector>
+
 class SkFontData {
 public:
     /** Makes a copy of the data in 'axis'. */
@@ -29,6 +31,9 @@ public:
         : fStream(std::move(stream)), fIndex(args.getCollectionIndex())
         , fAxisCount(args.getVariationDesignPosition().coordinateCount)
         , fAxis(args.getVariationDesignPosition().coordinateCount)
+        , fPaletteIndex(args.getPalette().index)
+        , fPaletteOverrides(args.getPalette().overrides,
+                            args.getPalette().overrides + args.getPalette().overrideCount)
     {
         for (int i = 0; i < fAxisCount; ++i) {
             fAxis[i] = SkFloatToFixed(args.getVariationDesignPosition().coordinates[i].value);
@@ -39,6 +44,8 @@ public:
         , fIndex(that.fIndex)
         , fAxisCount(that.fAxisCount)
         , fAxis(fAxisCount)
+        , fPaletteIndex(that.fPaletteIndex)
+        , fPaletteOverrides(that.fPaletteOverrides)
     {
         for (int i = 0; i < fAxisCount; ++i) {
             fAxis[i] = that.fAxis[i];
@@ -52,11 +59,23 @@ public:
     int getAxisCount() const { return fAxisCount; }
     const SkFixed* getAxis() const { return fAxis.get(); }
 
+    int getPaletteIndex() const { return fPaletteIndex; }
+    const std::vector<SkFontArguments::Palette::Override>& getPaletteOverrides() const {
+        return fPaletteOverrides;
+    }
+    /** Makes a copy of the overrides of 'palette'. */
+    void setPalette(const SkFontArguments::Palette& palette) {
+        fPaletteIndex = palette.index;
+        fPaletteOverrides.assign(palette.overrides, palette.overrides + palette.overrideCount);
+    }
+
 private:
     std::unique_ptr<SkStreamAsset> fStream;
     int fIndex;
     int fAxisCount;
     SkAutoSTMalloc<4, SkFixed> fAxis;
+    int fPaletteIndex = 0;
+    std::vector<SkFontArguments::Palette::Override> fPaletteOverrides;
 };
 
 class SkFontDescriptor : SkNoncopyable {
@@ -18,6 +18,7 @@
 #include "src/core/SkMathPriv.h"
 
 class SkArenaAlloc;
+class SkDrawable;
 class SkScalerContext;
 
 // A combination of SkGlyphID and sub-pixel position information.
@@ -299,6 +300,24 @@ public:
     // path was previously set.
     const SkPath* path() const;
 
+    // Drawable
+    // If we haven't already tried to associate a drawable with this glyph
+    // (i.e. setDrawableHasBeenCalled() returns false), then use the
+    // SkScalerContext or SkDrawable argument to try to do so. Like setPath(),
+    // this call is sticky.
+    //
+    // Returns true if this is the first time you called setDrawable()
+    // and there actually is a drawable; call drawable() to get it.
+    bool setDrawable(SkArenaAlloc* alloc, SkScalerContext* scalerContext);
+    bool setDrawable(SkArenaAlloc* alloc, sk_sp<SkDrawable> drawable);
+
+    // Returns true if that drawable has been set.
+    bool setDrawableHasBeenCalled() const { return fDrawableData != nullptr; }
+
+    // Return a pointer to the drawable if it exists, otherwise return nullptr. Only works if the
+    // drawable was previously set. Like the path, the drawable draws in strike space.
+    SkDrawable* drawable() const;
+
     // Format
     bool isColor() const { return fMaskFormat == SkMask::kARGB32_Format; }
     SkMask::Format maskFormat() const { return fMaskFormat; }
@@ -338,6 +357,7 @@ private:
     // consumer side has a tighter interface.
     friend class RandomScalerContext;
     friend class RemoteStrike;
+    friend class SkGlyphDiskCache;
     friend class SkScalerContext;
     friend class SkScalerContextProxy;
     friend class SkScalerContext_Empty;
@@ -372,11 +392,18 @@ private:
         bool       fHasPath{false};
     };
 
+    struct DrawableData {
+        sk_sp<SkDrawable> fDrawable;
+    };
+
     size_t allocImage(SkArenaAlloc* alloc);
 
     // path == nullptr indicates that there is no path.
     void installPath(SkArenaAlloc* alloc, const SkPath* path);
 
+    // drawable == nullptr indicates that there is no drawable.
+    void installDrawable(SkArenaAlloc* alloc, sk_sp<SkDrawable> drawable);
+
     // The width and height of the glyph mask.
     uint16_t  fWidth  = 0,
               fHeight = 0;
@@ -393,6 +420,10 @@ private:
     // may still be null after the request meaning that there is no path for this glyph.
     PathData* fPathData = nullptr;
 
+    // If fDrawableData is not null, then a drawable has been requested. Its fDrawable may still
+    // be null, meaning that the glyph can not be drawn as a drawable.
+    DrawableData* fDrawableData = nullptr;
+
     // The advance for this glyph.
     float     fAdvanceX = 0,
               fAdvanceY = 0;
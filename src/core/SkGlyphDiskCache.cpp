@@ -0,0 +1,262 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkGlyphDiskCache.h"
+
+#include "include/core/SkStream.h"
+#include "include/private/SkTemplates.h"
+#include "src/core/SkDescriptor.h"
+#include "src/core/SkOSFile.h"
+#include "src/core/SkReadBuffer.h"
+#include "src/core/SkScalerCache.h"
+#include "src/core/SkScalerContext.h"
+#include "src/core/SkStreamPriv.h"
+#include "src/core/SkWriteBuffer.h"
+#include "src/utils/SkOSPath.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace {
+
+static constexpr uint32_t kMagic = SkSetFourByteTag('s', 'k', 'g', 'c');
+
+// Everything before the payload. The checksum covers the payload; it is an MD5 rather than
+// SkOpts::hash because the result of the latter depends on the CPU of the machine writing it.
+struct FileHeader {
+    uint32_t      fMagic;
+    uint32_t      fVersion;
+    uint32_t      fPayloadSize;
+    SkMD5::Digest fPayloadChecksum;
+};
+
+static constexpr uint32_t kHasImage_GlyphFlag = 1 << 0;
+static constexpr uint32_t kPathSet_GlyphFlag  = 1 << 1;
+static constexpr uint32_t kHasPath_GlyphFlag  = 1 << 2;
+
+SkMD5::Digest payload_checksum(const void* payload, size_t size) {
+    SkMD5 md5;
+    md5.write(payload, size);
+    return md5.finish();
+}
+
+// Typeface ids are only unique within a process, so files are keyed by a descriptor without one.
+SkDescriptor* canonical_descriptor(const SkDescriptor& desc, SkAutoDescriptor* ad) {
+    ad->reset(desc);
+    SkDescriptor* canonical = ad->getDesc();
+    uint32_t size;
+    auto rec = (SkScalerContextRec*)canonical->findEntry(kRec_SkDescriptorTag, &size);
+    if (rec == nullptr || size != sizeof(SkScalerContextRec)) {
+        return nullptr;
+    }
+    rec->fFontID = 0;
+    canonical->computeChecksum();
+    return canonical;
+}
+
+}  // namespace
+
+sk_sp<SkGlyphDiskCache> SkGlyphDiskCache::Make(const char directory[]) {
+    if (directory == nullptr || (!sk_isdir(directory) && !sk_mkdir(directory))) {
+        return nullptr;
+    }
+    return sk_sp<SkGlyphDiskCache>(new SkGlyphDiskCache(SkString(directory)));
+}
+
+bool SkGlyphDiskCache::fontDigest(const SkTypeface& typeface, SkMD5::Digest* digest) {
+    {
+        SkAutoMutexExclusive lock(fDigestMutex);
+        if (const SkMD5::Digest* found = fDigests.find(typeface.uniqueID())) {
+            *digest = *found;
+            return true;
+        }
+    }
+
+    int ttcIndex;
+    std::unique_ptr<SkStreamAsset> stream = typeface.openStream(&ttcIndex);
+    if (stream == nullptr) {
+        return false;
+    }
+    SkMD5 md5;
+    if (!SkStreamCopy(&md5, stream.get())) {
+        return false;
+    }
+    md5.write(&ttcIndex, sizeof(ttcIndex));
+    int axisCount = typeface.getVariationDesignPosition(nullptr, 0);
+    if (axisCount > 0) {
+        SkAutoSTMalloc<4, SkFontArguments::VariationPosition::Coordinate> axes(axisCount);
+        if (typeface.getVariationDesignPosition(axes.get(), axisCount) == axisCount) {
+            md5.write(axes.get(), axisCount * sizeof(axes[0]));
+        }
+    }
+    *digest = md5.finish();
+
+    SkAutoMutexExclusive lock(fDigestMutex);
+    fDigests.set(typeface.uniqueID(), *digest);
+    return true;
+}
+
+SkString SkGlyphDiskCache::path(const SkDescriptor& canonicalDesc,
+                                const SkMD5::Digest& digest) const {
+    SkString name = SkStringPrintf("%08x-", canonicalDesc.getChecksum());
+    for (int i = 0; i < 8; ++i) {
+        name.appendf("%02x", digest.data[i]);
+    }
+    name.append(".glyphs");
+    return SkOSPath::Join(fDirectory.c_str(), name.c_str());
+}
+
+std::unique_ptr<SkGlyphDiskCache::Strike> SkGlyphDiskCache::load(const SkDescriptor& desc,
+                                                                 const SkTypeface& typeface) {
+    SkAutoDescriptor ad;
+    SkMD5::Digest digest;
+    const SkDescriptor* canonical = canonical_descriptor(desc, &ad);
+    if (canonical == nullptr || !this->fontDigest(typeface, &digest)) {
+        return nullptr;
+    }
+
+    sk_sp<SkData> data = SkData::MakeFromFileName(this->path(*canonical, digest).c_str());
+    if (data == nullptr || data->size() < sizeof(FileHeader)) {
+        return nullptr;
+    }
+    FileHeader header;
+    memcpy(&header, data->data(), sizeof(header));
+    const uint8_t* payload = data->bytes() + sizeof(FileHeader);
+    if (header.fMagic != kMagic || header.fVersion != kVersion ||
+        header.fPayloadSize != data->size() - sizeof(FileHeader) ||
+        header.fPayloadChecksum != payload_checksum(payload, header.fPayloadSize)) {
+        return nullptr;
+    }
+
+    SkReadBuffer buffer(payload, header.fPayloadSize);
+    SkMD5::Digest savedDigest;
+    if (!buffer.readPad32(&savedDigest, sizeof(savedDigest)) || savedDigest != digest) {
+        return nullptr;
+    }
+    // The file name only has a hash of the descriptor, so check the whole descriptor.
+    size_t descLength;
+    const void* savedDesc = buffer.skipByteArray(&descLength);
+    if (savedDesc == nullptr || descLength != canonical->getLength() ||
+        memcmp(savedDesc, canonical, descLength) != 0) {
+        return nullptr;
+    }
+
+    auto strike = std::make_unique<Strike>();
+    if (!buffer.readPad32(&strike->fFontMetrics, sizeof(SkFontMetrics))) {
+        return nullptr;
+    }
+    uint32_t glyphCount = buffer.readUInt();
+    if (!buffer.validateCanReadN<uint32_t>(glyphCount)) {
+        return nullptr;
+    }
+    strike->fGlyphs.reserve(glyphCount);
+    for (uint32_t i = 0; i < glyphCount && buffer.isValid(); ++i) {
+        SkGlyph& glyph = strike->fGlyphs.emplace_back(SkPackedGlyphID(buffer.readUInt()));
+        glyph.fAdvanceX = buffer.readScalar();
+        glyph.fAdvanceY = buffer.readScalar();
+        glyph.fWidth    = SkTo<uint16_t>(buffer.checkInt(0, UINT16_MAX));
+        glyph.fHeight   = SkTo<uint16_t>(buffer.checkInt(0, UINT16_MAX));
+        glyph.fTop      = SkTo<int16_t>(buffer.checkInt(INT16_MIN, INT16_MAX));
+        glyph.fLeft     = SkTo<int16_t>(buffer.checkInt(INT16_MIN, INT16_MAX));
+        glyph.fMaskFormat = buffer.checkRange(SkMask::kBW_Format, SkMask::kSDF_Format);
+        uint32_t flags = buffer.readUInt();
+
+        if (flags & kHasImage_GlyphFlag) {
+            size_t imageSize;
+            const void* image = buffer.skipByteArray(&imageSize);
+            if (!buffer.validate(image != nullptr && !glyph.isEmpty() &&
+                                 imageSize == glyph.imageSize())) {
+                break;
+            }
+            glyph.fImage = const_cast<void*>(image);
+        }
+        if (flags & kPathSet_GlyphFlag) {
+            SkPath path;
+            if (flags & kHasPath_GlyphFlag) {
+                buffer.readPath(&path);
+            }
+            glyph.setPath(&strike->fPathAlloc, (flags & kHasPath_GlyphFlag) ? &path : nullptr);
+        }
+    }
+    if (!buffer.isValid() || !buffer.eof()) {
+        return nullptr;
+    }
+
+    strike->fData = std::move(data);
+    return strike;
+}
+
+bool SkGlyphDiskCache::save(const SkScalerCache& cache, const SkTypeface& typeface) {
+    SkAutoDescriptor ad;
+    SkMD5::Digest digest;
+    const SkDescriptor* canonical = canonical_descriptor(cache.getDescriptor(), &ad);
+    if (canonical == nullptr || !this->fontDigest(typeface, &digest)) {
+        return false;
+    }
+
+    SkBinaryWriteBuffer buffer;
+    buffer.writePad32(&digest, sizeof(digest));
+    buffer.writeByteArray(canonical, canonical->getLength());
+    buffer.writePad32(&cache.getFontMetrics(), sizeof(SkFontMetrics));
+
+    // The glyphs are written to a buffer of their own because their count is only known after
+    // the walk.
+    SkBinaryWriteBuffer glyphs;
+    uint32_t glyphCount = 0;
+    cache.forEachGlyph([&](const SkGlyph& glyph) {
+        glyphs.writeUInt(glyph.getPackedID().value());
+        glyphs.writeScalar(glyph.advanceX());
+        glyphs.writeScalar(glyph.advanceY());
+        glyphs.writeInt(glyph.width());
+        glyphs.writeInt(glyph.height());
+        glyphs.writeInt(glyph.top());
+        glyphs.writeInt(glyph.left());
+        glyphs.writeUInt(glyph.maskFormat());
+
+        // Glyphs too large for a mask have metrics, but no image.
+        const bool hasImage = glyph.setImageHasBeenCalled() && glyph.image() != nullptr;
+        const bool pathSet = glyph.setPathHasBeenCalled();
+        const SkPath* path = pathSet ? glyph.path() : nullptr;
+        glyphs.writeUInt((hasImage ? kHasImage_GlyphFlag : 0u) |
+                         (pathSet  ? kPathSet_GlyphFlag  : 0u) |
+                         (path     ? kHasPath_GlyphFlag  : 0u));
+        if (hasImage) {
+            glyphs.writeByteArray(glyph.image(), glyph.imageSize());
+        }
+        if (path) {
+            glyphs.writePath(*path);
+        }
+        glyphCount += 1;
+    });
+    sk_sp<SkData> glyphData = glyphs.snapshotAsData();
+    buffer.writeUInt(glyphCount);
+    buffer.writePad32(glyphData->data(), glyphData->size());
+
+    sk_sp<SkData> payload = buffer.snapshotAsData();
+    FileHeader header = {kMagic, kVersion, SkTo<uint32_t>(payload->size()),
+                         payload_checksum(payload->data(), payload->size())};
+
+    // Write to a temporary file and move it into place, so that readers, including other
+    // processes, never see a partially written file. The process id and a counter keep the
+    // temporary names of concurrent writers, in this process or another, apart.
+    static std::atomic<uint32_t> gTempCounter{0};
+    SkString path = this->path(*canonical, digest);
+    SkString tempPath = SkStringPrintf("%s.%d.%u.tmp", path.c_str(), sk_getpid(),
+                                       gTempCounter.fetch_add(1, std::memory_order_relaxed));
+    FILE* file = sk_fopen(tempPath.c_str(), kWrite_SkFILE_Flag);
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = sk_fwrite(&header, sizeof(header), file) == sizeof(header) &&
+                   sk_fwrite(payload->data(), payload->size(), file) == payload->size();
+    sk_fclose(file);
+    if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
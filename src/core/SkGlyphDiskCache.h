@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGlyphDiskCache_DEFINED
+#define SkGlyphDiskCache_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkFontMetrics.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSpan.h"
+#include "include/core/SkString.h"
+#include "include/core/SkTypeface.h"
+#include "include/private/SkMutex.h"
+#include "include/private/SkTHash.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkGlyph.h"
+#include "src/core/SkMD5.h"
+
+#include <memory>
+#include <vector>
+
+class SkDescriptor;
+class SkScalerCache;
+
+/**
+ *  Keeps the glyphs of strikes in a directory so that they survive the process. Each strike is
+ *  stored in a file of its own, named after the hash of its descriptor and a digest of the font
+ *  data, and holds the font metrics and the metrics, images and paths of the strike's glyphs.
+ *
+ *  Files are memory mapped when read. A file is only used if its format version, checksum,
+ *  descriptor and font digest all match; anything else is treated as a miss.
+ */
+class SkGlyphDiskCache : public SkRefCnt {
+public:
+    // Returns nullptr if directory does not exist and can not be created.
+    static sk_sp<SkGlyphDiskCache> Make(const char directory[]);
+
+    // The contents of a strike's file. Images point into the mapped file.
+    class Strike {
+    public:
+        const SkFontMetrics& fontMetrics() const { return fFontMetrics; }
+        SkSpan<const SkGlyph> glyphs() const { return SkMakeSpan(fGlyphs); }
+
+    private:
+        friend class SkGlyphDiskCache;
+
+        sk_sp<SkData>        fData;
+        SkFontMetrics        fFontMetrics;
+        std::vector<SkGlyph> fGlyphs;
+        SkArenaAlloc         fPathAlloc{1024};
+    };
+
+    // Returns nullptr if there is no usable file for desc.
+    std::unique_ptr<Strike> load(const SkDescriptor& desc, const SkTypeface& typeface);
+
+    // Replaces the file of cache's strike with its current glyphs. Returns false if the file
+    // could not be written.
+    bool save(const SkScalerCache& cache, const SkTypeface& typeface);
+
+    // Bumped whenever the file layout, or the layout of anything stored raw, changes.
+    static constexpr uint32_t kVersion = 2;
+
+private:
+    explicit SkGlyphDiskCache(SkString directory) : fDirectory(std::move(directory)) {}
+
+    // Identifies the font data, collection index and variation of typeface. Returns false if
+    // the font data is not available.
+    bool fontDigest(const SkTypeface& typeface, SkMD5::Digest* digest);
+    SkString path(const SkDescriptor& canonicalDesc, const SkMD5::Digest& digest) const;
+
+    const SkString fDirectory;
+
+    SkMutex fDigestMutex;
+    SkTHashMap<SkFontID, SkMD5::Digest> fDigests SK_GUARDED_BY(fDigestMutex);
+};
+
+#endif  // SkGlyphDiskCache_DEFINED
@@ -120,6 +120,16 @@ void SkGlyphRunListPainter::drawForBitmapDevice(
 
             bitmapDevice->paintPaths(
                     &fDrawable, strikeSpec.strikeToSourceRatio(), drawOrigin, pathPaint);
+
+            // Color glyphs have no path. Rather than rasterizing them into a strike for each
+            // size, draw them from their drawable, which the path strike shares across sizes.
+            if (!fRejects.source().empty()) {
+                fDrawable.startSource(fRejects.source());
+                strike->prepareForDrawableDrawing(&fDrawable, &fRejects);
+                fRejects.flipRejectsToSource();
+                bitmapDevice->paintDrawables(
+                        &fDrawable, strikeSpec.strikeToSourceRatio(), drawOrigin, paint);
+            }
         }
         if (!fRejects.source().empty() && !deviceMatrix.hasPerspective()) {
             SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
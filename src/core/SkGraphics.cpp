@@ -120,6 +120,22 @@ int SkGraphics::GetFontCacheCountUsed() {
     return SkStrikeCache::GlobalStrikeCache()->getCacheCountUsed();
 }
 
+bool SkGraphics::SetFontCacheDirectory(const char directory[]) {
+    sk_sp<SkGlyphDiskCache> diskCache;
+    if (directory != nullptr) {
+        diskCache = SkGlyphDiskCache::Make(directory);
+        if (diskCache == nullptr) {
+            return false;
+        }
+    }
+    SkStrikeCache::GlobalStrikeCache()->setDiskCache(std::move(diskCache));
+    return true;
+}
+
+void SkGraphics::SaveFontCache() {
+    SkStrikeCache::GlobalStrikeCache()->saveToDiskCache();
+}
+
 void SkGraphics::PurgeFontCache() {
     SkStrikeCache::GlobalStrikeCache()->purgeAll();
     SkTypefaceCache::PurgeAll();
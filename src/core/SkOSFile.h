@@ -76,6 +76,9 @@ size_t sk_qread(FILE*, void* buffer, size_t count, size_t offset);
 // Description of the error, if any, will be written to stderr.
 bool    sk_mkdir(const char* path);
 
+// Returns the id of the calling process, e.g. to name files no other process writes.
+int     sk_getpid();
+
 class SkOSFile {
 public:
     class Iter {
@@ -61,6 +61,18 @@ public:
         }
     }
 
+    void paintDrawables(SkDrawableGlyphBuffer* drawables, SkScalar scale, SkPoint origin,
+                        const SkPaint& paint) const override {
+        // Drawables are in strike space; the canvas maps their bounds on to the device.
+        for (auto [variant, pos] : drawables->drawable()) {
+            SkMatrix m;
+            SkPoint translate = origin + pos;
+            m.setScaleTranslate(scale, scale, translate.x(), translate.y());
+            fOverdrawCanvas->drawRect(m.mapRect(variant.glyph()->drawable()->getBounds()),
+                                      SkPaint());
+        }
+    }
+
     void    drawBitmap(const SkBitmap&, const SkMatrix&, const SkRect* dstOrNull,
                        const SkSamplingOptions&, const SkPaint&) const override {}
 
@@ -7,13 +7,17 @@
 
 #include "src/core/SkRTree.h"
 
-SkRTree::SkRTree() : fCount(0) {}
+#include "include/private/SkNx.h"
+#include "src/core/SkMathPriv.h"
+
+SkRTree::SkRTree() : fCount(0), fRootBounds(SkRect::MakeEmpty()) {}
 
 void SkRTree::insert(const SkRect boundsArray[], int N) {
     SkASSERT(0 == fCount);
 
     std::vector<Branch> branches;
     branches.reserve(N);
+    fOps.reserve(N);
 
     for (int i = 0; i < N; i++) {
         const SkRect& bounds = boundsArray[i];
@@ -23,31 +27,27 @@ void SkRTree::insert(const SkRect boundsArray[], int N) {
 
         Branch b;
         b.fBounds = bounds;
-        b.fOpIndex = i;
+        b.fIndex = (int)fOps.size();
         branches.push_back(b);
+        fOps.push_back(i);
     }
 
     fCount = (int)branches.size();
     if (fCount) {
-        if (1 == fCount) {
-            fNodes.reserve(1);
-            Node* n = this->allocateNodeAtLevel(0);
-            n->fNumChildren = 1;
-            n->fChildren[0] = branches[0];
-            fRoot.fSubtree = n;
-            fRoot.fBounds  = branches[0].fBounds;
-        } else {
-            fNodes.reserve(CountNodes(fCount));
-            fRoot = this->bulkLoad(&branches);
-        }
+        fNodes.reserve(CountNodes(fCount));
+        fRootBounds = this->bulkLoad(&branches).fBounds;
     }
 }
 
-SkRTree::Node* SkRTree::allocateNodeAtLevel(uint16_t level) {
-    SkDEBUGCODE(Node* p = fNodes.data());
+SkRTree::Node* SkRTree::allocateNodeAtLevel(uint16_t level, int firstChild) {
     fNodes.push_back(Node{});
     Node& out = fNodes.back();
-    SkASSERT(fNodes.data() == p);  // If this fails, we didn't reserve() enough.
+    for (int i = 0; i < kPaddedChildren; ++i) {
+        // Left above right and top below bottom, even for infinite queries.
+        out.fLeft  [i] = out.fTop   [i] = +SK_ScalarInfinity;
+        out.fRight [i] = out.fBottom[i] = -SK_ScalarInfinity;
+    }
+    out.fFirstChild = firstChild;
     out.fNumChildren = 0;
     out.fLevel = level;
     return &out;
@@ -91,7 +91,8 @@ int SkRTree::CountNodes(int branches) {
 }
 
 SkRTree::Branch SkRTree::bulkLoad(std::vector<Branch>* branches, int level) {
-    if (branches->size() == 1) { // Only one branch.  It will be the root.
+    // Only one branch.  It will be the root, unless it's an op: the root is always a node.
+    if (branches->size() == 1 && level > 0) {
         return (*branches)[0];
     }
 
@@ -125,17 +126,18 @@ SkRTree::Branch SkRTree::bulkLoad(std::vector<Branch>* branches, int level) {
                 remainder -= kMaxChildren - kMinChildren;
             }
         }
-        Node* n = allocateNodeAtLevel(level);
-        n->fNumChildren = 1;
-        n->fChildren[0] = (*branches)[currentBranch];
+        // Each level's branches are consecutive ops or consecutive nodes of the level below, so
+        // a node only needs to know where its children start.
+        Node* n = allocateNodeAtLevel(level, (*branches)[currentBranch].fIndex);
+        n->addChild((*branches)[currentBranch].fBounds);
         Branch b;
         b.fBounds = (*branches)[currentBranch].fBounds;
-        b.fSubtree = n;
+        b.fIndex = (int)fNodes.size() - 1;
         ++currentBranch;
         for (int k = 1; k < incrementBy && currentBranch < (int)branches->size(); ++k) {
+            SkASSERT((*branches)[currentBranch].fIndex == n->fFirstChild + k);
             b.fBounds.join((*branches)[currentBranch].fBounds);
-            n->fChildren[k] = (*branches)[currentBranch];
-            ++n->fNumChildren;
+            n->addChild((*branches)[currentBranch].fBounds);
             ++currentBranch;
         }
         (*branches)[newBranches] = b;
@@ -145,20 +147,37 @@ SkRTree::Branch SkRTree::bulkLoad(std::vector<Branch>* branches, int level) {
     return this->bulkLoad(branches, level + 1);
 }
 
+uint32_t SkRTree::Hits(const Node& node, const SkRect& query) {
+    const Sk4f l(query.fLeft),
+               t(query.fTop),
+               r(query.fRight),
+               b(query.fBottom);
+    uint32_t hits = 0;
+    for (int i = 0; i < node.fNumChildren; i += kLanes) {
+        // The same test as SkRect::Intersects(), four children at a time.
+        const Sk4f L = Sk4f::Max(Sk4f::Load(node.fLeft   + i), l),
+                   T = Sk4f::Max(Sk4f::Load(node.fTop    + i), t),
+                   R = Sk4f::Min(Sk4f::Load(node.fRight  + i), r),
+                   B = Sk4f::Min(Sk4f::Load(node.fBottom + i), b);
+        const Sk4f bits = (L < R).thenElse((T < B).thenElse(Sk4f(1, 2, 4, 8), 0), 0);
+        hits |= (uint32_t)(bits[0] + bits[1] + bits[2] + bits[3]) << i;
+    }
+    return hits;
+}
+
 void SkRTree::search(const SkRect& query, std::vector<int>* results) const {
-    if (fCount > 0 && SkRect::Intersects(fRoot.fBounds, query)) {
-        this->search(fRoot.fSubtree, query, results);
+    if (fCount > 0 && SkRect::Intersects(fRootBounds, query)) {
+        this->search(fNodes.back(), query, results);
     }
 }
 
-void SkRTree::search(Node* node, const SkRect& query, std::vector<int>* results) const {
-    for (int i = 0; i < node->fNumChildren; ++i) {
-        if (SkRect::Intersects(node->fChildren[i].fBounds, query)) {
-            if (0 == node->fLevel) {
-                results->push_back(node->fChildren[i].fOpIndex);
-            } else {
-                this->search(node->fChildren[i].fSubtree, query, results);
-            }
+void SkRTree::search(const Node& node, const SkRect& query, std::vector<int>* results) const {
+    for (uint32_t hits = Hits(node, query); hits; hits &= hits - 1) {
+        const int child = node.fFirstChild + SkCTZ(hits);
+        if (0 == node.fLevel) {
+            results->push_back(fOps[child]);
+        } else {
+            this->search(fNodes[child], query, results);
         }
     }
 }
@@ -167,6 +186,7 @@ size_t SkRTree::bytesUsed() const {
     size_t byteCount = sizeof(SkRTree);
 
     byteCount += fNodes.capacity() * sizeof(Node);
+    byteCount += fOps.capacity() * sizeof(int);
 
     return byteCount;
 }
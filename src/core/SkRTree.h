@@ -18,6 +18,11 @@
  * It only supports bulk-loading, i.e. creation from a batch of bounding rectangles.
  * This performs a bottom-up bulk load using the STR (sort-tile-recursive) algorithm.
  *
+ * The nodes are packed into one array, level by level from the leaves up, and the children of
+ * a node are consecutive in the level below it, so they are found by index rather than by
+ * pointer. Each node keeps the bounds of its children side by side, all the lefts, then all
+ * the tops, and so on, so that a query tests four children at once.
+ *
  * TODO: Experiment with other bulk-load algorithms (in particular the Hilbert pack variant,
  * which groups rects by position on the Hilbert curve, is probably worth a look). There also
  * exist top-down bulk load variants (VAMSplit, TopDownGreedy, etc).
@@ -38,7 +43,7 @@ public:
     // Methods and constants below here are only public for tests.
 
     // Return the depth of the tree structure.
-    int getDepth() const { return fCount ? fRoot.fSubtree->fLevel + 1 : 0; }
+    int getDepth() const { return fCount ? fNodes.back().fLevel + 1 : 0; }
     // Insertion count (not overall node count, which may be greater).
     int getCount() const { return fCount; }
 
@@ -47,23 +52,40 @@ public:
                      kMaxChildren = 11;
 
 private:
-    struct Node;
-
-    struct Branch {
-        union {
-            Node* fSubtree;
-            int fOpIndex;
-        };
-        SkRect fBounds;
-    };
+    // Children are tested against a query this many at a time.
+    static constexpr int kLanes = 4;
+    static constexpr int kPaddedChildren = (kMaxChildren + kLanes - 1) / kLanes * kLanes;
 
     struct Node {
+        // The bounds of the children, by side. Slots past fNumChildren intersect nothing.
+        float fLeft  [kPaddedChildren];
+        float fTop   [kPaddedChildren];
+        float fRight [kPaddedChildren];
+        float fBottom[kPaddedChildren];
+        // The children are fNodes[fFirstChild...], or fOps[fFirstChild...] at level 0.
+        int      fFirstChild;
         uint16_t fNumChildren;
         uint16_t fLevel;
-        Branch fChildren[kMaxChildren];
+
+        void addChild(const SkRect& bounds) {
+            SkASSERT(fNumChildren < kMaxChildren);
+            fLeft  [fNumChildren] = bounds.fLeft;
+            fTop   [fNumChildren] = bounds.fTop;
+            fRight [fNumChildren] = bounds.fRight;
+            fBottom[fNumChildren] = bounds.fBottom;
+            fNumChildren++;
+        }
     };
 
-    void search(Node* root, const SkRect& query, std::vector<int>* results) const;
+    struct Branch {
+        int    fIndex;  // Into fOps while loading level 0, into fNodes above that.
+        SkRect fBounds;
+    };
+
+    // Returns a bit for each child of node whose bounds intersect query, the first child lowest.
+    static uint32_t Hits(const Node& node, const SkRect& query);
+
+    void search(const Node& node, const SkRect& query, std::vector<int>* results) const;
 
     // Consumes the input array.
     Branch bulkLoad(std::vector<Branch>* branches, int level = 0);
@@ -71,12 +93,15 @@ private:
     // How many times will bulkLoad() call allocateNodeAtLevel()?
     static int CountNodes(int branches);
 
-    Node* allocateNodeAtLevel(uint16_t level);
+    Node* allocateNodeAtLevel(uint16_t level, int firstChild);
 
     // This is the count of data elements (rather than total nodes in the tree)
     int fCount;
-    Branch fRoot;
+    SkRect fRootBounds;
+    // The root is the last node.
     std::vector<Node> fNodes;
+    // The op indices of the leaves' children, in order.
+    std::vector<int> fOps;
 };
 
 #endif
@@ -91,8 +91,10 @@ class SkData;
     M(clamp_x_1) M(mirror_x_1) M(repeat_x_1)                       \
     M(evenly_spaced_gradient)                                      \
     M(gradient)                                                    \
+    M(indexed_gradient)                                            \
     M(evenly_spaced_2_stop_gradient)                               \
     M(xy_to_unit_angle)                                            \
+    M(xy_to_sweep_window)                                          \
     M(xy_to_radius)                                                \
     M(xy_to_2pt_conical_strip)                                     \
     M(xy_to_2pt_conical_focal_on_circle)                           \
@@ -168,6 +170,9 @@ struct SkRasterPipeline_GradientCtx {
     float* bs[4];
     float* ts;
     bool interpolatedInPremul;
+    // indexed_gradient only: cells[i] is the number of stops below t = i/cellCount, a power of 2.
+    const uint32_t* cells;
+    uint32_t cellCount;
 };
 
 struct SkRasterPipeline_EvenlySpaced2StopGradientCtx {
@@ -7,6 +7,7 @@
 
 #include "src/core/SkScalerCache.h"
 
+#include "include/core/SkDrawable.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkTypeface.h"
@@ -68,6 +69,14 @@ std::tuple<const SkPath*, size_t> SkScalerCache::preparePath(SkGlyph* glyph) {
     return {glyph->path(), delta};
 }
 
+std::tuple<SkDrawable*, size_t> SkScalerCache::prepareDrawable(SkGlyph* glyph) {
+    size_t delta = 0;
+    if (glyph->setDrawable(&fAlloc, fScalerContext.get())) {
+        delta = glyph->drawable()->approximateBytesUsed();
+    }
+    return {glyph->drawable(), delta};
+}
+
 std::tuple<const SkPath*, size_t> SkScalerCache::mergePath(SkGlyph* glyph, const SkPath* path) {
     SkAutoMutexExclusive lock{fMu};
     size_t pathDelta = 0;
@@ -86,6 +95,13 @@ int SkScalerCache::countCachedGlyphs() const {
     return fDigestForPackedGlyphID.count();
 }
 
+void SkScalerCache::forEachGlyph(const std::function<void(const SkGlyph&)>& fn) const {
+    SkAutoMutexExclusive lock(fMu);
+    for (const SkGlyph* glyph : fGlyphForIndex) {
+        fn(*glyph);
+    }
+}
+
 std::tuple<SkSpan<const SkGlyph*>, size_t> SkScalerCache::internalPrepare(
         SkSpan<const SkGlyphID> glyphIDs, PathDetail pathDetail, const SkGlyph** results) {
     const SkGlyph** cursor = results;
@@ -130,6 +146,23 @@ std::tuple<SkGlyph*, size_t> SkScalerCache::mergeGlyphAndImage(
     }
 }
 
+size_t SkScalerCache::mergeGlyphsAndImages(SkSpan<const SkGlyph> from) {
+    SkAutoMutexExclusive lock{fMu};
+    size_t delta = 0;
+    for (const SkGlyph& fromGlyph : from) {
+        if (fDigestForPackedGlyphID.find(fromGlyph.getPackedID()) != nullptr) {
+            continue;
+        }
+        SkGlyph* glyph = fAlloc.make<SkGlyph>(fromGlyph.getPackedID());
+        delta += sizeof(SkGlyph) + glyph->setMetricsAndImage(&fAlloc, fromGlyph);
+        if (fromGlyph.setPathHasBeenCalled() && glyph->setPath(&fAlloc, fromGlyph.path())) {
+            delta += glyph->path()->approximateBytesUsed();
+        }
+        (void)this->addGlyph(glyph);
+    }
+    return delta;
+}
+
 std::tuple<SkSpan<const SkGlyph*>, size_t> SkScalerCache::metrics(
         SkSpan<const SkGlyphID> glyphIDs, const SkGlyph* results[]) {
     SkAutoMutexExclusive lock{fMu};
@@ -248,6 +281,25 @@ size_t SkScalerCache::prepareForPathDrawing(
     return delta + pathDelta;
 }
 
+size_t SkScalerCache::prepareForDrawableDrawing(
+        SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) {
+    SkAutoMutexExclusive lock{fMu};
+    size_t drawableDelta = 0;
+    size_t delta = this->commonFilterLoop(drawables,
+        [&](size_t i, SkGlyphDigest digest, SkPoint pos) SK_REQUIRES(fMu) {
+            SkGlyph* glyph = fGlyphForIndex[digest.index()];
+            auto [drawable, drawableSize] = this->prepareDrawable(glyph);
+            drawableDelta += drawableSize;
+            if (drawable != nullptr) {
+                drawables->push_back(glyph, i);
+            } else {
+                rejects->reject(i, glyph->maxDimension());
+            }
+        });
+
+    return delta + drawableDelta;
+}
+
 void SkScalerCache::findIntercepts(const SkScalar bounds[2], SkScalar scale, SkScalar xPos,
         SkGlyph* glyph, SkScalar* array, int* count) {
     SkAutoMutexExclusive lock{fMu};
@@ -17,6 +17,7 @@
 #include "src/core/SkGlyph.h"
 #include "src/core/SkGlyphRunPainter.h"
 #include "src/core/SkStrikeForGPU.h"
+#include <functional>
 #include <memory>
 
 class SkScalerContext;
@@ -63,6 +64,11 @@ public:
     std::tuple<SkGlyph*, size_t> mergeGlyphAndImage(
             SkPackedGlyphID toID, const SkGlyph& from) SK_EXCLUDES(fMu);
 
+    // Add glyphs made by another scaler context for the same descriptor, along with their
+    // images and paths, in one batch. Glyphs which are already cached are left as they are.
+    // Return the number of bytes added.
+    size_t mergeGlyphsAndImages(SkSpan<const SkGlyph> from) SK_EXCLUDES(fMu);
+
     // If the path has never been set, then add a path to glyph.
     std::tuple<const SkPath*, size_t> mergePath(
             SkGlyph* glyph, const SkPath* path) SK_EXCLUDES(fMu);
@@ -70,6 +76,10 @@ public:
     /** Return the number of glyphs currently cached. */
     int countCachedGlyphs() const SK_EXCLUDES(fMu);
 
+    // Call fn with each cached glyph. The cache is locked for the duration, so fn must not call
+    // back into it.
+    void forEachGlyph(const std::function<void(const SkGlyph&)>& fn) const SK_EXCLUDES(fMu);
+
     /** If the advance axis intersects the glyph's path, append the positions scaled and offset
         to the array (if non-null), and set the count to the updated array length.
     */
@@ -107,6 +117,10 @@ public:
     size_t prepareForPathDrawing(
             SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) SK_EXCLUDES(fMu);
 
+    // Add the glyphs which have a drawable to drawables, and reject the rest.
+    size_t prepareForDrawableDrawing(
+            SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) SK_EXCLUDES(fMu);
+
     void dump() const SK_EXCLUDES(fMu);
 
     SkScalerContext* getScalerContext() const { return fScalerContext.get(); }
@@ -129,6 +143,9 @@ private:
     // If the path has never been set, then use the scaler context to add the glyph.
     std::tuple<const SkPath*, size_t> preparePath(SkGlyph*) SK_REQUIRES(fMu);
 
+    // If the drawable has never been set, then use the scaler context to add it to the glyph.
+    std::tuple<SkDrawable*, size_t> prepareDrawable(SkGlyph*) SK_REQUIRES(fMu);
+
     enum PathDetail {
         kMetricsOnly,
         kMetricsAndPath
@@ -8,6 +8,7 @@
 #include "include/core/SkPaint.h"
 #include "src/core/SkScalerContext.h"
 
+#include "include/core/SkDrawable.h"
 #include "include/core/SkFontMetrics.h"
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkPathEffect.h"
@@ -692,6 +693,18 @@ bool SkScalerContext::getPath(SkPackedGlyphID glyphID, SkPath* path) {
     return this->internalGetPath(glyphID, path, nullptr);
 }
 
+sk_sp<SkDrawable> SkScalerContext::getDrawable(const SkGlyph& glyph) {
+    // Path effects, strokes and mask filters are applied to paths, which a drawable does not have.
+    if (fPathEffect != nullptr || fMaskFilter != nullptr || fRec.fFrameWidth > 0) {
+        return nullptr;
+    }
+    return this->generateDrawable(glyph);
+}
+
+sk_sp<SkDrawable> SkScalerContext::generateDrawable(const SkGlyph&) {
+    return nullptr;
+}
+
 void SkScalerContext::getFontMetrics(SkFontMetrics* fm) {
     SkASSERT(fm);
     this->generateFontMetrics(fm);
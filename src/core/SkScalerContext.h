@@ -26,6 +26,7 @@
 
 class SkAutoDescriptor;
 class SkDescriptor;
+class SkDrawable;
 class SkMaskFilter;
 class SkPathEffect;
 class SkScalerContext;
@@ -287,6 +288,8 @@ public:
     SkGlyph     makeGlyph(SkPackedGlyphID);
     void        getImage(const SkGlyph&);
     bool SK_WARN_UNUSED_RESULT getPath(SkPackedGlyphID, SkPath*);
+    // Returns nullptr if the glyph can not be drawn as a drawable, see generateDrawable().
+    sk_sp<SkDrawable> getDrawable(const SkGlyph&);
     void        getFontMetrics(SkFontMetrics*);
 
     /** Return the size in bytes of the associated gamma lookup table
@@ -389,6 +392,13 @@ protected:
      */
     virtual bool SK_WARN_UNUSED_RESULT generatePath(SkGlyphID glyphId, SkPath* path) = 0;
 
+    /** Returns a drawable which draws the glyph in strike space at any scale, or nullptr.
+     *  This is for color glyphs without a path, which are otherwise only available as images.
+     *  Because the drawable is scaled instead of the strike, it should not depend on hinting.
+     *  The default returns nullptr.
+     */
+    virtual sk_sp<SkDrawable> generateDrawable(const SkGlyph&);
+
     /** Retrieves font metrics. */
     virtual void generateFontMetrics(SkFontMetrics*) = 0;
 
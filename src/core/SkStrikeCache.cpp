@@ -17,6 +17,8 @@
 #include "include/private/SkTemplates.h"
 #include "src/core/SkGlyphRunPainter.h"
 #include "src/core/SkScalerCache.h"
+#include "src/core/SkStrikeSpec.h"
+#include "src/core/SkTaskGroup.h"
 
 bool gSkUseThreadLocalStrikeCaches_IAcknowledgeThisIsIncrediblyExperimental = false;
 
@@ -32,13 +34,38 @@ SkStrikeCache* SkStrikeCache::GlobalStrikeCache() {
 auto SkStrikeCache::findOrCreateStrike(const SkDescriptor& desc,
                                        const SkScalerContextEffects& effects,
                                        const SkTypeface& typeface) -> sk_sp<Strike> {
-    SkAutoMutexExclusive ac(fLock);
-    sk_sp<Strike> strike = this->internalFindStrikeOrNull(desc);
+    sk_sp<Strike> strike;
+    sk_sp<SkGlyphDiskCache> diskCache;
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        strike = this->internalFindStrikeOrNull(desc);
+        if (strike == nullptr && fDiskCache == nullptr) {
+            auto scaler = typeface.createScalerContext(effects, &desc);
+            strike = this->internalCreateStrike(desc, std::move(scaler));
+        }
+        if (strike != nullptr) {
+            this->internalPurge();
+            removed = this->internalTakeStrikesToSave();
+        }
+        diskCache = fDiskCache;
+    }
+
     if (strike == nullptr) {
-        auto scaler = typeface.createScalerContext(effects, &desc);
-        strike = this->internalCreateStrike(desc, std::move(scaler));
+        // Reading the file and digesting the font data are slow, so they are done without
+        // holding fLock. Another thread may create the strike meanwhile; then its strike wins.
+        std::unique_ptr<SkGlyphDiskCache::Strike> saved = diskCache->load(desc, typeface);
+        SkAutoMutexExclusive ac(fLock);
+        strike = this->internalFindStrikeOrNull(desc);
+        if (strike == nullptr) {
+            auto scaler = typeface.createScalerContext(effects, &desc);
+            strike = this->internalCreateStrike(desc, std::move(scaler), nullptr, nullptr,
+                                                saved.get());
+        }
+        this->internalPurge();
+        removed = this->internalTakeStrikesToSave();
     }
-    this->internalPurge();
+    this->saveStrikes(std::move(removed));
     return strike;
 }
 
@@ -48,6 +75,61 @@ SkScopedStrikeForGPU SkStrikeCache::findOrCreateScopedStrike(const SkDescriptor&
     return SkScopedStrikeForGPU{this->findOrCreateStrike(desc, effects, typeface).release()};
 }
 
+void SkStrikeCache::setDiskCache(sk_sp<SkGlyphDiskCache> diskCache) {
+    SkAutoMutexExclusive ac(fLock);
+    fDiskCache = std::move(diskCache);
+}
+
+void SkStrikeCache::saveToDiskCache() {
+    std::vector<sk_sp<Strike>> changed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        if (fDiskCache == nullptr) {
+            return;
+        }
+        for (Strike* strike = fHead; strike != nullptr; strike = strike->fNext) {
+            if (strike->fMemoryUsed != strike->fMemoryUsedOnDisk) {
+                changed.push_back(sk_ref_sp(strike));
+            }
+        }
+    }
+    this->saveStrikes(std::move(changed));
+}
+
+void SkStrikeCache::saveStrikes(std::vector<sk_sp<Strike>> strikes) {
+    if (strikes.empty()) {
+        return;
+    }
+
+    sk_sp<SkGlyphDiskCache> diskCache;
+    std::vector<size_t> memoryUsed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        diskCache = fDiskCache;
+        for (const sk_sp<Strike>& strike : strikes) {
+            memoryUsed.push_back(strike->fMemoryUsed);
+        }
+    }
+    if (diskCache == nullptr) {
+        return;
+    }
+
+    // Writing the files is slow, so it is done without holding fLock. Glyphs added meanwhile
+    // may or may not be in a file; the strike is saved again the next time if they are not.
+    std::vector<bool> saved;
+    for (const sk_sp<Strike>& strike : strikes) {
+        saved.push_back(diskCache->save(strike->fScalerCache,
+                                        *strike->getScalerContext()->getTypeface()));
+    }
+
+    SkAutoMutexExclusive ac(fLock);
+    for (size_t i = 0; i < strikes.size(); ++i) {
+        if (saved[i]) {
+            strikes[i]->fMemoryUsedOnDisk = memoryUsed[i];
+        }
+    }
+}
+
 void SkStrikeCache::PurgeAll() {
     GlobalStrikeCache()->purgeAll();
 }
@@ -118,9 +200,15 @@ void SkStrikeCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
 }
 
 sk_sp<SkStrike> SkStrikeCache::findStrike(const SkDescriptor& desc) {
-    SkAutoMutexExclusive ac(fLock);
-    sk_sp<SkStrike> result = this->internalFindStrikeOrNull(desc);
-    this->internalPurge();
+    sk_sp<SkStrike> result;
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        result = this->internalFindStrikeOrNull(desc);
+        this->internalPurge();
+        removed = this->internalTakeStrikesToSave();
+    }
+    this->saveStrikes(std::move(removed));
     return result;
 }
 
@@ -155,24 +243,95 @@ sk_sp<SkStrike> SkStrikeCache::createStrike(
         std::unique_ptr<SkScalerContext> scaler,
         SkFontMetrics* maybeMetrics,
         std::unique_ptr<SkStrikePinner> pinner) {
-    SkAutoMutexExclusive ac(fLock);
-    return this->internalCreateStrike(desc, std::move(scaler), maybeMetrics, std::move(pinner));
+    // Strikes which come with their metrics are filled by someone else, e.g. a remote cache.
+    std::unique_ptr<SkGlyphDiskCache::Strike> saved;
+    if (maybeMetrics == nullptr) {
+        sk_sp<SkGlyphDiskCache> diskCache;
+        {
+            SkAutoMutexExclusive ac(fLock);
+            diskCache = fDiskCache;
+        }
+        if (diskCache != nullptr) {
+            saved = diskCache->load(desc, *scaler->getTypeface());
+        }
+    }
+
+    sk_sp<Strike> strike;
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        strike = this->internalCreateStrike(desc, std::move(scaler), maybeMetrics,
+                                            std::move(pinner), saved.get());
+        removed = this->internalTakeStrikesToSave();
+    }
+    this->saveStrikes(std::move(removed));
+    return strike;
 }
 
 auto SkStrikeCache::internalCreateStrike(
         const SkDescriptor& desc,
         std::unique_ptr<SkScalerContext> scaler,
         SkFontMetrics* maybeMetrics,
-        std::unique_ptr<SkStrikePinner> pinner) -> sk_sp<Strike> {
-    auto strike =
-            sk_make_sp<Strike>(this, desc, std::move(scaler), maybeMetrics, std::move(pinner));
+        std::unique_ptr<SkStrikePinner> pinner,
+        const SkGlyphDiskCache::Strike* saved) -> sk_sp<Strike> {
+    auto strike = sk_make_sp<Strike>(this, desc, std::move(scaler),
+                                     saved ? &saved->fontMetrics() : maybeMetrics,
+                                     std::move(pinner));
+    if (saved) {
+        // The strike is not shared yet, so it can be filled without going through updateDelta.
+        strike->fMemoryUsed += strike->fScalerCache.mergeGlyphsAndImages(saved->glyphs());
+        strike->fMemoryUsedOnDisk = strike->fMemoryUsed;
+    }
     this->internalAttachToHead(strike);
     return strike;
 }
 
+void SkStrikeCache::prewarm(const SkStrikeSpec& strikeSpec, SkSpan<const SkGlyphID> glyphIDs,
+                            SkExecutor& executor) {
+    sk_sp<Strike> strike = strikeSpec.findOrCreateStrike(this);
+
+    // Each task makes its own scaler context, so hand out enough glyphs to pay for that.
+    static constexpr size_t kGlyphsPerTask = 32;
+    const int taskCount = SkTo<int>((glyphIDs.size() + kGlyphsPerTask - 1) / kGlyphsPerTask);
+
+    // Images are kept in the tasks' arenas until they are copied into the strike.
+    std::vector<SkGlyph> glyphs(glyphIDs.size());
+    std::vector<std::unique_ptr<SkArenaAlloc>> imageAllocs(taskCount);
+
+    SkTaskGroup(executor).batch(taskCount, [&](int taskIndex) {
+        const size_t start = taskIndex * kGlyphsPerTask;
+        const size_t end = std::min(start + kGlyphsPerTask, glyphIDs.size());
+
+        std::unique_ptr<SkScalerContext> scalerContext = strikeSpec.createScalerContext();
+        imageAllocs[taskIndex] = std::make_unique<SkArenaAlloc>(4096);
+        for (size_t i = start; i < end; ++i) {
+            glyphs[i] = scalerContext->makeGlyph(SkPackedGlyphID{glyphIDs[i]});
+            // Glyphs too big for the atlas are drawn as paths or drawables, not from their image.
+            if (glyphs[i].maxDimension() <= SkStrikeCommon::kSkSideTooBigForAtlas) {
+                glyphs[i].setImage(imageAllocs[taskIndex].get(), scalerContext.get());
+            }
+        }
+    });
+
+    strike->mergeGlyphsAndImages(SkMakeSpan(glyphs));
+
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        this->internalPurge();
+        removed = this->internalTakeStrikesToSave();
+    }
+    this->saveStrikes(std::move(removed));
+}
+
 void SkStrikeCache::purgeAll() {
-    SkAutoMutexExclusive ac(fLock);
-    this->internalPurge(fTotalMemoryUsed);
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        this->internalPurge(fTotalMemoryUsed);
+        removed = this->internalTakeStrikesToSave();
+    }
+    this->saveStrikes(std::move(removed));
 }
 
 size_t SkStrikeCache::getTotalMemoryUsed() const {
@@ -191,11 +350,17 @@ int SkStrikeCache::getCacheCountLimit() const {
 }
 
 size_t SkStrikeCache::setCacheSizeLimit(size_t newLimit) {
-    SkAutoMutexExclusive ac(fLock);
-
-    size_t prevLimit = fCacheSizeLimit;
-    fCacheSizeLimit = newLimit;
-    this->internalPurge();
+    size_t prevLimit;
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
+
+        prevLimit = fCacheSizeLimit;
+        fCacheSizeLimit = newLimit;
+        this->internalPurge();
+        removed = this->internalTakeStrikesToSave();
+    }
+    this->saveStrikes(std::move(removed));
     return prevLimit;
 }
 
@@ -209,11 +374,17 @@ int SkStrikeCache::setCacheCountLimit(int newCount) {
         newCount = 0;
     }
 
-    SkAutoMutexExclusive ac(fLock);
+    int prevCount;
+    std::vector<sk_sp<Strike>> removed;
+    {
+        SkAutoMutexExclusive ac(fLock);
 
-    int prevCount = fCacheCountLimit;
-    fCacheCountLimit = newCount;
-    this->internalPurge();
+        prevCount = fCacheCountLimit;
+        fCacheCountLimit = newCount;
+        this->internalPurge();
+        removed = this->internalTakeStrikesToSave();
+    }
+    this->saveStrikes(std::move(removed));
     return prevCount;
 }
 
@@ -301,7 +472,19 @@ void SkStrikeCache::internalAttachToHead(sk_sp<Strike> strike) {
     fHead = strikePtr; // Transfer ownership of strike to the cache list.
 }
 
+auto SkStrikeCache::internalTakeStrikesToSave() -> std::vector<sk_sp<Strike>> {
+    std::vector<sk_sp<Strike>> strikes;
+    strikes.swap(fStrikesToSave);
+    return strikes;
+}
+
 void SkStrikeCache::internalRemoveStrike(Strike* strike) {
+    // Evicted glyphs are written back, so that the next process does not have to make them.
+    // The caller saves them with saveStrikes once fLock is released.
+    if (fDiskCache != nullptr && strike->fMemoryUsed != strike->fMemoryUsedOnDisk) {
+        fStrikesToSave.push_back(sk_ref_sp(strike));
+    }
+
     SkASSERT(fCacheCount > 0);
     fCacheCount -= 1;
     fTotalMemoryUsed -= strike->fMemoryUsed;
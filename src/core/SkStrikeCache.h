@@ -10,12 +10,16 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "include/private/SkSpinlock.h"
 #include "include/private/SkTemplates.h"
 #include "src/core/SkDescriptor.h"
+#include "src/core/SkGlyphDiskCache.h"
 #include "src/core/SkScalerCache.h"
 
+class SkExecutor;
+class SkStrikeSpec;
 class SkTraceMemoryDump;
 
 #ifndef SK_DEFAULT_FONT_CACHE_COUNT_LIMIT
@@ -55,6 +59,10 @@ public:
             return glyph;
         }
 
+        void mergeGlyphsAndImages(SkSpan<const SkGlyph> from) {
+            this->updateDelta(fScalerCache.mergeGlyphsAndImages(from));
+        }
+
         const SkPath* mergePath(SkGlyph* glyph, const SkPath* path) {
             auto [glyphPath, increase] = fScalerCache.mergePath(glyph, path);
             this->updateDelta(increase);
@@ -109,20 +117,26 @@ public:
         }
 
         void prepareForMaskDrawing(
-                SkDrawableGlyphBuffer* drawbles, SkSourceGlyphBuffer* rejects) override {
-            size_t increase = fScalerCache.prepareForMaskDrawing(drawbles, rejects);
+                SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) override {
+            size_t increase = fScalerCache.prepareForMaskDrawing(drawables, rejects);
             this->updateDelta(increase);
         }
 
         void prepareForSDFTDrawing(
-                SkDrawableGlyphBuffer* drawbles, SkSourceGlyphBuffer* rejects) override {
-            size_t increase = fScalerCache.prepareForSDFTDrawing(drawbles, rejects);
+                SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) override {
+            size_t increase = fScalerCache.prepareForSDFTDrawing(drawables, rejects);
             this->updateDelta(increase);
         }
 
         void prepareForPathDrawing(
-                SkDrawableGlyphBuffer* drawbles, SkSourceGlyphBuffer* rejects) override {
-            size_t increase = fScalerCache.prepareForPathDrawing(drawbles, rejects);
+                SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) override {
+            size_t increase = fScalerCache.prepareForPathDrawing(drawables, rejects);
+            this->updateDelta(increase);
+        }
+
+        void prepareForDrawableDrawing(
+                SkDrawableGlyphBuffer* drawables, SkSourceGlyphBuffer* rejects) {
+            size_t increase = fScalerCache.prepareForDrawableDrawing(drawables, rejects);
             this->updateDelta(increase);
         }
 
@@ -138,6 +152,8 @@ public:
         SkScalerCache                   fScalerCache;
         std::unique_ptr<SkStrikePinner> fPinner;
         size_t                          fMemoryUsed{sizeof(SkScalerCache)};
+        // fMemoryUsed when the strike was last loaded from or saved to the disk cache.
+        size_t                          fMemoryUsedOnDisk{0};
         bool                            fRemoved{false};
     };  // Strike
 
@@ -161,6 +177,21 @@ public:
             const SkScalerContextEffects& effects,
             const SkTypeface& typeface) override SK_EXCLUDES(fLock);
 
+    // Generate the metrics and images of glyphIDs for the strike of strikeSpec on executor, and
+    // add them to the strike in one batch. Glyphs too big to be drawn as masks only get their
+    // metrics. Each task uses a scaler context of its own, so the work only runs in parallel as
+    // far as the typeface allows concurrent scaler contexts. Returns once all glyphs have been
+    // added.
+    void prewarm(const SkStrikeSpec& strikeSpec, SkSpan<const SkGlyphID> glyphIDs,
+                 SkExecutor& executor) SK_EXCLUDES(fLock);
+
+    // Strikes are loaded from diskCache when they are created and saved to it when they are
+    // removed, if they changed. Pass nullptr to stop using a disk cache.
+    void setDiskCache(sk_sp<SkGlyphDiskCache> diskCache) SK_EXCLUDES(fLock);
+
+    // Save the strikes which changed since they were last loaded or saved to the disk cache.
+    void saveToDiskCache() SK_EXCLUDES(fLock);
+
     static void PurgeAll();
     static void Dump();
 
@@ -184,11 +215,16 @@ private:
             const SkDescriptor& desc,
             std::unique_ptr<SkScalerContext> scaler,
             SkFontMetrics* maybeMetrics = nullptr,
-            std::unique_ptr<SkStrikePinner> = nullptr) SK_REQUIRES(fLock);
+            std::unique_ptr<SkStrikePinner> = nullptr,
+            const SkGlyphDiskCache::Strike* saved = nullptr) SK_REQUIRES(fLock);
 
     // The following methods can only be called when mutex is already held.
     void internalRemoveStrike(Strike* strike) SK_REQUIRES(fLock);
     void internalAttachToHead(sk_sp<Strike> strike) SK_REQUIRES(fLock);
+    std::vector<sk_sp<Strike>> internalTakeStrikesToSave() SK_REQUIRES(fLock);
+
+    // Writes strikes to the disk cache, if there is one.
+    void saveStrikes(std::vector<sk_sp<Strike>> strikes) SK_EXCLUDES(fLock);
 
     // Checkout budgets, modulated by the specified min-bytes-needed-to-purge,
     // and attempt to purge caches to match.
@@ -217,6 +253,9 @@ private:
     size_t  fTotalMemoryUsed SK_GUARDED_BY(fLock) {0};
     int32_t fCacheCountLimit{SK_DEFAULT_FONT_CACHE_COUNT_LIMIT};
     int32_t fCacheCount SK_GUARDED_BY(fLock) {0};
+    sk_sp<SkGlyphDiskCache> fDiskCache SK_GUARDED_BY(fLock);
+    // Strikes removed since the last internalTakeStrikesToSave, whose glyphs are not on disk.
+    std::vector<sk_sp<Strike>> fStrikesToSave SK_GUARDED_BY(fLock);
 };
 
 using SkStrike = SkStrikeCache::Strike;
@@ -219,6 +219,11 @@ sk_sp<SkStrike> SkStrikeSpec::findOrCreateStrike(SkStrikeCache* cache) const {
     return cache->findOrCreateStrike(*fAutoDescriptor.getDesc(), effects, *fTypeface);
 }
 
+std::unique_ptr<SkScalerContext> SkStrikeSpec::createScalerContext() const {
+    SkScalerContextEffects effects{fPathEffect.get(), fMaskFilter.get()};
+    return fTypeface->createScalerContext(effects, fAutoDescriptor.getDesc());
+}
+
 SkBulkGlyphMetrics::SkBulkGlyphMetrics(const SkStrikeSpec& spec)
     : fStrike{spec.findOrCreateStrike()} { }
 
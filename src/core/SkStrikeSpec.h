@@ -85,6 +85,9 @@ public:
     sk_sp<SkStrike> findOrCreateStrike(
             SkStrikeCache* cache = SkStrikeCache::GlobalStrikeCache()) const;
 
+    // Make a scaler context for this spec which is not attached to any strike.
+    std::unique_ptr<SkScalerContext> createScalerContext() const;
+
     SkScalar strikeToSourceRatio() const { return fStrikeToSourceRatio; }
     bool isEmpty() const { return SkScalarNearlyZero(fStrikeToSourceRatio); }
     const SkDescriptor& descriptor() const { return *fAutoDescriptor.getDesc(); }
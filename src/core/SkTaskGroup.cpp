@@ -8,6 +8,9 @@
 #include "include/core/SkExecutor.h"
 #include "src/core/SkTaskGroup.h"
 
+#include <algorithm>
+#include <thread>
+
 SkTaskGroup::SkTaskGroup(SkExecutor& executor) : fPending(0), fExecutor(executor) {}
 
 void SkTaskGroup::add(std::function<void(void)> fn) {
@@ -18,8 +21,41 @@ void SkTaskGroup::add(std::function<void(void)> fn) {
     });
 }
 
+namespace {
+    // The state shared by the tasks of one SkTaskGroup::parallelFor(). Each task claims chunks of
+    // the indices until none are left, and the last task to finish deletes it.
+    struct Batch {
+        Batch(int N, int tasks, std::function<void(int)> fn)
+            : fn(std::move(fn)), N(N), tasks(tasks), running(tasks) {}
+
+        void run() {
+            for (;;) {
+                // Chunks shrink as the indices run out, so that a thread which is slow to finish
+                // its chunk does not leave the others with nothing to do for long.
+                int remaining = N - next.load(std::memory_order_relaxed);
+                int chunk = std::max(1, remaining / (2 * tasks));
+                int start = next.fetch_add(chunk, std::memory_order_relaxed);
+                if (start >= N) {
+                    break;
+                }
+                for (int i = start, end = std::min(N, start + chunk); i < end; i++) {
+                    fn(i);
+                }
+            }
+            if (running.fetch_add(-1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        const std::function<void(int)> fn;
+        const int                       N,
+                                        tasks;
+        std::atomic<int>                next{0},
+                                        running;
+    };
+}  // namespace
+
 void SkTaskGroup::batch(int N, std::function<void(int)> fn) {
-    // TODO: I really thought we had some sort of more clever chunking logic.
     fPending.fetch_add(+N, std::memory_order_relaxed);
     for (int i = 0; i < N; i++) {
         fExecutor.add([=] {
@@ -29,6 +65,25 @@ void SkTaskGroup::batch(int N, std::function<void(int)> fn) {
     }
 }
 
+void SkTaskGroup::parallelFor(int N, std::function<void(int)> fn) {
+    if (N <= 0) {
+        return;
+    }
+    // Rather than adding a task per index, add a task per thread that could help and let those
+    // claim the indices. The tasks capture only two pointers, so adding them does not allocate.
+    static const int kMaxTasks = std::max(1u, std::thread::hardware_concurrency());
+    const int tasks = std::min(N, kMaxTasks);
+    Batch* batch = new Batch(N, tasks, std::move(fn));
+
+    fPending.fetch_add(+tasks, std::memory_order_relaxed);
+    for (int i = 0; i < tasks; i++) {
+        fExecutor.add([this, batch] {
+            batch->run();
+            fPending.fetch_add(-1, std::memory_order_release);
+        });
+    }
+}
+
 bool SkTaskGroup::done() const {
     return fPending.load(std::memory_order_acquire) == 0;
 }
@@ -45,7 +100,7 @@ void SkTaskGroup::wait() {
 
 SkTaskGroup::Enabler::Enabler(int threads) {
     if (threads) {
-        fThreadPool = SkExecutor::MakeLIFOThreadPool(threads);
+        fThreadPool = SkExecutor::MakeWorkStealingThreadPool(threads);
         SkExecutor::SetDefault(fThreadPool.get());
     }
 }
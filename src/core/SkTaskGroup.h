@@ -26,6 +26,12 @@ public:
     // Add a batch of N tasks, all calling fn with different arguments.
     void batch(int N, std::function<void(int)> fn);
 
+    // Call fn for each of 0..N-1, like batch(), but share the calls out in chunks to at most one
+    // task per hardware thread, so fn is called for several arguments in turn on each thread.
+    // This is cheaper than batch() for many small calls, but a call must never wait for another
+    // call of the same parallelFor() to start.
+    void parallelFor(int N, std::function<void(int)> fn);
+
     // Returns true if all Tasks previously add()ed to this SkTaskGroup have run.
     // It is safe to reuse this SkTaskGroup once done().
     bool done() const;
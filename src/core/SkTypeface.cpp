@@ -445,6 +445,8 @@ SkRect SkTypeface::getBounds() const {
     return fBounds;
 }
 
+void SkTypeface::onGetColorGlyphBounds(const SkGlyphID[], int, SkRect[], bool[]) const {}
+
 bool SkTypeface::onComputeBounds(SkRect* bounds) const {
     // we use a big size to ensure lots of significant bits from the scalercontext.
     // then we scale back down to return our final answer (at 1-pt)
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/private/SkChecksum.h"
@@ -545,6 +546,242 @@ namespace skvm {
         return (uint64_t)lo | (uint64_t)hi << 32;
     }
 
+    uint64_t Fingerprint() {
+        static const uint64_t fingerprint = [] {
+            // Bump this when optimize() or the interpreter or JIT change what instructions mean,
+            // without changing the ops themselves.
+            constexpr int kVersion = 1;
+            const Features features = detect_features();
+            // The JIT and SkOpts::hash(), which keys are made with, depend on the CPU too.
+            uint32_t cpu = 0;
+            for (int bit = 0; bit < 32; bit++) {
+                cpu |= SkCpu::Supports(1u << bit) ? 1u << bit : 0;
+            }
+            SkString desc = SkStringPrintf("%d %zu %d %d %u", kVersion,
+                                           sizeof(OptimizedInstruction), features.fma,
+                                           features.fp16, cpu);
+        #define M(op) desc.append(" " #op);
+            SKVM_OPS(M)
+        #undef M
+            uint32_t lo = SkOpts::hash(desc.c_str(), desc.size(), 0),
+                     hi = SkOpts::hash(desc.c_str(), desc.size(), 1);
+            return (uint64_t)lo | (uint64_t)hi << 32;
+        }();
+        return fingerprint;
+    }
+
+    namespace {
+        constexpr uint32_t kSerializedMagic = SkSetFourByteTag('s','k','v','m');
+
+        struct SerializedHeader {
+            uint32_t magic;
+            uint32_t fingerprint[2];
+            uint32_t checksum;  // of everything after the header
+        };
+
+        // Bytes each lane of a load or store reads or writes at argument immA, or 0 for other ops.
+        int varying_bytes(Op op) {
+            switch (op) {
+                case Op::load8:   case Op::store8:   return 1;
+                case Op::load16:  case Op::store16:  return 2;
+                case Op::load32:  case Op::store32:  return 4;
+                case Op::load64:  case Op::store64:  return 8;
+                case Op::load128: case Op::store128: return 16;
+                default:                             return 0;
+            }
+        }
+
+        // Bytes an op reads at offset immB of uniform argument immA, or 0 for other ops.
+        // array32 and gather* read a pointer there, and then read through it.
+        int uniform_bytes(Op op) {
+            switch (op) {
+                case Op::uniform32:
+                    return sizeof(int);
+                case Op::array32:
+                case Op::gather8: case Op::gather16: case Op::gather32:
+                    return sizeof(void*);
+                default:
+                    return 0;
+            }
+        }
+
+        // How many of x,y,z,w each op uses, as Builder pushes them.
+        int arg_count(Op op) {
+            switch (op) {
+                case Op::index:
+                case Op::load8: case Op::load16: case Op::load32:
+                case Op::load64: case Op::load128:
+                case Op::uniform32: case Op::array32:
+                case Op::splat:
+                    return 0;
+
+                case Op::store8: case Op::store16: case Op::store32:
+                case Op::gather8: case Op::gather16: case Op::gather32:
+                case Op::sqrt_f32:
+                case Op::shl_i32: case Op::shr_i32: case Op::sra_i32:
+                case Op::ceil: case Op::floor: case Op::trunc: case Op::round:
+                case Op::to_fp16: case Op::from_fp16:
+                case Op::to_f32:
+                    return 1;
+
+                case Op::fma_f32: case Op::fms_f32: case Op::fnma_f32:
+                case Op::select:
+                    return 3;
+
+                case Op::store128:
+                    return 4;
+
+                default:
+                    return 2;
+            }
+        }
+
+        // Whether inst stays within the memory its caller passes to eval(): loads and stores
+        // touch no more than the stride of their varying, and uniform reads stay within
+        // uniformBytes of their uniform.
+        bool args_in_bounds(const OptimizedInstruction& inst, const std::vector<int>& strides,
+                            SkSpan<const size_t> uniformBytes) {
+            const int varying = varying_bytes(inst.op),
+                      uniform = uniform_bytes(inst.op);
+            if (!varying && !uniform) {
+                return true;
+            }
+            if (inst.immA < 0 || inst.immA >= (int)strides.size()) {
+                return false;
+            }
+            const int stride = strides[inst.immA];
+            if (varying) {
+                // load64 and load128 read the 32-bit lane immB of each value.
+                const bool isLaneLoad = inst.op == Op::load64 || inst.op == Op::load128;
+                return stride >= varying &&
+                       (!isLaneLoad || (inst.immB >= 0 && inst.immB < varying / 4));
+            }
+            return stride == 0 &&
+                   inst.immB >= 0 && (size_t)inst.immB + uniform <= uniformBytes[inst.immA] &&
+                   (inst.op != Op::array32 || (inst.immC >= 0 && inst.immC % sizeof(int) == 0));
+        }
+    }  // namespace
+
+    sk_sp<SkData> Serialize(const std::vector<OptimizedInstruction>& instructions,
+                            const std::vector<int>& strides) {
+        SkDynamicMemoryWStream payload;
+        payload.write32(SkToU32(strides.size()));
+        for (int stride : strides) {
+            payload.write32(stride);
+        }
+        payload.write32(SkToU32(instructions.size()));
+        for (const OptimizedInstruction& inst : instructions) {
+            for (int v : {(int)inst.op, inst.x, inst.y, inst.z, inst.w,
+                          inst.immA, inst.immB, inst.immC, inst.death, (int)inst.can_hoist}) {
+                payload.write32(v);
+            }
+        }
+        sk_sp<SkData> body = payload.detachAsData();
+
+        const uint64_t fingerprint = Fingerprint();
+        const SerializedHeader header = {
+            kSerializedMagic,
+            {(uint32_t)fingerprint, (uint32_t)(fingerprint >> 32)},
+            SkOpts::hash(body->data(), body->size()),
+        };
+        sk_sp<SkData> data = SkData::MakeUninitialized(sizeof(header) + body->size());
+        memcpy(data->writable_data(), &header, sizeof(header));
+        memcpy(SkTAddOffset<void>(data->writable_data(), sizeof(header)), body->data(),
+               body->size());
+        return data;
+    }
+
+    bool Deserialize(const SkData& data, SkSpan<const size_t> uniformBytes,
+                     std::vector<OptimizedInstruction>* instructions, std::vector<int>* strides) {
+        SerializedHeader header;
+        if (data.size() < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data.data(), sizeof(header));
+        const uint64_t fingerprint = Fingerprint();
+        const void* body = SkTAddOffset<const void>(data.data(), sizeof(header));
+        const size_t bodySize = data.size() - sizeof(header);
+        if (header.magic != kSerializedMagic ||
+            header.fingerprint[0] != (uint32_t)fingerprint ||
+            header.fingerprint[1] != (uint32_t)(fingerprint >> 32) ||
+            header.checksum != SkOpts::hash(body, bodySize)) {
+            return false;
+        }
+
+        // The checksum only catches accidents; the instructions are still checked to have the
+        // invariants finalize() establishes for them, and to stay within the arguments and the
+        // uniforms described by strides and uniformBytes. Pointers held in the uniforms, which
+        // array32 and gather* read through, and gather indices are not checked.
+        SkMemoryStream stream(body, bodySize, /*copyData=*/false);
+        int32_t count;
+        if (!stream.readS32(&count) || count < 0 || count > 7) {
+            return false;
+        }
+        strides->resize(count);
+        for (int& stride : *strides) {
+            if (!stream.readS32(&stride) || stride < 0) {
+                return false;
+            }
+        }
+        if (strides->size() != uniformBytes.size()) {
+            return false;
+        }
+
+        if (!stream.readS32(&count) || count < 0 ||
+            stream.getLength() - stream.getPosition() != (size_t)count * 10 * sizeof(int32_t)) {
+            return false;
+        }
+        constexpr int kOpCount = 0
+        #define M(op) + 1
+            SKVM_OPS(M)
+        #undef M
+            ;
+        instructions->resize(count);
+        for (int i = 0; i < count; i++) {
+            int32_t v[10];
+            SkAssertResult(stream.read(v, sizeof(v)) == sizeof(v));
+            OptimizedInstruction& inst = (*instructions)[i];
+            if (v[0] < 0 || v[0] >= kOpCount) {
+                return false;
+            }
+            inst = {(Op)v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9] != 0};
+            const int argCount = arg_count(inst.op);
+            int argIndex = 0;
+            for (Val arg : {inst.x, inst.y, inst.z, inst.w}) {
+                // The op's arguments are earlier values, and the rest are NA.
+                if (argIndex++ < argCount ? (arg < 0 || arg >= i) : arg != NA) {
+                    return false;
+                }
+            }
+            if (!args_in_bounds(inst, *strides, uniformBytes)) {
+                return false;
+            }
+            if (inst.death < i || inst.death > count || (v[9] != 0 && v[9] != 1)) {
+                return false;
+            }
+            if (inst.can_hoist && is_always_varying(inst.op)) {
+                return false;
+            }
+        }
+
+        // Arguments live at least until they are used, hoisted values only depend on hoisted
+        // values, and hoisted values used in the loop live through all of it.
+        for (int i = 0; i < count; i++) {
+            const OptimizedInstruction& inst = (*instructions)[i];
+            for (Val arg : {inst.x, inst.y, inst.z, inst.w}) {
+                if (arg == NA) {
+                    continue;
+                }
+                const OptimizedInstruction& input = (*instructions)[arg];
+                if (input.death < i || (inst.can_hoist && !input.can_hoist) ||
+                    (!inst.can_hoist && input.can_hoist && input.death != count)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     bool operator!=(Ptr a, Ptr b) { return a.ix != b.ix; }
 
     bool operator==(const Instruction& a, const Instruction& b) {
@@ -2971,6 +3208,27 @@ namespace skvm {
         this->setupInterpreter(instructions);
     }
 
+    void Program::compileJIT(const std::vector<OptimizedInstruction>& instructions,
+                             const char* debug_name) {
+        SkASSERT(!this->hasJIT());
+    #if defined(SKVM_JIT) && !defined(SKVM_LLVM)
+        if (gSkVMAllowJIT) {
+            this->setupJIT(instructions, debug_name);
+        }
+    #endif
+    }
+
+    size_t Program::approximateBytesUsed() const {
+        size_t bytes = sizeof(Impl)
+                     + fImpl->instructions.size() * sizeof(InterpreterInstruction)
+                     + fImpl->strides.size() * sizeof(int);
+        // jit_size is set before jit_entry is published.
+        if (fImpl->jit_entry.load()) {
+            bytes += fImpl->jit_size;
+        }
+        return bytes;
+    }
+
     std::vector<InterpreterInstruction> Program::instructions() const { return fImpl->instructions; }
     int  Program::nargs() const { return (int)fImpl->strides.size(); }
     int  Program::nregs() const { return fImpl->regs; }
@@ -4236,7 +4494,6 @@ namespace skvm {
 
         fImpl->jit_size = a.size();
         void* jit_entry = alloc_jit_buffer(&fImpl->jit_size);
-        fImpl->jit_entry.store(jit_entry);
 
         // Assemble the program for real with stack_hint/registers_used as feedback from first call.
         a = Assembler{jit_entry};
@@ -4258,7 +4515,9 @@ namespace skvm {
             ::write(fd, jit_entry, a.size());
             close(fd);
 
-            this->dropJIT();  // (unmap and null out fImpl->jit_entry.)
+            // jit_entry was never published, so nothing can be running it yet.
+            unmap_jit_buffer(jit_entry, fImpl->jit_size);
+            fImpl->jit_size = 0;
 
             // Convert it in-place to a dynamic library with a single symbol "skvm_jit":
             SkString cmd = SkStringPrintf(
@@ -4273,9 +4532,13 @@ namespace skvm {
             for (const char* name : {"skvm_jit", "_skvm_jit"} ) {
                 if (!sym) { sym = dlsym(fImpl->dylib, name); }
             }
-            fImpl->jit_entry.store(sym);
+            jit_entry = sym;
         }
     #endif
+
+        // Only publish the final entry point, once it's ready; with compileJIT() eval() may
+        // already be running.
+        fImpl->jit_entry.store(jit_entry);
     }
 #endif
 
@@ -10,6 +10,7 @@
 
 #include "include/core/SkBlendMode.h"
 #include "include/core/SkColor.h"
+#include "include/core/SkRefCnt.h"
 #include "include/core/SkSpan.h"
 #include "include/private/SkMacros.h"
 #include "include/private/SkTArray.h"
@@ -17,6 +18,7 @@
 #include "src/core/SkVM_fwd.h"
 #include <vector>      // std::vector
 
+class SkData;
 class SkWStream;
 
 #if defined(SKVM_JIT_WHEN_POSSIBLE) && !defined(SK_BUILD_FOR_IOS)
@@ -604,6 +606,8 @@ namespace skvm {
         // Mostly for debugging, tests, etc.
         std::vector<Instruction> program() const { return fProgram; }
         std::vector<OptimizedInstruction> optimize() const;
+        // The strides of the program's arguments, as Program takes them with optimize().
+        std::vector<int> strides() const { return fStrides; }
 
         // Convenience arg() wrappers for most common strides, sizeof(T) and 0.
         template <typename T>
@@ -1026,6 +1030,15 @@ namespace skvm {
 
         bool hasJIT() const;  // Has this Program been JITted?
 
+        // A Program made with allow_jit false runs in the interpreter until compileJIT() is
+        // called with the instructions it was made from. That may happen on another thread,
+        // while the Program is in use: eval() switches to the JIT code once it is ready.
+        // Call it at most once.
+        void compileJIT(const std::vector<OptimizedInstruction>&, const char* debug_name);
+
+        // Approximate number of bytes held by the interpreter program and any JIT code.
+        size_t approximateBytesUsed() const;
+
         void dump(SkWStream* = nullptr) const;
 
     private:
@@ -1044,6 +1057,22 @@ namespace skvm {
         std::unique_ptr<Impl> fImpl;
     };
 
+    // Optimized instructions can be kept, e.g. on disk, and made into a Program again without
+    // Builder::optimize(). What optimize() emits depends on the build and on the CPU, so the data
+    // carries Fingerprint() and Deserialize() rejects data made with any other fingerprint, and
+    // data which is not well formed.
+    //
+    // uniformBytes has one entry per argument the caller will pass to eval(): how many bytes may
+    // be read at it if it is a uniform, ignored for varyings. Deserialize() rejects instructions
+    // reading past those, or past the stride of a varying. It cannot check pointers stored in the
+    // uniforms, which array32() and gather*() read through, so the data must still come from
+    // somewhere as trusted as the process itself.
+    uint64_t Fingerprint();
+    sk_sp<SkData> Serialize(const std::vector<OptimizedInstruction>&,
+                            const std::vector<int>& strides);
+    bool Deserialize(const SkData&, SkSpan<const size_t> uniformBytes,
+                     std::vector<OptimizedInstruction>*, std::vector<int>* strides);
+
     // TODO: control flow
     // TODO: 64-bit values?
 
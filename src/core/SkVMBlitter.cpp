@@ -5,8 +5,11 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/private/SkImageInfoPriv.h"
 #include "include/private/SkMacros.h"
+#include "include/private/SkMutex.h"
 #include "src/core/SkArenaAlloc.h"
 #include "src/core/SkBlendModePriv.h"
 #include "src/core/SkBlenderBase.h"
@@ -23,6 +26,7 @@
 #include "src/shaders/SkColorFilterShader.h"
 
 #include <cinttypes>
+#include <limits>
 
 namespace {
 
@@ -561,33 +565,109 @@ SkVMBlitter::SkVMBlitter(const SkPixmap& device,
         , fParams(EffectiveParams(device, sprite, paint, matrices, std::move(clip)))
         , fKey(CacheKey(fParams, &fUniforms, &fAlloc, ok)) {}
 
-SkVMBlitter::~SkVMBlitter() {
-    if (SkLRUCache<Key, skvm::Program>* cache = TryAcquireProgramCache()) {
-        auto cache_program = [&](skvm::Program&& program, Coverage coverage) {
-            if (!program.empty()) {
-                cache->insert_or_update(fKey.withCoverage(coverage), std::move(program));
+/**
+ *  The programs of all SkVMBlitters, shared between threads and bounded by the approximate bytes
+ *  they hold. A miss builds the program on the thread that needs it and runs it in the
+ *  interpreter, while it is JIT compiled on the default SkExecutor; blitters holding it pick up
+ *  the JIT code as soon as it is ready.
+ */
+class SkVMBlitter::ProgramCache {
+public:
+    sk_sp<SharedProgram> find(const Key& key) {
+        SkAutoMutexExclusive lock(fMutex);
+        Entry* entry = fLRU.find(key);
+        return entry ? entry->fProgram : nullptr;
+    }
+
+    // Adds program, made from instructions, unless another thread added one for key first, and
+    // returns the program that is now cached.
+    sk_sp<SharedProgram> add(const Key& key, skvm::Program program,
+                             std::vector<skvm::OptimizedInstruction> instructions,
+                             SkString debugName) {
+        auto shared = sk_make_sp<SharedProgram>(std::move(program));
+        {
+            SkAutoMutexExclusive lock(fMutex);
+            if (Entry* entry = fLRU.find(key)) {
+                return entry->fProgram;
             }
-        };
-        cache_program(std::move(fBlitH),         Coverage::Full);
-        cache_program(std::move(fBlitAntiH),     Coverage::UniformF);
-        cache_program(std::move(fBlitMaskA8),    Coverage::MaskA8);
-        cache_program(std::move(fBlitMask3D),    Coverage::Mask3D);
-        cache_program(std::move(fBlitMaskLCD16), Coverage::MaskLCD16);
+            fLRU.insert(key, {shared, shared->program.approximateBytesUsed()});
+            fBytesUsed += shared->program.approximateBytesUsed();
+            this->purgeAsNeeded();
+        }
+    #if defined(SKVM_JIT) && !defined(SKVM_LLVM)
+        // The task keeps the program alive even if it is purged meanwhile.
+        SkExecutor::GetDefault().add([this, key, shared,
+                                      instructions = std::move(instructions),
+                                      debugName    = std::move(debugName)] {
+            shared->program.compileJIT(instructions, debugName.c_str());
+            this->jitted(key, shared.get());
+        });
+    #endif
+        return shared;
+    }
+
+    void purgeAll() {
+        SkAutoMutexExclusive lock(fMutex);
+        fLRU.reset();
+        fBytesUsed = 0;
+    }
+
+private:
+    // Enough for a few hundred programs with their JIT code.
+    static constexpr size_t kByteLimit = 4 * 1024 * 1024;
+
+    struct Entry {
+        sk_sp<SharedProgram> fProgram;
+        size_t               fBytesUsed;
+    };
 
-        ReleaseProgramCache();
+    // Charges the cache for program's JIT code, if program is still cached.
+    void jitted(const Key& key, const SharedProgram* program) {
+        SkAutoMutexExclusive lock(fMutex);
+        Entry* entry = fLRU.find(key);
+        if (entry && entry->fProgram.get() == program) {
+            const size_t bytes = program->program.approximateBytesUsed();
+            fBytesUsed += bytes - entry->fBytesUsed;
+            entry->fBytesUsed = bytes;
+            this->purgeAsNeeded();
+        }
+    }
+
+    void purgeAsNeeded() SK_REQUIRES(fMutex) {
+        // Always keep the most recently used program, however large.
+        while (fBytesUsed > kByteLimit && fLRU.count() > 1) {
+            fBytesUsed -= fLRU.removeLeastRecentlyUsed().fBytesUsed;
+        }
     }
+
+    SkMutex fMutex;
+    SkLRUCache<Key, Entry> fLRU SK_GUARDED_BY(fMutex){std::numeric_limits<int>::max()};
+    size_t fBytesUsed SK_GUARDED_BY(fMutex) = 0;
+};
+
+SkVMBlitter::ProgramCache* SkVMBlitter::GetProgramCache() {
+    static ProgramCache* cache = new ProgramCache;
+    return cache;
 }
 
-SkLRUCache<SkVMBlitter::Key, skvm::Program>* SkVMBlitter::TryAcquireProgramCache() {
-#if defined(SKVM_JIT)
-    thread_local static SkLRUCache<Key, skvm::Program> cache{64};
-    return &cache;
-#else
-    // iOS now supports thread_local since iOS 9.
-    // On the other hand, we'll never be able to JIT there anyway.
-    // It's probably fine to not cache any interpreted programs, anywhere.
-    return nullptr;
-#endif
+void SkVMBlitter::PurgeProgramCacheForTesting() {
+    GetProgramCache()->purgeAll();
+}
+
+static SkVMBlitter::PersistentCache* gPersistentCache = nullptr;
+
+void SkVMBlitter::SetPersistentCache(PersistentCache* cache) {
+    gPersistentCache = cache;
+}
+
+sk_sp<SkData> SkVMBlitter::PersistentKey(const Key& key) {
+    static_assert(sizeof(Key) == 40, "Key must have no implicit padding");
+    const uint64_t fingerprint = skvm::Fingerprint();
+    sk_sp<SkData> data = SkData::MakeUninitialized(sizeof(Key) + sizeof(fingerprint));
+    memcpy(data->writable_data(), &key, sizeof(Key));
+    memcpy(SkTAddOffset<void>(data->writable_data(), sizeof(Key)), &fingerprint,
+           sizeof(fingerprint));
+    return data;
 }
 
 SkString SkVMBlitter::DebugName(const Key& key) {
@@ -602,20 +682,39 @@ SkString SkVMBlitter::DebugName(const Key& key) {
                           key.coverage);
 }
 
-void SkVMBlitter::ReleaseProgramCache() {}
-
-skvm::Program SkVMBlitter::buildProgram(Coverage coverage) {
+sk_sp<SkVMBlitter::SharedProgram> SkVMBlitter::buildProgram(Coverage coverage) {
     Key key = fKey.withCoverage(coverage);
-    {
-        skvm::Program p;
-        if (SkLRUCache<Key, skvm::Program>* cache = TryAcquireProgramCache()) {
-            if (skvm::Program* found = cache->find(key)) {
-                p = std::move(*found);
+    if (sk_sp<SharedProgram> found = GetProgramCache()->find(key)) {
+        return found;
+    }
+
+#if defined(SKVM_LLVM)
+    // LLVM already compiles in the background.
+    const bool jitNow = true;
+#else
+    const bool jitNow = false;
+#endif
+    SkString debugName = DebugName(key);
+
+    // A program found in the persistent cache skips building and optimizing. fUniforms were
+    // already written by CacheKey(), just as for programs found in the program cache.
+    PersistentCache* persistentCache = gPersistentCache;
+    sk_sp<SkData> persistentKey;
+    if (persistentCache) {
+        persistentKey = PersistentKey(key);
+        if (sk_sp<SkData> data = persistentCache->load(*persistentKey)) {
+            std::vector<int> argStrides;
+            std::vector<size_t> uniformBytes;
+            this->arguments(coverage, &argStrides, &uniformBytes);
+
+            std::vector<skvm::OptimizedInstruction> instructions;
+            std::vector<int> strides;
+            if (skvm::Deserialize(*data, SkMakeSpan(uniformBytes), &instructions, &strides) &&
+                strides == argStrides) {
+                skvm::Program program(instructions, strides, debugName.c_str(), jitNow);
+                return GetProgramCache()->add(key, std::move(program), std::move(instructions),
+                                              std::move(debugName));
             }
-            ReleaseProgramCache();
-        }
-        if (!p.empty()) {
-            return p;
         }
     }
     // We don't really _need_ to rebuild fUniforms here.
@@ -629,23 +728,45 @@ skvm::Program SkVMBlitter::buildProgram(Coverage coverage) {
     SkASSERTF(fUniforms.buf.size() == prev,
               "%zu, prev was %zu", fUniforms.buf.size(), prev);
 
-    skvm::Program program = builder.done(DebugName(key).c_str());
-    if (false) {
-        static std::atomic<int> missed{0},
-                total{0};
-        if (!program.hasJIT()) {
-            SkDebugf("\ncouldn't JIT %s\n", DebugName(key).c_str());
-            builder.dump();
-            program.dump();
+#if defined(SK_DEBUG)
+    {
+        std::vector<int> argStrides;
+        std::vector<size_t> uniformBytes;
+        this->arguments(coverage, &argStrides, &uniformBytes);
+        SkASSERT(builder.strides() == argStrides);
+    }
+#endif
+
+    // Threads missing the same key at once each build the program, but only one is kept.
+    std::vector<skvm::OptimizedInstruction> instructions = builder.optimize();
+    if (persistentCache) {
+        persistentCache->store(*persistentKey, *skvm::Serialize(instructions, builder.strides()));
+    }
+    skvm::Program program(instructions, builder.strides(), debugName.c_str(), jitNow);
+    return GetProgramCache()->add(key, std::move(program), std::move(instructions),
+                                  std::move(debugName));
+}
 
-            missed++;
-        }
-        if (0 == total++) {
-            atexit([]{ SkDebugf("SkVMBlitter compiled %d programs, %d without JIT.\n",
-                                total.load(), missed.load()); });
-        }
+void SkVMBlitter::arguments(Coverage coverage,
+                            std::vector<int>* strides, std::vector<size_t>* uniformBytes) const {
+    // See BuildProgram() for the order of the arguments.
+    *strides = {0, (int)SkColorTypeBytesPerPixel(fDevice.colorType())};
+    if (fSprite.colorType() != kUnknown_SkColorType) {
+        strides->push_back(SkColorTypeBytesPerPixel(fSprite.colorType()));
+    }
+    switch (coverage) {
+        case Coverage::Full:      break;
+        case Coverage::UniformF:  strides->push_back(0); break;
+        case Coverage::MaskA8:    strides->push_back(1); break;
+        case Coverage::MaskLCD16: strides->push_back(2); break;
+        case Coverage::Mask3D:    strides->insert(strides->end(), {1,1,1}); break;
+    }
+
+    uniformBytes->assign(strides->size(), 0);
+    uniformBytes->front() = fUniforms.buf.size() * sizeof(int);
+    if (coverage == Coverage::UniformF) {
+        uniformBytes->back() = sizeof(float);
     }
-    return program;
 }
 
 void SkVMBlitter::updateUniforms(int right, int y) {
@@ -662,28 +783,28 @@ const void* SkVMBlitter::isSprite(int x, int y) const {
 }
 
 void SkVMBlitter::blitH(int x, int y, int w) {
-    if (fBlitH.empty()) {
+    if (!fBlitH) {
         fBlitH = this->buildProgram(Coverage::Full);
     }
     this->updateUniforms(x+w, y);
     if (const void* sprite = this->isSprite(x,y)) {
-        fBlitH.eval(w, fUniforms.buf.data(), fDevice.addr(x,y), sprite);
+        fBlitH->program.eval(w, fUniforms.buf.data(), fDevice.addr(x,y), sprite);
     } else {
-        fBlitH.eval(w, fUniforms.buf.data(), fDevice.addr(x,y));
+        fBlitH->program.eval(w, fUniforms.buf.data(), fDevice.addr(x,y));
     }
 }
 
 void SkVMBlitter::blitAntiH(int x, int y, const SkAlpha cov[], const int16_t runs[]) {
-    if (fBlitAntiH.empty()) {
+    if (!fBlitAntiH) {
         fBlitAntiH = this->buildProgram(Coverage::UniformF);
     }
     for (int16_t run = *runs; run > 0; run = *runs) {
         this->updateUniforms(x+run, y);
         const float covF = *cov * (1/255.0f);
         if (const void* sprite = this->isSprite(x,y)) {
-            fBlitAntiH.eval(run, fUniforms.buf.data(), fDevice.addr(x,y), sprite, &covF);
+            fBlitAntiH->program.eval(run, fUniforms.buf.data(), fDevice.addr(x,y), sprite, &covF);
         } else {
-            fBlitAntiH.eval(run, fUniforms.buf.data(), fDevice.addr(x,y), &covF);
+            fBlitAntiH->program.eval(run, fUniforms.buf.data(), fDevice.addr(x,y), &covF);
         }
         x    += run;
         runs += run;
@@ -701,24 +822,24 @@ void SkVMBlitter::blitMask(const SkMask& mask, const SkIRect& clip) {
         default: SkUNREACHABLE;     // ARGB and SDF masks shouldn't make it here.
 
         case SkMask::k3D_Format:
-            if (fBlitMask3D.empty()) {
+            if (!fBlitMask3D) {
                 fBlitMask3D = this->buildProgram(Coverage::Mask3D);
             }
-            program = &fBlitMask3D;
+            program = &fBlitMask3D->program;
             break;
 
         case SkMask::kA8_Format:
-            if (fBlitMaskA8.empty()) {
+            if (!fBlitMaskA8) {
                 fBlitMaskA8 = this->buildProgram(Coverage::MaskA8);
             }
-            program = &fBlitMaskA8;
+            program = &fBlitMaskA8->program;
             break;
 
         case SkMask::kLCD16_Format:
-            if (fBlitMaskLCD16.empty()) {
+            if (!fBlitMaskLCD16) {
                 fBlitMaskLCD16 = this->buildProgram(Coverage::MaskLCD16);
             }
-            program = &fBlitMaskLCD16;
+            program = &fBlitMaskLCD16->program;
             break;
     }
 
@@ -731,7 +852,7 @@ void SkVMBlitter::blitMask(const SkMask& mask, const SkIRect& clip) {
             auto  mptr = (const uint8_t*)mask.getAddr(x,y);
             this->updateUniforms(x+w,y);
 
-            if (program == &fBlitMask3D) {
+            if (mask.fFormat == SkMask::k3D_Format) {
                 size_t plane = mask.computeImageSize();
                 if (const void* sprite = this->isSprite(x,y)) {
                     program->eval(w, fUniforms.buf.data(), dptr, sprite, mptr + 1*plane
@@ -8,11 +8,39 @@
 #ifndef SkVMBlitter_DEFINED
 #define SkVMBlitter_DEFINED
 
-#include "src/core/SkLRUCache.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkRefCnt.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkBlitter.h"
 #include "src/core/SkVM.h"
 
+class SkData;
+class SkMatrixProvider;
+class SkPaint;
+
 class SkVMBlitter final : public SkBlitter {
 public:
+    /**
+     *  Optimized programs may outlive the process, e.g. on disk, so that short lived processes do
+     *  not optimize the same programs again on every start. Keys include skvm::Fingerprint(), so
+     *  builds and CPUs which would optimize differently do not share entries. Implementations
+     *  must be thread safe.
+     */
+    class PersistentCache {
+    public:
+        virtual ~PersistentCache() = default;
+
+        // Returns nullptr if there is no data for key.
+        virtual sk_sp<SkData> load(const SkData& key) = 0;
+        virtual void store(const SkData& key, const SkData& data) = 0;
+    };
+
+    // Does not take ownership. Not thread safe, so set it before drawing.
+    static void SetPersistentCache(PersistentCache*);
+
+    // Forgets every program made so far, so the next draws load or build them again.
+    static void PurgeProgramCacheForTesting();
+
     static SkVMBlitter* Make(const SkPixmap& dst,
                              const SkPaint&,
                              const SkMatrixProvider&,
@@ -34,8 +62,6 @@ public:
                 sk_sp<SkShader> clip,
                 bool* ok);
 
-    ~SkVMBlitter() override;
-
 private:
     enum class Coverage { Full, UniformF, MaskA8, MaskLCD16, Mask3D };
     struct Key {
@@ -78,11 +104,24 @@ private:
                              skvm::Uniforms* uniforms, SkArenaAlloc* alloc);
     static Key CacheKey(const Params& params,
                         skvm::Uniforms* uniforms, SkArenaAlloc* alloc, bool* ok);
-    static SkLRUCache<Key, skvm::Program>* TryAcquireProgramCache();
     static SkString DebugName(const Key& key);
-    static void ReleaseProgramCache();
+    static sk_sp<SkData> PersistentKey(const Key& key);
+
+    // Programs are shared by every blitter, on every thread, with the same Key. They are
+    // immutable once made, other than being JIT compiled in the background, so any number of
+    // threads may eval() one at once.
+    struct SharedProgram : public SkNVRefCnt<SharedProgram> {
+        explicit SharedProgram(skvm::Program p) : program(std::move(p)) {}
+        skvm::Program program;
+    };
+    class ProgramCache;
+    static ProgramCache* GetProgramCache();
 
-    skvm::Program buildProgram(Coverage coverage);
+    sk_sp<SharedProgram> buildProgram(Coverage coverage);
+    // The strides of the arguments blit*() pass to programs for coverage, as BuildProgram()
+    // makes them, and the bytes which may be read at each of them which is a uniform.
+    void arguments(Coverage coverage,
+                   std::vector<int>* strides, std::vector<size_t>* uniformBytes) const;
     void updateUniforms(int right, int y);
     const void* isSprite(int x, int y) const;
 
@@ -97,10 +136,10 @@ private:
     SkArenaAlloc    fAlloc{2*sizeof(void*)};  // but a few effects need to ref large content.
     const Params    fParams;
     const Key       fKey;
-    skvm::Program   fBlitH,
-                    fBlitAntiH,
-                    fBlitMaskA8,
-                    fBlitMask3D,
-                    fBlitMaskLCD16;
+    sk_sp<SharedProgram> fBlitH,
+                         fBlitAntiH,
+                         fBlitMaskA8,
+                         fBlitMask3D,
+                         fBlitMaskLCD16;
 };
 #endif  // SkVMBlitter_DEFINED
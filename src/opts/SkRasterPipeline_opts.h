@@ -2451,6 +2451,19 @@ STAGE(gradient, const SkRasterPipeline_GradientCtx* c) {
     gradient_lookup(c, idx, t, &r, &g, &b, &a);
 }
 
+STAGE(indexed_gradient, const SkRasterPipeline_GradientCtx* c) {
+    auto t = r;
+    // cellCount is a power of two, so the mask keeps even NaN t in the index.
+    F   N    = (float)c->cellCount;
+    U32 cell = trunc_(min(max(t * N, 0), N - 1)) & U32(c->cellCount - 1);
+
+    // Each cell holds at most one stop, so t is at most one interval past its cell's.
+    U32 idx = gather(c->cells, cell);
+    idx += if_then_else(t >= gather(c->ts, idx + 1), U32(1), U32(0));
+
+    gradient_lookup(c, idx, t, &r, &g, &b, &a);
+}
+
 STAGE(evenly_spaced_2_stop_gradient, const void* ctx) {
     struct Ctx { float f[4], b[4]; };
     auto c = (const Ctx*)ctx;
@@ -2488,6 +2501,31 @@ STAGE(xy_to_unit_angle, Ctx::None) {
     r = phi;
 }
 
+// xy_to_unit_angle followed by a window's scale and bias, t = phi*w[0] + w[1], for sweeps over
+// part of a turn. It evaluates the same polynomial, so t is within 2.7e-5 turns (0.01 degrees)
+// of the exact angle, but in Estrin's form, to shorten the chain of dependent multiplies.
+STAGE(xy_to_sweep_window, const float* w) {
+    F X = r,
+      Y = g;
+    F xabs = abs_(X),
+      yabs = abs_(Y);
+
+    F slope = min(xabs, yabs)/max(xabs, yabs);
+    F s  = slope * slope,
+      s2 = s * s;
+
+    F phi = slope * mad(s2, mad(s, -7.0547382347285747528076171875e-3f,
+                                    2.476101927459239959716796875e-2f),
+                            mad(s, -5.185396969318389892578125e-2f,
+                                    0.15912117063999176025390625f));
+
+    phi = if_then_else(xabs < yabs, 1.0f/4.0f - phi, phi);
+    phi = if_then_else(X < 0.0f   , 1.0f/2.0f - phi, phi);
+    phi = if_then_else(Y < 0.0f   , 1.0f - phi     , phi);
+    phi = if_then_else(phi != phi , 0              , phi);  // Check for NaN.
+    r = mad(phi, w[0], w[1]);
+}
+
 STAGE(xy_to_radius, Ctx::None) {
     F X2 = r * r,
       Y2 = g * g;
@@ -3966,6 +4004,18 @@ STAGE_GP(gradient, const SkRasterPipeline_GradientCtx* c) {
     gradient_lookup(c, idx, t, &r, &g, &b, &a);
 }
 
+STAGE_GP(indexed_gradient, const SkRasterPipeline_GradientCtx* c) {
+    auto t = x;
+    // See the highp indexed_gradient.
+    F   N    = (float)c->cellCount;
+    U32 cell = trunc_(min(max(t * N, 0), N - 1)) & U32(c->cellCount - 1);
+
+    U32 idx = gather<U32>(c->cells, cell);
+    idx += if_then_else(t >= gather<F>(c->ts, idx + 1), U32(1), U32(0));
+
+    gradient_lookup(c, idx, t, &r, &g, &b, &a);
+}
+
 STAGE_GP(evenly_spaced_gradient, const SkRasterPipeline_GradientCtx* c) {
     auto t = x;
     auto idx = trunc_(t * (c->stopCount-1));
@@ -4005,6 +4055,26 @@ STAGE_GG(xy_to_unit_angle, Ctx::None) {
     phi = if_then_else(phi != phi , 0              , phi);  // Check for NaN.
     x = phi;
 }
+STAGE_GG(xy_to_sweep_window, const float* w) {
+    F xabs = abs_(x),
+      yabs = abs_(y);
+
+    F slope = min(xabs, yabs)/max(xabs, yabs);
+    F s  = slope * slope,
+      s2 = s * s;
+
+    // See the highp xy_to_sweep_window.
+    F phi = slope * mad(s2, mad(s, -7.0547382347285747528076171875e-3f,
+                                    2.476101927459239959716796875e-2f),
+                            mad(s, -5.185396969318389892578125e-2f,
+                                    0.15912117063999176025390625f));
+
+    phi = if_then_else(xabs < yabs, 1.0f/4.0f - phi, phi);
+    phi = if_then_else(x < 0.0f   , 1.0f/2.0f - phi, phi);
+    phi = if_then_else(y < 0.0f   , 1.0f - phi     , phi);
+    phi = if_then_else(phi != phi , 0              , phi);  // Check for NaN.
+    x = mad(phi, w[0], w[1]);
+}
 STAGE_GG(xy_to_radius, Ctx::None) {
     x = sqrt_(x*x + y*y);
 }
@@ -0,0 +1,441 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/ports/SkColrV1Glyph.h"
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPixmap.h"
+#include "include/effects/SkGradientShader.h"
+#include "include/private/SkTemplates.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkRasterPipeline.h"
+
+#include <algorithm>
+
+namespace {
+
+SkColor resolve_color(SkSpan<const SkColor> palette, const SkColrV1Glyph::ColorStop& stop) {
+    SkColor color = stop.fPaletteIndex < palette.size() ? palette[stop.fPaletteIndex]
+                                                        : SK_ColorBLACK;
+    return SkColorSetA(color, (U8CPU)(SkColorGetA(color) * stop.fAlpha));
+}
+
+}  // namespace
+
+void SkColrV1Glyph::Builder::concat(const SkMatrix& matrix) {
+    fMatrices.push_back(matrix);
+    this->push(Verb::kConcat, (int)fMatrices.size() - 1, 0);
+}
+
+void SkColrV1Glyph::Builder::clipPath(const SkPath& path) {
+    fPaths.push_back(path);
+    this->push(Verb::kClipPath, (int)fPaths.size() - 1, 0);
+}
+
+void SkColrV1Glyph::Builder::drawPath(const SkPath& path, const Fill& fill,
+                                      SkSpan<const ColorStop> stops) {
+    fPaths.push_back(path);
+    int fillIndex = this->addFill(fill, stops);
+    this->push(Verb::kDrawPath, (int)fPaths.size() - 1, fillIndex);
+}
+
+void SkColrV1Glyph::Builder::drawPaint(const Fill& fill, SkSpan<const ColorStop> stops) {
+    this->push(Verb::kDrawPaint, 0, this->addFill(fill, stops));
+}
+
+void SkColrV1Glyph::Builder::saveLayer(SkBlendMode mode, const SkRect* bounds) {
+    int boundsIndex = -1;
+    if (bounds) {
+        fBounds.push_back(*bounds);
+        boundsIndex = (int)fBounds.size() - 1;
+    }
+    this->push(Verb::kSaveLayer, (int)mode, 0, boundsIndex);
+}
+
+int SkColrV1Glyph::Builder::addFill(const Fill& fill, SkSpan<const ColorStop> stops) {
+    Fill& added = fFills.emplace_back(fill);
+    added.fFirstStop = (int)fStops.size();
+    added.fStopCount = (int)stops.size();
+    fStops.insert(fStops.end(), stops.begin(), stops.end());
+    return (int)fFills.size() - 1;
+}
+
+sk_sp<SkColrV1Glyph> SkColrV1Glyph::Builder::detach() {
+    sk_sp<SkColrV1Glyph> glyph(new SkColrV1Glyph);
+    glyph->fCommands = std::move(fCommands);
+    glyph->fMatrices = std::move(fMatrices);
+    glyph->fPaths    = std::move(fPaths);
+    glyph->fFills    = std::move(fFills);
+    glyph->fStops    = std::move(fStops);
+    glyph->fBounds   = std::move(fBounds);
+    glyph->fCommands.shrink_to_fit();
+    glyph->fMatrices.shrink_to_fit();
+    glyph->fPaths.shrink_to_fit();
+    glyph->fFills.shrink_to_fit();
+    glyph->fStops.shrink_to_fit();
+    glyph->fBounds.shrink_to_fit();
+    glyph->fCanRecolor =
+            std::none_of(glyph->fCommands.begin(), glyph->fCommands.end(), [](const Command& c) {
+                return c.fVerb == Verb::kSaveLayer;
+            }) &&
+            std::all_of(glyph->fFills.begin(), glyph->fFills.end(), [](const Fill& fill) {
+                return fill.fType == Fill::Type::kSolid;
+            });
+    *this = Builder();
+    return glyph;
+}
+
+void SkColrV1Glyph::configurePaint(const Fill& fill, SkSpan<const SkColor> palette,
+                                   SkPaint* paint) const {
+    if (fill.fType == Fill::Type::kSolid) {
+        SkASSERT(fill.fStopCount == 1);
+        paint->setShader(nullptr);
+        paint->setColor(resolve_color(palette, fStops[fill.fFirstStop]));
+        return;
+    }
+    // An opaque color is needed to ensure the gradient's not modulated by alpha.
+    paint->setColor(SK_ColorBLACK);
+    paint->setShader(this->makeShader(fill, palette));
+}
+
+sk_sp<SkShader> SkColrV1Glyph::makeShader(const Fill& fill, SkSpan<const SkColor> palette) const {
+    if (fill.fType == Fill::Type::kSolid) {
+        return nullptr;
+    }
+
+    const ColorStop* stops = fStops.data() + fill.fFirstStop;
+    SkAutoSTMalloc<16, SkColor> colors(fill.fStopCount);
+    SkAutoSTMalloc<16, SkScalar> offsets(fill.fStopCount);
+    for (int i = 0; i < fill.fStopCount; ++i) {
+        colors[i] = resolve_color(palette, stops[i]);
+        offsets[i] = stops[i].fOffset;
+    }
+
+    switch (fill.fType) {
+        case Fill::Type::kLinearGradient:
+            return SkGradientShader::MakeLinear(fill.fPoints, colors.get(), offsets.get(),
+                                                fill.fStopCount, fill.fTileMode);
+        case Fill::Type::kRadialGradient:
+            return SkGradientShader::MakeTwoPointConical(
+                    fill.fPoints[0], fill.fScalars[0], fill.fPoints[1], fill.fScalars[1],
+                    colors.get(), offsets.get(), fill.fStopCount, fill.fTileMode);
+        case Fill::Type::kSweepGradient: {
+            // Skia's angles start from the horizontal x-Axis, rotate left 90
+            // degrees and then mirror horizontally to correct for Skia angles
+            // going clockwise, COLR v1 angles going counterclockwise.
+            const SkPoint& center = fill.fPoints[0];
+            SkMatrix angle_adjust = SkMatrix::RotateDeg(-90.f, center);
+            angle_adjust.postScale(-1, 1, center.x(), center.y());
+            return SkGradientShader::MakeSweep(center.x(), center.y(), colors.get(),
+                                               offsets.get(), fill.fStopCount, fill.fTileMode,
+                                               fill.fScalars[0], fill.fScalars[1], 0,
+                                               &angle_adjust);
+        }
+        case Fill::Type::kSolid:
+            break;
+    }
+    SkUNREACHABLE;
+}
+
+void SkColrV1Glyph::draw(SkCanvas* canvas, SkSpan<const SkColor> palette) const {
+    for (const Command& command : fCommands) {
+        switch (command.fVerb) {
+            case Verb::kSave:
+                canvas->save();
+                break;
+            case Verb::kRestore:
+                canvas->restore();
+                break;
+            case Verb::kConcat:
+                canvas->concat(fMatrices[command.fIndex]);
+                break;
+            case Verb::kClipPath: {
+                const SkPath& path = fPaths[command.fIndex];
+#ifdef SK_SHOW_TEXT_BLIT_COVERAGE
+                SkPaint highlight_paint;
+                highlight_paint.setColor(0x33FF0000);
+                canvas->drawRect(path.getBounds(), highlight_paint);
+#endif
+                canvas->clipPath(path, true /* doAntiAlias */);
+                break;
+            }
+            case Verb::kDrawPath: {
+                const SkPath& path = fPaths[command.fIndex];
+#ifdef SK_SHOW_TEXT_BLIT_COVERAGE
+                SkPaint highlight_paint;
+                highlight_paint.setColor(0x33FF0000);
+                canvas->drawRect(path.getBounds(), highlight_paint);
+#endif
+                SkPaint paint;
+                paint.setAntiAlias(true);
+                this->configurePaint(fFills[command.fFill], palette, &paint);
+                canvas->drawPath(path, paint);
+                break;
+            }
+            case Verb::kDrawPaint: {
+                SkPaint paint;
+                this->configurePaint(fFills[command.fFill], palette, &paint);
+                canvas->drawPaint(paint);
+                break;
+            }
+            case Verb::kSaveLayer: {
+                SkPaint blend_mode_paint;
+                blend_mode_paint.setBlendMode((SkBlendMode)command.fIndex);
+                canvas->saveLayer(command.fBounds < 0 ? nullptr : &fBounds[command.fBounds],
+                                  &blend_mode_paint);
+                break;
+            }
+        }
+    }
+}
+
+sk_sp<SkColrV1Glyph::Coverage> SkColrV1Glyph::makeCoverage(SkISize dimensions,
+                                                           const SkMatrix& matrix) const {
+    if (!fCanRecolor) {
+        return nullptr;
+    }
+
+    // Each draw is drawn alone into an A8 canvas, which clips it as draw() would, and the
+    // coverage within its bounds is kept.
+    SkBitmap mask;
+    if (!mask.tryAllocPixels(SkImageInfo::MakeA8(dimensions.width(), dimensions.height()))) {
+        return nullptr;
+    }
+    mask.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(mask);
+    canvas.concat(matrix);
+
+    sk_sp<Coverage> coverage(new Coverage);
+    coverage->fDimensions = dimensions;
+    auto addDraw = [&](const SkPath* path, const Fill& fill) {
+        SkIRect bounds = canvas.getDeviceClipBounds();
+        if (path && !path->isInverseFillType() &&
+            !bounds.intersect(canvas.getTotalMatrix().mapRect(path->getBounds()).roundOut()))
+        {
+            return;
+        }
+        if (!bounds.intersect(mask.bounds())) {
+            return;
+        }
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        if (path) {
+            canvas.drawPath(*path, paint);
+        } else {
+            canvas.drawPaint(paint);
+        }
+
+        const size_t offset = coverage->fCoverage.size();
+        coverage->fCoverage.resize(offset + bounds.width() * bounds.height());
+        uint8_t* row = coverage->fCoverage.data() + offset;
+        for (int y = bounds.fTop; y < bounds.fBottom; ++y, row += bounds.width()) {
+            memcpy(row, mask.getAddr8(bounds.fLeft, y), bounds.width());
+        }
+        coverage->fDraws.push_back({bounds, offset, fStops[fill.fFirstStop]});
+        // Nothing is drawn outside of bounds, so that is all the next draw needs cleared.
+        mask.erase(SK_ColorTRANSPARENT, bounds);
+    };
+    for (const Command& command : fCommands) {
+        switch (command.fVerb) {
+            case Verb::kSave:
+                canvas.save();
+                break;
+            case Verb::kRestore:
+                canvas.restore();
+                break;
+            case Verb::kConcat:
+                canvas.concat(fMatrices[command.fIndex]);
+                break;
+            case Verb::kClipPath:
+                canvas.clipPath(fPaths[command.fIndex], true /* doAntiAlias */);
+                break;
+            case Verb::kDrawPath:
+                addDraw(&fPaths[command.fIndex], fFills[command.fFill]);
+                break;
+            case Verb::kDrawPaint:
+                addDraw(nullptr, fFills[command.fFill]);
+                break;
+            case Verb::kSaveLayer:
+                SkUNREACHABLE;
+        }
+    }
+    coverage->fDraws.shrink_to_fit();
+    coverage->fCoverage.shrink_to_fit();
+    return coverage;
+}
+
+void SkColrV1Glyph::Coverage::recolor(const SkPixmap& dst, SkSpan<const SkColor> palette) const {
+    SkASSERT(dst.colorType() == kN32_SkColorType && dst.alphaType() == kPremul_SkAlphaType);
+    SkASSERT(dst.dimensions() == fDimensions);
+
+    SkSTArenaAlloc<2 * 1024> alloc;
+    for (const Draw& draw : fDraws) {
+        const SkColor color = resolve_color(palette, draw.fColor);
+        if (SkColorGetA(color) == 0) {
+            continue;
+        }
+        // Both contexts start at the top left of the draw's bounds.
+        SkRasterPipeline_MemoryCtx
+                coverage = {const_cast<uint8_t*>(fCoverage.data() + draw.fOffset),
+                            draw.fBounds.width()},
+                pixels   = {dst.writable_addr(draw.fBounds.fLeft, draw.fBounds.fTop),
+                            dst.rowBytesAsPixels()};
+        SkRasterPipeline p(&alloc);
+        p.append_constant_color(&alloc, SkColor4f::FromColor(color).premul().vec());
+        p.append(SkRasterPipeline::scale_u8, &coverage);
+        p.append_load_dst(kN32_SkColorType, &pixels);
+        p.append(SkRasterPipeline::srcover);
+        p.append_store(kN32_SkColorType, &pixels);
+        p.run(0, 0, draw.fBounds.width(), draw.fBounds.height());
+    }
+}
+
+size_t SkColrV1Glyph::Coverage::approximateBytesUsed() const {
+    return sizeof(*this) + fDraws.capacity() * sizeof(Draw) + fCoverage.capacity();
+}
+
+size_t SkColrV1Glyph::approximateBytesUsed() const {
+    size_t size = sizeof(*this);
+    size += fCommands.capacity() * sizeof(Command);
+    size += fMatrices.capacity() * sizeof(SkMatrix);
+    size += fFills.capacity() * sizeof(Fill);
+    size += fStops.capacity() * sizeof(ColorStop);
+    size += fBounds.capacity() * sizeof(SkRect);
+    for (const SkPath& path : fPaths) {
+        size += path.approximateBytesUsed();
+    }
+    return size;
+}
+
+bool SkColrV1GlyphCache::find(SkGlyphID glyphID, sk_sp<SkColrV1Glyph>* glyph) const {
+    SkAutoMutexExclusive lock(fMutex);
+    if (const sk_sp<SkColrV1Glyph>* found = fGlyphs.find(glyphID)) {
+        *glyph = *found;
+        return true;
+    }
+    return false;
+}
+
+sk_sp<SkColrV1Glyph> SkColrV1GlyphCache::add(SkGlyphID glyphID, sk_sp<SkColrV1Glyph> glyph) {
+    SkAutoMutexExclusive lock(fMutex);
+    // Another thread may have built the same glyph in the meantime; keep the first one.
+    if (const sk_sp<SkColrV1Glyph>* found = fGlyphs.find(glyphID)) {
+        return *found;
+    }
+    if (glyph) {
+        fBytesUsed += glyph->approximateBytesUsed();
+    }
+    fGlyphs.set(glyphID, glyph);
+    return glyph;
+}
+
+sk_sp<SkColrV1Glyph::Coverage> SkColrV1GlyphCache::findOrMakeCoverage(SkGlyphID glyphID,
+                                                                     const SkColrV1Glyph& glyph,
+                                                                     SkISize dimensions,
+                                                                     const SkMatrix& matrix) {
+    if (!glyph.canRecolor()) {
+        return nullptr;
+    }
+
+    CoverageKey key;
+    memset(&key, 0, sizeof(key));
+    key.fGlyphID = glyphID;
+    key.fDimensions = dimensions;
+    matrix.get9(key.fMatrix);
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        if (sk_sp<SkColrV1Glyph::Coverage>* found = fCoverage.find(key)) {
+            return *found;
+        }
+    }
+
+    // Scan convert without holding the lock; if another thread got there first, its coverage
+    // is just as good.
+    sk_sp<SkColrV1Glyph::Coverage> coverage = glyph.makeCoverage(dimensions, matrix);
+    SkAutoMutexExclusive lock(fMutex);
+    if (sk_sp<SkColrV1Glyph::Coverage>* found = fCoverage.find(key)) {
+        return *found;
+    }
+    fCoverage.insert(key, coverage);
+    fCoverageBytes += coverage ? coverage->approximateBytesUsed() : 0;
+    // Always keep the coverage just added, however large.
+    while (fCoverageBytes > kCoverageBudget && fCoverage.count() > 1) {
+        sk_sp<SkColrV1Glyph::Coverage> removed = fCoverage.removeLeastRecentlyUsed();
+        fCoverageBytes -= removed ? removed->approximateBytesUsed() : 0;
+    }
+    return coverage;
+}
+
+bool SkColrV1GlyphCache::findOutline(SkGlyphID glyphID, SkPath* path) {
+    return this->findOutlineEntry(glyphID, path);
+}
+
+void SkColrV1GlyphCache::addOutline(SkGlyphID glyphID, const SkPath& path) {
+    this->addOutlineEntry(glyphID, path);
+}
+
+bool SkColrV1GlyphCache::findClipBox(SkGlyphID glyphID, SkPath* clipBox) {
+    return this->findOutlineEntry(kClipBoxKey | glyphID, clipBox);
+}
+
+void SkColrV1GlyphCache::addClipBox(SkGlyphID glyphID, const SkPath& clipBox) {
+    this->addOutlineEntry(kClipBoxKey | glyphID, clipBox);
+}
+
+bool SkColrV1GlyphCache::findOutlineEntry(uint32_t key, SkPath* path) {
+    SkAutoMutexExclusive lock(fOutlineMutex);
+    if (const Outline* found = fOutlines.find(key)) {
+        *path = found->fPath;
+        return true;
+    }
+    return false;
+}
+
+void SkColrV1GlyphCache::addOutlineEntry(uint32_t key, const SkPath& path) {
+    SkAutoMutexExclusive lock(fOutlineMutex);
+    if (fOutlines.find(key)) {
+        return;
+    }
+    const size_t bytes = sizeof(key) + path.approximateBytesUsed();
+    fOutlines.insert(key, {path, bytes});
+    fOutlineBytes += bytes;
+    // Always keep the outline just added, however large.
+    while (fOutlineBytes > kOutlineBudget && fOutlines.count() > 1) {
+        fOutlineBytes -= fOutlines.removeLeastRecentlyUsed().fBytesUsed;
+    }
+}
+
+bool SkColrV1GlyphCache::findBounds(SkGlyphID glyphID, SkRect* bounds) const {
+    SkAutoSharedMutexShared lock(fBoundsMutex);
+    if (const SkRect* found = fBounds.find(glyphID)) {
+        *bounds = *found;
+        return true;
+    }
+    return false;
+}
+
+void SkColrV1GlyphCache::addBounds(SkGlyphID glyphID, const SkRect& bounds) {
+    SkAutoSharedMutexExclusive lock(fBoundsMutex);
+    fBounds.set(glyphID, bounds);
+}
+
+size_t SkColrV1GlyphCache::bytesUsed() const {
+    size_t outlineBytes;
+    {
+        SkAutoMutexExclusive lock(fOutlineMutex);
+        outlineBytes = fOutlineBytes;
+    }
+    {
+        SkAutoSharedMutexShared lock(fBoundsMutex);
+        outlineBytes += fBounds.approxBytesUsed();
+    }
+    SkAutoMutexExclusive lock(fMutex);
+    return fBytesUsed + fCoverageBytes + outlineBytes;
+}
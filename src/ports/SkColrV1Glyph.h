@@ -0,0 +1,275 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkColrV1Glyph_DEFINED
+#define SkColrV1Glyph_DEFINED
+
+#include "include/core/SkBlendMode.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPoint.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSize.h"
+#include "include/core/SkSpan.h"
+#include "include/core/SkTileMode.h"
+#include "include/private/SkMutex.h"
+#include "include/private/SkTHash.h"
+#include "src/core/SkLRUCache.h"
+#include "src/core/SkSharedMutex.h"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+class SkCanvas;
+class SkPaint;
+class SkPixmap;
+class SkShader;
+
+/**
+ *  A COLRv1 paint graph decoded once from the font into a flat, immutable list of drawing
+ *  commands. Everything is kept in font units (y-down) and colors are kept as palette indices,
+ *  so one SkColrV1Glyph serves every size, transform, subpixel position and palette of a glyph.
+ *
+ *  Nested PaintColrGlyph references are inlined at build time and PaintGlyph outlines are held
+ *  as SkPaths, so drawing does not need to touch FreeType.
+ */
+class SkColrV1Glyph : public SkNVRefCnt<SkColrV1Glyph> {
+public:
+    // Palette index used by COLRv1 for the text foreground color.
+    static constexpr uint16_t kForegroundPaletteIndex = 0xFFFF;
+
+    struct ColorStop {
+        SkScalar fOffset;
+        uint16_t fPaletteIndex;
+        float    fAlpha;
+    };
+
+    struct Fill {
+        enum class Type : uint8_t {
+            kSolid,
+            kLinearGradient,
+            kRadialGradient,
+            kSweepGradient,
+        };
+
+        Type       fType;
+        SkTileMode fTileMode;
+        // kSolid: unused.
+        // kLinearGradient: the start and end point of the (already projected) gradient line.
+        // kRadialGradient: the start and end circle centers.
+        // kSweepGradient: fPoints[0] is the center.
+        SkPoint    fPoints[2];
+        // kRadialGradient: the start and end radii.
+        // kSweepGradient: the start and end angles in degrees, in Skia's angle space.
+        SkScalar   fScalars[2];
+        // The range of fStops used by this fill, sorted by offset. A solid fill has one stop.
+        int        fFirstStop;
+        int        fStopCount;
+    };
+
+    enum class Verb : uint8_t {
+        kSave,
+        kRestore,
+        kConcat,      // fIndex: matrix
+        kClipPath,    // fIndex: path
+        kDrawPath,    // fIndex: path, fFill: fill
+        kDrawPaint,   // fFill: fill
+        kSaveLayer,   // fIndex: SkBlendMode, fBounds: bounds or -1 if unbounded
+    };
+
+    struct Command {
+        Verb fVerb;
+        int  fIndex;
+        int  fFill;
+        int  fBounds;
+    };
+
+    class Builder {
+    public:
+        void save()                                   { this->push(Verb::kSave, 0, 0); }
+        void restore()                                { this->push(Verb::kRestore, 0, 0); }
+        void concat(const SkMatrix& matrix);
+        void clipPath(const SkPath& path);
+        void drawPath(const SkPath& path, const Fill& fill, SkSpan<const ColorStop> stops);
+        void drawPaint(const Fill& fill, SkSpan<const ColorStop> stops);
+        // bounds, if not nullptr, must contain everything drawn into the layer.
+        void saveLayer(SkBlendMode mode, const SkRect* bounds = nullptr);
+
+        // A glyph may legitimately record nothing, e.g. when its paint graph only clears.
+        sk_sp<SkColrV1Glyph> detach();
+
+    private:
+        void push(Verb verb, int index, int fill, int bounds = -1) {
+            fCommands.push_back({verb, index, fill, bounds});
+        }
+        int addFill(const Fill& fill, SkSpan<const ColorStop> stops);
+
+        std::vector<Command>   fCommands;
+        std::vector<SkMatrix>  fMatrices;
+        std::vector<SkPath>    fPaths;
+        std::vector<Fill>      fFills;
+        std::vector<ColorStop> fStops;
+        std::vector<SkRect>    fBounds;
+    };
+
+    /**
+     *  Replay the glyph into canvas. The canvas matrix must already map font units to device
+     *  space. Palette indices outside of palette, including kForegroundPaletteIndex, draw black.
+     */
+    void draw(SkCanvas* canvas, SkSpan<const SkColor> palette) const;
+
+    /**
+     *  The coverage of each draw of a glyph, scan converted once for one size and transform,
+     *  without its colors. Recoloring it gives the pixels draw() would, up to rounding, so a
+     *  glyph drawn with several palettes is only scan converted once.
+     */
+    class Coverage : public SkNVRefCnt<Coverage> {
+    public:
+        // Draws the glyph over dst, which must have the dimensions the coverage was made for.
+        void recolor(const SkPixmap& dst, SkSpan<const SkColor> palette) const;
+
+        size_t approximateBytesUsed() const;
+
+    private:
+        friend class SkColrV1Glyph;
+
+        struct Draw {
+            SkIRect   fBounds;
+            // Where the coverage within fBounds, row by row, starts in fCoverage.
+            size_t    fOffset;
+            ColorStop fColor;
+        };
+
+        SkISize              fDimensions;
+        std::vector<Draw>    fDraws;
+        std::vector<uint8_t> fCoverage;
+    };
+
+    // Glyphs which only draw solid colors, and do not use layers, can be split into coverage.
+    bool canRecolor() const { return fCanRecolor; }
+
+    // Returns nullptr if !canRecolor(). matrix maps font units to the pixels of an image of
+    // dimensions.
+    sk_sp<Coverage> makeCoverage(SkISize dimensions, const SkMatrix& matrix) const;
+
+    // Approximate number of bytes held by this glyph.
+    size_t approximateBytesUsed() const;
+
+private:
+    friend class Builder;
+    SkColrV1Glyph() = default;
+
+    void configurePaint(const Fill& fill, SkSpan<const SkColor> palette, SkPaint* paint) const;
+    // Returns nullptr for solid fills.
+    sk_sp<SkShader> makeShader(const Fill& fill, SkSpan<const SkColor> palette) const;
+
+    std::vector<Command>   fCommands;
+    std::vector<SkMatrix>  fMatrices;
+    std::vector<SkPath>    fPaths;
+    std::vector<Fill>      fFills;
+    std::vector<ColorStop> fStops;
+    std::vector<SkRect>    fBounds;
+    bool                   fCanRecolor = false;
+};
+
+/**
+ *  Per typeface cache of decoded COLRv1 glyphs. Glyphs without a COLRv1 paint graph are
+ *  remembered as well, so that each glyph is looked up in the COLR table at most once.
+ *
+ *  The cache also keeps the coverage of recently drawn glyphs which can be recolored, and such
+ *  glyphs are always drawn from it. Clones of a typeface which only differ in their palette share
+ *  its cache, so each palette only recolors them.
+ *
+ *  The unscaled outlines which paint graphs draw and clip with, and the clip boxes of COLRv1
+ *  glyphs, are kept as well. Many glyphs, and every size of a glyph, reuse the same outlines, and
+ *  computing bounds needs them as much as decoding does. They are kept within a byte budget,
+ *  dropping the least recently used first.
+ */
+class SkColrV1GlyphCache : public SkRefCnt {
+public:
+    // Returns true if glyphID has been looked up before; *glyph is then set to the cached
+    // entry, which is nullptr for glyphs without a COLRv1 paint graph.
+    bool find(SkGlyphID glyphID, sk_sp<SkColrV1Glyph>* glyph) const;
+
+    // Adds glyph (which may be nullptr) and returns the entry that is now in the cache.
+    sk_sp<SkColrV1Glyph> add(SkGlyphID glyphID, sk_sp<SkColrV1Glyph> glyph);
+
+    // Returns the coverage of glyph, the entry for glyphID, for a glyph image of dimensions
+    // drawn with matrix, making it on first use. Returns nullptr if glyph cannot be recolored.
+    sk_sp<SkColrV1Glyph::Coverage> findOrMakeCoverage(SkGlyphID glyphID,
+                                                      const SkColrV1Glyph& glyph,
+                                                      SkISize dimensions,
+                                                      const SkMatrix& matrix);
+
+    // Returns true if the outline of glyphID, in font units, is cached; *path is then set.
+    bool findOutline(SkGlyphID glyphID, SkPath* path);
+    void addOutline(SkGlyphID glyphID, const SkPath& path);
+
+    // Returns true if the clip box of glyphID, in font units, is cached; *clipBox is then set,
+    // and empty if glyphID has no clip box.
+    bool findClipBox(SkGlyphID glyphID, SkPath* clipBox);
+    void addClipBox(SkGlyphID glyphID, const SkPath& clipBox);
+
+    // Returns true if the bounds of what glyphID's paint graph draws, in font units, have been
+    // added; *bounds is then set. Unlike outlines, bounds are small and kept for good, so that
+    // measuring a glyph never has to walk its paint graph twice.
+    bool findBounds(SkGlyphID glyphID, SkRect* bounds) const;
+    void addBounds(SkGlyphID glyphID, const SkRect& bounds);
+
+    // The bytes held by decoded glyphs, coverage, outlines and bounds.
+    size_t bytesUsed() const;
+
+private:
+    // Coverage is kept up to this many bytes, and the least recently used is dropped first.
+    static constexpr size_t kCoverageBudget = 512 * 1024;
+    // Outlines and clip boxes are kept up to this many bytes, and the least recently used ones
+    // are dropped first.
+    static constexpr size_t kOutlineBudget = 1024 * 1024;
+
+    // Outlines and clip boxes share one LRU. The key of a clip box has kClipBoxKey set.
+    static constexpr uint32_t kClipBoxKey = 1 << 16;
+    struct Outline {
+        SkPath fPath;
+        size_t fBytesUsed;
+    };
+
+    bool findOutlineEntry(uint32_t key, SkPath* path);
+    void addOutlineEntry(uint32_t key, const SkPath& path);
+
+    struct CoverageKey {
+        SkGlyphID fGlyphID;
+        uint16_t  fPad;
+        SkISize   fDimensions;
+        SkScalar  fMatrix[9];
+
+        bool operator==(const CoverageKey& that) const {
+            return 0 == memcmp(this, &that, sizeof(CoverageKey));
+        }
+    };
+
+    mutable SkMutex fMutex;
+    SkTHashMap<SkGlyphID, sk_sp<SkColrV1Glyph>> fGlyphs SK_GUARDED_BY(fMutex);
+    size_t fBytesUsed SK_GUARDED_BY(fMutex) = 0;
+    SkLRUCache<CoverageKey, sk_sp<SkColrV1Glyph::Coverage>> fCoverage SK_GUARDED_BY(fMutex)
+            {std::numeric_limits<int>::max()};
+    size_t fCoverageBytes SK_GUARDED_BY(fMutex) = 0;
+
+    // Finding an outline updates the LRU, so it takes the lock exclusively.
+    mutable SkMutex fOutlineMutex;
+    SkLRUCache<uint32_t, Outline> fOutlines SK_GUARDED_BY(fOutlineMutex)
+            {std::numeric_limits<int>::max()};
+    size_t fOutlineBytes SK_GUARDED_BY(fOutlineMutex) = 0;
+
+    // Looked up on every bounds computation, so readers share the lock.
+    mutable SkSharedMutex fBoundsMutex;
+    SkTHashMap<SkGlyphID, SkRect> fBounds SK_GUARDED_BY(fBoundsMutex);
+};
+
+#endif
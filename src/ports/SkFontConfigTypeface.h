@@ -46,10 +46,11 @@ public:
         if (!data) {
             return nullptr;
         }
-        return sk_sp<SkTypeface>(new SkTypeface_FCI(std::move(data),
-                                                    fFamilyName,
-                                                    this->fontStyle(),
-                                                    this->isFixedPitch()));
+        sk_sp<SkTypeface_FreeType> clone(new SkTypeface_FCI(std::move(data),
+                                                            fFamilyName,
+                                                            this->fontStyle(),
+                                                            this->isFixedPitch()));
+        return this->shareColrV1Glyphs(std::move(clone), args);
     }
 
 protected:
@@ -8,10 +8,12 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkDrawable.h"
 #include "include/core/SkFontMetrics.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
+#include "include/ports/SkTypeface_freetype.h"
 #include "include/private/SkColorData.h"
 #include "include/private/SkMalloc.h"
 #include "include/private/SkMutex.h"
@@ -32,8 +34,11 @@
 #include "src/utils/SkCallableTraits.h"
 #include "src/utils/SkMatrix22.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <tuple>
+#include <vector>
 
 #include <ft2build.h>
 #include <freetype/ftadvanc.h>
@@ -95,8 +100,15 @@ using FT_Alloc_size_t = SkCallableTraits<FT_Alloc_Func>::argument<1>::type;
 static_assert(std::is_same<FT_Alloc_size_t, long  >::value ||
               std::is_same<FT_Alloc_size_t, size_t>::value,"");
 
+// When set, the bytes FreeType allocates on this thread are added to it.
+// Used to measure how much memory opening a pooled face takes.
+static thread_local size_t* gFTAllocatedBytes = nullptr;
+
 extern "C" {
     static void* sk_ft_alloc(FT_Memory, FT_Alloc_size_t size) {
+        if (gFTAllocatedBytes) {
+            *gFTAllocatedBytes += size;
+        }
         return sk_malloc_throw(size);
     }
     static void sk_ft_free(FT_Memory, void* block) {
@@ -104,6 +116,9 @@ extern "C" {
     }
     static void* sk_ft_realloc(FT_Memory, FT_Alloc_size_t cur_size,
                                           FT_Alloc_size_t new_size, void* block) {
+        if (gFTAllocatedBytes && new_size > cur_size) {
+            *gFTAllocatedBytes += new_size - cur_size;
+        }
         return sk_realloc_throw(block, new_size);
     }
 };
@@ -157,6 +172,9 @@ private:
     // RHEL 8             2.9.1
 };
 
+// Guards the FreeType library: its reference count, and opening and closing faces with it.
+// Everything done with an open face is guarded by that face's FaceRec::fMutex instead, so that
+// different faces can be used on different threads at the same time.
 static SkMutex& f_t_mutex() {
     static SkMutex& mutex = *(new SkMutex);
     return mutex;
@@ -164,6 +182,28 @@ static SkMutex& f_t_mutex() {
 
 static FreeTypeLibrary* gFTLibrary;
 
+// Limits of the face pool, see SkTypeface_FreeType::SetFacePoolLimits.
+static std::atomic<int>    gFacePoolMaxFaces{1};
+static std::atomic<size_t> gFacePoolByteLimit{0};
+static std::atomic<size_t> gFacePoolBytesUsed{0};
+
+void SkTypeface_FreeType::SetFacePoolLimits(int maxFacesPerTypeface, size_t byteLimit) {
+    gFacePoolMaxFaces.store(std::max(maxFacesPerTypeface, 1), std::memory_order_relaxed);
+    gFacePoolByteLimit.store(byteLimit, std::memory_order_relaxed);
+}
+
+size_t SkTypeface_FreeType::GetFacePoolBytesUsed() {
+    return gFacePoolBytesUsed.load(std::memory_order_relaxed);
+}
+
+void SkTypeface_SetFreeTypeFacePoolLimits(int maxFacesPerTypeface, size_t byteLimit) {
+    SkTypeface_FreeType::SetFacePoolLimits(maxFacesPerTypeface, byteLimit);
+}
+
+size_t SkTypeface_GetFreeTypeFacePoolBytesUsed() {
+    return SkTypeface_FreeType::GetFacePoolBytesUsed();
+}
+
 ///////////////////////////////////////////////////////////////////////////
 
 class SkTypeface_FreeType::FaceRec {
@@ -172,12 +212,66 @@ public:
     FT_StreamRec fFTStream;
     std::unique_ptr<SkStreamAsset> fSkStream;
 
+    // The CPAL palette selected by the font data and the overrides of its entries.
+    int fPaletteIndex = 0;
+    std::vector<SkFontArguments::Palette::Override> fPaletteOverrides;
+
+    // Guards fFace, including its glyph slot and the FT_Sizes created on it.
+    // An FT_Face may only be used by one thread at a time.
+    SkMutex fMutex;
+
+    /** An additional FT_Face opened on the same font data as fFace, with the same variation. */
+    struct PooledFace {
+        ~PooledFace();
+
+        // Only used if the font data is not in memory.
+        std::unique_ptr<SkStreamAsset> fSkStream;
+        FT_StreamRec fFTStream;
+        // What opening fFace allocated, counted against the face pool byte limit.
+        size_t fBytes = 0;
+
+        SkUniqueFTFace fFace;
+        // Guards fFace, like FaceRec::fMutex.
+        SkMutex fMutex;
+    };
+
+    // Returns a face for the exclusive use of one scaler context, or nullptr if the face pool
+    // is disabled or full, in which case fFace should be shared.
+    std::unique_ptr<PooledFace> checkOutFace();
+    // Returns a face from checkOutFace() to the pool.
+    void checkInFace(std::unique_ptr<PooledFace> face);
+    void getPoolCounts(int* open, int* idle);
+    // Limits of the pool of this typeface alone, see SkTypeface_FreeType::setFacePoolLimits.
+    void setPoolLimits(int maxFaces, size_t byteLimit);
+
     static std::unique_ptr<FaceRec> Make(const SkTypeface_FreeType* typeface);
     ~FaceRec();
 
 private:
     FaceRec(std::unique_ptr<SkStreamAsset> stream);
-    void setupAxes(const SkFontData& data);
+
+    // Caller must lock f_t_mutex() before calling this function.
+    FT_Error openFace(SkStreamAsset* stream, FT_StreamRec* ftStream, SkUniqueFTFace* face) const;
+    void setupAxes(FT_Face face) const;
+
+    // The limits of this typeface if it has its own, or else the global ones, and what counts
+    // against the byte limit.
+    int poolMaxFaces() const SK_REQUIRES(fPoolMutex);
+    size_t poolByteLimit() const SK_REQUIRES(fPoolMutex);
+    size_t poolBytesUsed() const SK_REQUIRES(fPoolMutex);
+
+    int fFaceIndex = 0;
+    SkSTArray<4, FT_Fixed, true> fAxes;
+
+    SkMutex fPoolMutex;
+    std::vector<std::unique_ptr<PooledFace>> fIdleFaces SK_GUARDED_BY(fPoolMutex);
+    // Pooled faces currently open, whether idle or checked out.
+    int fPooledFaceCount SK_GUARDED_BY(fPoolMutex) = 0;
+    // What the pooled faces of this typeface allocated.
+    size_t fPooledBytes SK_GUARDED_BY(fPoolMutex) = 0;
+    bool fHasPoolLimits SK_GUARDED_BY(fPoolMutex) = false;
+    int fPoolMaxFaces SK_GUARDED_BY(fPoolMutex) = 1;
+    size_t fPoolByteLimit SK_GUARDED_BY(fPoolMutex) = 0;
 
     // Private to ref_ft_library and unref_ft_library
     static int gFTCount;
@@ -230,14 +324,18 @@ extern "C" {
     static void sk_ft_stream_close(FT_Stream) {}
 }
 
+static void init_ft_stream(FT_StreamRec* ftStream, SkStreamAsset* stream) {
+    sk_bzero(ftStream, sizeof(*ftStream));
+    ftStream->size = stream->getLength();
+    ftStream->descriptor.pointer = stream;
+    ftStream->read  = sk_ft_stream_io;
+    ftStream->close = sk_ft_stream_close;
+}
+
 SkTypeface_FreeType::FaceRec::FaceRec(std::unique_ptr<SkStreamAsset> stream)
         : fSkStream(std::move(stream))
 {
-    sk_bzero(&fFTStream, sizeof(fFTStream));
-    fFTStream.size = fSkStream->getLength();
-    fFTStream.descriptor.pointer = fSkStream.get();
-    fFTStream.read  = sk_ft_stream_io;
-    fFTStream.close = sk_ft_stream_close;
+    init_ft_stream(&fFTStream, fSkStream.get());
 
     f_t_mutex().assertHeld();
     ref_ft_library();
@@ -245,43 +343,185 @@ SkTypeface_FreeType::FaceRec::FaceRec(std::unique_ptr<SkStreamAsset> stream)
 
 SkTypeface_FreeType::FaceRec::~FaceRec() {
     f_t_mutex().assertHeld();
+    // Checked out faces are owned by scaler contexts, which keep the typeface and so this alive.
+    {
+        SkAutoMutexExclusive lock(fPoolMutex);
+        SkASSERT(fPooledFaceCount == (int)fIdleFaces.size());
+        fIdleFaces.clear();
+    }
     fFace.reset(); // Must release face before the library, the library frees existing faces.
     unref_ft_library();
 }
 
-void SkTypeface_FreeType::FaceRec::setupAxes(const SkFontData& data) {
-    if (!(fFace->face_flags & FT_FACE_FLAG_MULTIPLE_MASTERS)) {
+SkTypeface_FreeType::FaceRec::PooledFace::~PooledFace() {
+    f_t_mutex().assertHeld();
+    gFacePoolBytesUsed.fetch_sub(fBytes, std::memory_order_relaxed);
+}
+
+std::unique_ptr<SkTypeface_FreeType::FaceRec::PooledFace>
+SkTypeface_FreeType::FaceRec::checkOutFace() {
+    {
+        SkAutoMutexExclusive lock(fPoolMutex);
+        if (!fIdleFaces.empty()) {
+            std::unique_ptr<PooledFace> face = std::move(fIdleFaces.back());
+            fIdleFaces.pop_back();
+            return face;
+        }
+        // fFace counts as one of the faces of this typeface.
+        if (fPooledFaceCount + 1 >= this->poolMaxFaces() ||
+            this->poolBytesUsed() >= this->poolByteLimit())
+        {
+            return nullptr;
+        }
+        ++fPooledFaceCount;
+    }
+
+    auto face = std::make_unique<PooledFace>();
+    SkStreamAsset* stream = fSkStream.get();
+    if (!stream->getMemoryBase()) {
+        // The stream position is shared with fFace, so give the new face its own stream.
+        SkAutoMutexExclusive ac(fMutex);
+        face->fSkStream = fSkStream->duplicate();
+        stream = face->fSkStream.get();
+    }
+
+    SkAutoMutexExclusive ac(f_t_mutex());
+    FT_Error err = 1;
+    if (stream) {
+        init_ft_stream(&face->fFTStream, stream);
+        size_t bytes = 0;
+        gFTAllocatedBytes = &bytes;
+        err = this->openFace(stream, &face->fFTStream, &face->fFace);
+        if (!err) {
+            this->setupAxes(face->fFace.get());
+        }
+        gFTAllocatedBytes = nullptr;
+
+        face->fBytes = bytes;
+        gFacePoolBytesUsed.fetch_add(bytes, std::memory_order_relaxed);
+        SkAutoMutexExclusive lock(fPoolMutex);
+        fPooledBytes += bytes;
+        if (this->poolBytesUsed() > this->poolByteLimit()) {
+            err = 1;
+        }
+    }
+    if (err) {
+        SkAutoMutexExclusive lock(fPoolMutex);
+        fPooledBytes -= face->fBytes;
+        --fPooledFaceCount;
+        face.reset();
+        return nullptr;
+    }
+    return face;
+}
+
+void SkTypeface_FreeType::FaceRec::checkInFace(std::unique_ptr<PooledFace> face) {
+    SkASSERT(face);
+    {
+        SkAutoMutexExclusive lock(fPoolMutex);
+        // Keep the face unless the limits were lowered since it was opened.
+        if (fPooledFaceCount < this->poolMaxFaces() &&
+            this->poolBytesUsed() <= this->poolByteLimit())
+        {
+            fIdleFaces.push_back(std::move(face));
+            return;
+        }
+        fPooledBytes -= face->fBytes;
+        --fPooledFaceCount;
+    }
+    SkAutoMutexExclusive ac(f_t_mutex());
+    face.reset();
+}
+
+void SkTypeface_FreeType::FaceRec::getPoolCounts(int* open, int* idle) {
+    SkAutoMutexExclusive lock(fPoolMutex);
+    *open = fPooledFaceCount;
+    *idle = (int)fIdleFaces.size();
+}
+
+void SkTypeface_FreeType::FaceRec::setPoolLimits(int maxFaces, size_t byteLimit) {
+    SkAutoMutexExclusive lock(fPoolMutex);
+    fHasPoolLimits = true;
+    fPoolMaxFaces = std::max(maxFaces, 1);
+    fPoolByteLimit = byteLimit;
+}
+
+int SkTypeface_FreeType::FaceRec::poolMaxFaces() const {
+    return fHasPoolLimits ? fPoolMaxFaces : gFacePoolMaxFaces.load(std::memory_order_relaxed);
+}
+
+size_t SkTypeface_FreeType::FaceRec::poolByteLimit() const {
+    return fHasPoolLimits ? fPoolByteLimit : gFacePoolByteLimit.load(std::memory_order_relaxed);
+}
+
+size_t SkTypeface_FreeType::FaceRec::poolBytesUsed() const {
+    return fHasPoolLimits ? fPooledBytes : gFacePoolBytesUsed.load(std::memory_order_relaxed);
+}
+
+FT_Error SkTypeface_FreeType::FaceRec::openFace(SkStreamAsset* stream, FT_StreamRec* ftStream,
+                                                SkUniqueFTFace* face) const {
+    f_t_mutex().assertHeld();
+
+    FT_Open_Args args;
+    memset(&args, 0, sizeof(args));
+    const void* memoryBase = stream->getMemoryBase();
+    if (memoryBase) {
+        args.flags = FT_OPEN_MEMORY;
+        args.memory_base = (const FT_Byte*)memoryBase;
+        args.memory_size = stream->getLength();
+    } else {
+        args.flags = FT_OPEN_STREAM;
+        args.stream = ftStream;
+    }
+
+    FT_Face rawFace;
+    FT_Error err = FT_Open_Face(gFTLibrary->library(), &args, fFaceIndex, &rawFace);
+    if (err) {
+        return err;
+    }
+    face->reset(rawFace);
+
+    // FreeType will set the charmap to the "most unicode" cmap if it exists.
+    // If there are no unicode cmaps, the charmap is set to nullptr.
+    // However, "symbol" cmaps should also be considered "fallback unicode" cmaps
+    // because they are effectively private use area only (even if they aren't).
+    // This is the last on the fallback list at
+    // https://developer.apple.com/fonts/TrueType-Reference-Manual/RM06/Chap6cmap.html
+    if (!rawFace->charmap) {
+        FT_Select_Charmap(rawFace, FT_ENCODING_MS_SYMBOL);
+    }
+    return 0;
+}
+
+void SkTypeface_FreeType::FaceRec::setupAxes(FT_Face face) const {
+    if (!(face->face_flags & FT_FACE_FLAG_MULTIPLE_MASTERS)) {
         return;
     }
 
     // If a named variation is requested, don't overwrite the named variation's position.
-    if (data.getIndex() > 0xFFFF) {
+    if (fFaceIndex > 0xFFFF) {
         return;
     }
 
     SkDEBUGCODE(
         FT_MM_Var* variations = nullptr;
-        if (FT_Get_MM_Var(fFace.get(), &variations)) {
+        if (FT_Get_MM_Var(face, &variations)) {
             LOG_INFO("INFO: font %s claims variations, but none found.\n",
-                     rec->fFace->family_name);
+                     face->family_name);
             return;
         }
         SkAutoFree autoFreeVariations(variations);
 
-        if (static_cast<FT_UInt>(data.getAxisCount()) != variations->num_axis) {
+        if (static_cast<FT_UInt>(fAxes.count()) != variations->num_axis) {
             LOG_INFO("INFO: font %s has %d variations, but %d were specified.\n",
-                     rec->fFace->family_name, variations->num_axis, data.getAxisCount());
+                     face->family_name, variations->num_axis, fAxes.count());
             return;
         }
     )
 
-    SkAutoSTMalloc<4, FT_Fixed> coords(data.getAxisCount());
-    for (int i = 0; i < data.getAxisCount(); ++i) {
-        coords[i] = data.getAxis()[i];
-    }
-    if (FT_Set_Var_Design_Coordinates(fFace.get(), data.getAxisCount(), coords.get())) {
+    if (FT_Set_Var_Design_Coordinates(face, fAxes.count(), const_cast<FT_Fixed*>(fAxes.begin()))) {
         LOG_INFO("INFO: font %s has variations, but specified variations could not be set.\n",
-                 rec->fFace->family_name);
+                 face->family_name);
         return;
     }
 }
@@ -298,54 +538,37 @@ SkTypeface_FreeType::FaceRec::Make(const SkTypeface_FreeType* typeface) {
     }
 
     std::unique_ptr<FaceRec> rec(new FaceRec(data->detachStream()));
-
-    FT_Open_Args args;
-    memset(&args, 0, sizeof(args));
-    const void* memoryBase = rec->fSkStream->getMemoryBase();
-    if (memoryBase) {
-        args.flags = FT_OPEN_MEMORY;
-        args.memory_base = (const FT_Byte*)memoryBase;
-        args.memory_size = rec->fSkStream->getLength();
-    } else {
-        args.flags = FT_OPEN_STREAM;
-        args.stream = &rec->fFTStream;
+    rec->fFaceIndex = data->getIndex();
+    for (int i = 0; i < data->getAxisCount(); ++i) {
+        rec->fAxes.push_back(data->getAxis()[i]);
     }
+    rec->fPaletteIndex = data->getPaletteIndex();
+    rec->fPaletteOverrides = data->getPaletteOverrides();
 
-    {
-        FT_Face rawFace;
-        FT_Error err = FT_Open_Face(gFTLibrary->library(), &args, data->getIndex(), &rawFace);
-        if (err) {
-            SK_TRACEFTR(err, "unable to open font '%x'", typeface->uniqueID());
-            return nullptr;
-        }
-        rec->fFace.reset(rawFace);
+    FT_Error err = rec->openFace(rec->fSkStream.get(), &rec->fFTStream, &rec->fFace);
+    if (err) {
+        SK_TRACEFTR(err, "unable to open font '%x'", typeface->uniqueID());
+        return nullptr;
     }
     SkASSERT(rec->fFace);
 
-    rec->setupAxes(*data);
-
-    // FreeType will set the charmap to the "most unicode" cmap if it exists.
-    // If there are no unicode cmaps, the charmap is set to nullptr.
-    // However, "symbol" cmaps should also be considered "fallback unicode" cmaps
-    // because they are effectively private use area only (even if they aren't).
-    // This is the last on the fallback list at
-    // https://developer.apple.com/fonts/TrueType-Reference-Manual/RM06/Chap6cmap.html
-    if (!rec->fFace->charmap) {
-        FT_Select_Charmap(rec->fFace.get(), FT_ENCODING_MS_SYMBOL);
-    }
+    rec->setupAxes(rec->fFace.get());
 
     return rec;
 }
 
 class AutoFTAccess {
 public:
-    AutoFTAccess(const SkTypeface_FreeType* tf) : fFaceRec(nullptr) {
-        f_t_mutex().acquire();
-        fFaceRec = tf->getFaceRec();
+    AutoFTAccess(const SkTypeface_FreeType* tf) : fFaceRec(tf->getFaceRec()) {
+        if (fFaceRec) {
+            fFaceRec->fMutex.acquire();
+        }
     }
 
     ~AutoFTAccess() {
-        f_t_mutex().release();
+        if (fFaceRec) {
+            fFaceRec->fMutex.release();
+        }
     }
 
     FT_Face face() { return fFaceRec ? fFaceRec->fFace.get() : nullptr; }
@@ -372,11 +595,15 @@ protected:
     void generateMetrics(SkGlyph* glyph) override;
     void generateImage(const SkGlyph& glyph) override;
     bool generatePath(SkGlyphID glyphID, SkPath* path) override;
+    sk_sp<SkDrawable> generateDrawable(const SkGlyph& glyph) override;
     void generateFontMetrics(SkFontMetrics*) override;
 
 private:
     SkTypeface_FreeType::FaceRec* fFaceRec; // Borrowed face from the typeface's FaceRec.
-    FT_Face   fFace;  // Borrowed face from fFaceRec.
+    // A face of our own from fFaceRec's face pool, or nullptr to share fFaceRec->fFace.
+    std::unique_ptr<SkTypeface_FreeType::FaceRec::PooledFace> fPooledFace;
+    SkMutex*  fFaceMutex; // Guards fFace.
+    FT_Face   fFace;  // Borrowed face from fPooledFace or fFaceRec.
     FT_Size   fFTSize;  // The size to apply to the fFace.
     FT_Int    fStrikeIndex; // The bitmap strike for the fFace (or -1 if none).
 
@@ -394,13 +621,14 @@ private:
     bool      fDoLinearMetrics;
     bool      fLCDIsVert;
 
+    // Caller must lock fFaceMutex before calling this function.
     FT_Error setupSize();
     void getBBoxForCurrentGlyph(const SkGlyph* glyph, FT_BBox* bbox,
                                 bool snapToPixelBoundary = false);
     bool getCBoxForLetter(char letter, FT_BBox* bbox);
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock fFaceMutex before calling this function.
     void updateGlyphIfLCD(SkGlyph* glyph);
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock fFaceMutex before calling this function.
     // update FreeType2 glyph slot with glyph emboldened
     void emboldenIfNeeded(FT_Face face, FT_GlyphSlot glyph, SkGlyphID gid);
     bool shouldSubpixelBitmap(const SkGlyph&, const SkMatrix&);
@@ -647,7 +875,27 @@ std::unique_ptr<SkFontData> SkTypeface_FreeType::cloneFontData(const SkFontArgum
                                currentAxisCount == axisCount ? currentPosition.get() : nullptr);
     int ttcIndex;
     std::unique_ptr<SkStreamAsset> stream = this->openStream(&ttcIndex);
-    return std::make_unique<SkFontData>(std::move(stream), ttcIndex, axisValues.get(), axisCount);
+    auto data = std::make_unique<SkFontData>(std::move(stream), ttcIndex,
+                                             axisValues.get(), axisCount);
+
+    // Like the variation, the palette is kept unless args specify one. The overrides of args
+    // are applied after, and so take precedence over, the current ones.
+    const SkFontArguments::Palette palette = args.getPalette();
+    const int paletteIndex = args.hasPalette() ? palette.index : this->getFaceRec()->fPaletteIndex;
+    std::vector<SkFontArguments::Palette::Override> overrides =
+            this->getFaceRec()->fPaletteOverrides;
+    overrides.insert(overrides.end(), palette.overrides, palette.overrides + palette.overrideCount);
+    data->setPalette({paletteIndex, overrides.data(), SkToInt(overrides.size())});
+    return data;
+}
+
+sk_sp<SkTypeface> SkTypeface_FreeType::shareColrV1Glyphs(sk_sp<SkTypeface_FreeType> clone,
+                                                         const SkFontArguments& args) const {
+    // cloneFontData() keeps the current variation when args do not specify one.
+    if (clone && args.getVariationDesignPosition().coordinateCount == 0) {
+        clone->fColrV1GlyphCache = fColrV1GlyphCache;
+    }
+    return clone;
 }
 
 void SkTypeface_FreeType::onFilterRec(SkScalerContextRec* rec) const {
@@ -703,6 +951,28 @@ int SkTypeface_FreeType::onGetUPEM() const {
     return GetUnitsPerEm(face);
 }
 
+void SkTypeface_FreeType::onGetColorGlyphBounds(const SkGlyphID glyphs[], int count,
+                                                SkRect bounds[], bool found[]) const {
+#ifdef TT_SUPPORT_COLRV1
+    AutoFTAccess fta(this);
+    FT_Face face = fta.face();
+    if (!face || !FT_HAS_COLOR(face) || face->units_per_EM == 0) {
+        return;
+    }
+
+    const SkMatrix toTextSizeOne = SkMatrix::Scale(1.0f / face->units_per_EM,
+                                                   1.0f / face->units_per_EM);
+    for (int i = 0; i < count; ++i) {
+        SkRect fontBounds;
+        if (SkScalerContext_FreeType_Base::ComputeColrV1GlyphFontBounds(
+                    face, fColrV1GlyphCache.get(), glyphs[i], &fontBounds)) {
+            toTextSizeOne.mapRectScaleTranslate(&bounds[i], fontBounds);
+            found[i] = true;
+        }
+    }
+#endif
+}
+
 bool SkTypeface_FreeType::onGetKerningPairAdjustments(const uint16_t glyphs[],
                                       int count, int32_t adjustments[]) const {
     AutoFTAccess fta(this);
@@ -759,11 +1029,11 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
                                                    const SkScalerContextEffects& effects,
                                                    const SkDescriptor* desc)
     : SkScalerContext_FreeType_Base(std::move(typeface), effects, desc)
+    , fFaceMutex(nullptr)
     , fFace(nullptr)
     , fFTSize(nullptr)
     , fStrikeIndex(-1)
 {
-    SkAutoMutexExclusive  ac(f_t_mutex());
     fFaceRec = static_cast<SkTypeface_FreeType*>(this->getTypeface())->getFaceRec();
 
     // load the font file
@@ -772,6 +1042,21 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
         return;
     }
 
+    // With a face of its own this context does not contend with others of the same typeface.
+    // The face is kept until this is destroyed, as fFTSize belongs to it, so the pool only helps
+    // as many contexts as it has faces; see SkTypeface_SetFreeTypeFacePoolLimits().
+    fPooledFace = fFaceRec->checkOutFace();
+    FT_Face face;
+    if (fPooledFace) {
+        fFaceMutex = &fPooledFace->fMutex;
+        face = fPooledFace->fFace.get();
+    } else {
+        fFaceMutex = &fFaceRec->fMutex;
+        face = fFaceRec->fFace.get();
+    }
+
+    SkAutoMutexExclusive  ac(*fFaceMutex);
+
     fLCDIsVert = SkToBool(fRec.fFlags & SkScalerContext::kLCD_Vertical_Flag);
 
     // compute the flags we send to Load_Glyph
@@ -843,11 +1128,11 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
     }
 
     using DoneFTSize = SkFunctionWrapper<decltype(FT_Done_Size), FT_Done_Size>;
-    std::unique_ptr<std::remove_pointer_t<FT_Size>, DoneFTSize> ftSize([this]() -> FT_Size {
+    std::unique_ptr<std::remove_pointer_t<FT_Size>, DoneFTSize> ftSize([face]() -> FT_Size {
         FT_Size size;
-        FT_Error err = FT_New_Size(fFaceRec->fFace.get(), &size);
+        FT_Error err = FT_New_Size(face, &size);
         if (err != 0) {
-            SK_TRACEFTR(err, "FT_New_Size(%s) failed.", fFaceRec->fFace->family_name);
+            SK_TRACEFTR(err, "FT_New_Size(%s) failed.", face->family_name);
             return nullptr;
         }
         return size;
@@ -859,7 +1144,7 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
 
     FT_Error err = FT_Activate_Size(ftSize.get());
     if (err != 0) {
-        SK_TRACEFTR(err, "FT_Activate_Size(%s) failed.", fFaceRec->fFace->family_name);
+        SK_TRACEFTR(err, "FT_Activate_Size(%s) failed.", face->family_name);
         return;
     }
 
@@ -867,11 +1152,11 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
     FT_F26Dot6 scaleX = SkScalarToFDot6(fScale.fX);
     FT_F26Dot6 scaleY = SkScalarToFDot6(fScale.fY);
 
-    if (FT_IS_SCALABLE(fFaceRec->fFace)) {
-        err = FT_Set_Char_Size(fFaceRec->fFace.get(), scaleX, scaleY, 72, 72);
+    if (FT_IS_SCALABLE(face)) {
+        err = FT_Set_Char_Size(face, scaleX, scaleY, 72, 72);
         if (err != 0) {
             SK_TRACEFTR(err, "FT_Set_CharSize(%s, %f, %f) failed.",
-                        fFaceRec->fFace->family_name, fScale.fX, fScale.fY);
+                        face->family_name, fScale.fX, fScale.fY);
             return;
         }
 
@@ -879,33 +1164,33 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
         // FreeType currently does not allow requesting sizes less than 1, this allow for scaling.
         // Don't do this at all sizes as that will interfere with hinting.
         if (fScale.fX < 1 || fScale.fY < 1) {
-            SkScalar upem = fFaceRec->fFace->units_per_EM;
-            FT_Size_Metrics& ftmetrics = fFaceRec->fFace->size->metrics;
+            SkScalar upem = face->units_per_EM;
+            FT_Size_Metrics& ftmetrics = face->size->metrics;
             SkScalar x_ppem = upem * SkFT_FixedToScalar(ftmetrics.x_scale) / 64.0f;
             SkScalar y_ppem = upem * SkFT_FixedToScalar(ftmetrics.y_scale) / 64.0f;
             fMatrix22Scalar.preScale(fScale.x() / x_ppem, fScale.y() / y_ppem);
         }
 
-    } else if (FT_HAS_FIXED_SIZES(fFaceRec->fFace)) {
-        fStrikeIndex = chooseBitmapStrike(fFaceRec->fFace.get(), scaleY);
+    } else if (FT_HAS_FIXED_SIZES(face)) {
+        fStrikeIndex = chooseBitmapStrike(face, scaleY);
         if (fStrikeIndex == -1) {
             LOG_INFO("No glyphs for font \"%s\" size %f.\n",
-                     fFaceRec->fFace->family_name, fScale.fY);
+                     face->family_name, fScale.fY);
             return;
         }
 
-        err = FT_Select_Size(fFaceRec->fFace.get(), fStrikeIndex);
+        err = FT_Select_Size(face, fStrikeIndex);
         if (err != 0) {
             SK_TRACEFTR(err, "FT_Select_Size(%s, %d) failed.",
-                        fFaceRec->fFace->family_name, fStrikeIndex);
+                        face->family_name, fStrikeIndex);
             fStrikeIndex = -1;
             return;
         }
 
         // Adjust the matrix to reflect the actually chosen scale.
         // It is likely that the ppem chosen was not the one requested, this allows for scaling.
-        fMatrix22Scalar.preScale(fScale.x() / fFaceRec->fFace->size->metrics.x_ppem,
-                                 fScale.y() / fFaceRec->fFace->size->metrics.y_ppem);
+        fMatrix22Scalar.preScale(fScale.x() / face->size->metrics.x_ppem,
+                                 fScale.y() / face->size->metrics.y_ppem);
 
         // FreeType does not provide linear metrics for bitmap fonts.
         linearMetrics = false;
@@ -918,7 +1203,7 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
         // Force this flag off for bitmap only fonts.
         fLoadGlyphFlags &= ~FT_LOAD_NO_BITMAP;
     } else {
-        LOG_INFO("Unknown kind of font \"%s\" size %f.\n", fFaceRec->fFace->family_name, fScale.fY);
+        LOG_INFO("Unknown kind of font \"%s\" size %f.\n", face->family_name, fScale.fY);
         return;
     }
 
@@ -927,21 +1212,23 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
     fMatrix22.yx = SkScalarToFixed(-fMatrix22Scalar.getSkewY());
     fMatrix22.yy = SkScalarToFixed(fMatrix22Scalar.getScaleY());
 
-#ifdef FT_COLOR_H
-    FT_Palette_Select(fFaceRec->fFace.get(), 0, nullptr);
-#endif
+    fPaletteIndex = fFaceRec->fPaletteIndex;
+    fPaletteOverrides = SkMakeSpan(fFaceRec->fPaletteOverrides);
+    this->selectPalette(face);
 
     fFTSize = ftSize.release();
-    fFace = fFaceRec->fFace.get();
+    fFace = face;
     fDoLinearMetrics = linearMetrics;
 }
 
 SkScalerContext_FreeType::~SkScalerContext_FreeType() {
-    SkAutoMutexExclusive  ac(f_t_mutex());
-
     if (fFTSize != nullptr) {
+        SkAutoMutexExclusive  ac(*fFaceMutex);
         FT_Done_Size(fFTSize);
     }
+    if (fPooledFace) {
+        fFaceRec->checkInFace(std::move(fPooledFace));
+    }
 
     fFaceRec = nullptr;
 }
@@ -950,7 +1237,7 @@ SkScalerContext_FreeType::~SkScalerContext_FreeType() {
     this face with other context (at different sizes).
 */
 FT_Error SkScalerContext_FreeType::setupSize() {
-    f_t_mutex().assertHeld();
+    fFaceMutex->assertHeld();
     FT_Error err = FT_Activate_Size(fFTSize);
     if (err != 0) {
         return err;
@@ -967,7 +1254,7 @@ bool SkScalerContext_FreeType::generateAdvance(SkGlyph* glyph) {
         return false;
     }
 
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     if (this->setupSize()) {
         glyph->zeroMetrics();
@@ -1072,7 +1359,7 @@ bool SkScalerContext_FreeType::shouldSubpixelBitmap(const SkGlyph& glyph, const
 }
 
 void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     glyph->fMaskFormat = fRec.fMaskFormat;
 
@@ -1138,24 +1425,29 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
               // Otherwise we need to traverse the glyph graph with a focus on measuring the
               // required bounding box.
               FT_BBox computed_bounds;
-              if (!computeColrV1GlyphBoundingBox(fFace, glyph->getGlyphID(), &computed_bounds)) {
+              bool faceChanged;
+              if (!computeColrV1GlyphBoundingBox(fFace, glyph->getGlyphID(), &computed_bounds,
+                                                 &faceChanged)) {
                   glyph->zeroMetrics();
                   return;
               }
 
               // Reset face so the main glyph slot contains information about the
               // base glyph again, for usage for computing and copying horizontal
-              // metrics from FreeType to Skia below.
-              if (this->setupSize()) {
-                  glyph->zeroMetrics();
-                  return;
-              }
-
-              err = FT_Load_Glyph(
-                      fFace, glyph->getGlyphID(), fLoadGlyphFlags | FT_LOAD_BITMAP_METRICS_ONLY);
-              if (err != 0) {
-                  glyph->zeroMetrics();
-                  return;
+              // metrics from FreeType to Skia below. Bounds already known to the
+              // typeface leave the face alone.
+              if (faceChanged) {
+                  if (this->setupSize()) {
+                      glyph->zeroMetrics();
+                      return;
+                  }
+
+                  err = FT_Load_Glyph(fFace, glyph->getGlyphID(),
+                                      fLoadGlyphFlags | FT_LOAD_BITMAP_METRICS_ONLY);
+                  if (err != 0) {
+                      glyph->zeroMetrics();
+                      return;
+                  }
               }
 
               bounds = computed_bounds;
@@ -1290,7 +1582,7 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
 }
 
 void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph) {
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     if (this->setupSize()) {
         sk_bzero(glyph.fImage, glyph.imageSize());
@@ -1323,7 +1615,7 @@ void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph) {
 bool SkScalerContext_FreeType::generatePath(SkGlyphID glyphID, SkPath* path) {
     SkASSERT(path);
 
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     // FT_IS_SCALABLE is documented to mean the face contains outline glyphs.
     if (!FT_IS_SCALABLE(fFace) || this->setupSize()) {
@@ -1359,12 +1651,21 @@ bool SkScalerContext_FreeType::generatePath(SkGlyphID glyphID, SkPath* path) {
     return true;
 }
 
+sk_sp<SkDrawable> SkScalerContext_FreeType::generateDrawable(const SkGlyph& glyph) {
+    SkAutoMutexExclusive  ac(*fFaceMutex);
+
+    if (this->setupSize()) {
+        return nullptr;
+    }
+    return this->generateGlyphDrawable(fFace, glyph);
+}
+
 void SkScalerContext_FreeType::generateFontMetrics(SkFontMetrics* metrics) {
     if (nullptr == metrics) {
         return;
     }
 
-    SkAutoMutexExclusive ac(f_t_mutex());
+    SkAutoMutexExclusive ac(*fFaceMutex);
 
     if (this->setupSize()) {
         sk_bzero(metrics, sizeof(*metrics));
@@ -1549,6 +1850,7 @@ void SkScalerContext_FreeType::emboldenIfNeeded(FT_Face face, FT_GlyphSlot glyph
 
 SkTypeface_FreeType::SkTypeface_FreeType(const SkFontStyle& style, bool isFixedPitch)
     : INHERITED(style, isFixedPitch)
+    , fColrV1GlyphCache(sk_make_sp<SkColrV1GlyphCache>())
 {}
 
 SkTypeface_FreeType::~SkTypeface_FreeType() {
@@ -1761,8 +2063,10 @@ sk_sp<SkData> SkTypeface_FreeType::onCopyTableData(SkFontTableTag tag) const {
 }
 
 SkTypeface_FreeType::FaceRec* SkTypeface_FreeType::getFaceRec() const {
-    f_t_mutex().assertHeld();
-    fFTFaceOnce([this]{ fFaceRec = SkTypeface_FreeType::FaceRec::Make(this); });
+    fFTFaceOnce([this]{
+        SkAutoMutexExclusive ac(f_t_mutex());
+        fFaceRec = SkTypeface_FreeType::FaceRec::Make(this);
+    });
     return fFaceRec.get();
 }
 
@@ -1770,6 +2074,30 @@ std::unique_ptr<SkFontData> SkTypeface_FreeType::makeFontData() const {
     return this->onMakeFontData();
 }
 
+void SkTypeface_FreeType::getFacePoolCounts(int* open, int* idle) const {
+    *open = *idle = 0;
+    if (FaceRec* rec = this->getFaceRec()) {
+        rec->getPoolCounts(open, idle);
+    }
+}
+
+sk_sp<SkColrV1Glyph> SkTypeface_FreeType::buildColrV1Glyph(SkGlyphID glyphID,
+                                                          bool elideCompositeLayers) const {
+    AutoFTAccess fta(this);
+    FT_Face face = fta.face();
+    if (!face) {
+        return nullptr;
+    }
+    return SkScalerContext_FreeType_Base::BuildColrV1Glyph(face, fColrV1GlyphCache.get(), glyphID,
+                                                           elideCompositeLayers);
+}
+
+void SkTypeface_FreeType::setFacePoolLimits(int maxFaces, size_t byteLimit) {
+    if (FaceRec* rec = this->getFaceRec()) {
+        rec->setPoolLimits(maxFaces, byteLimit);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
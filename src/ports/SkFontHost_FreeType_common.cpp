@@ -9,11 +9,13 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
+#include "include/core/SkDrawable.h"
 #include "include/core/SkPath.h"
 #include "include/effects/SkGradientShader.h"
 #include "include/private/SkColorData.h"
 #include "include/private/SkTo.h"
 #include "src/core/SkFDot6.h"
+#include "src/ports/SkColrV1Glyph.h"
 #include "src/ports/SkFontHost_FreeType_common.h"
 
 #include <utility>
@@ -393,7 +395,8 @@ struct OpaquePaintHasher {
 
 using VisitedSet = SkTHashSet<FT_OpaquePaint, OpaquePaintHasher>;
 
-bool generateFacePathCOLRv1(FT_Face face, SkGlyphID glyphID, SkPath* path);
+bool generateFacePathCOLRv1(FT_Face face, SkColrV1GlyphCache* cache, SkGlyphID glyphID,
+                            SkPath* path);
 
 inline float SkColrV1AlphaToFloat(uint16_t alpha) { return (alpha / float(1 << 14)); }
 
@@ -490,61 +493,56 @@ inline SkPoint SkVectorProjection(SkPoint a, SkPoint b) {
     return b_normalized;
 }
 
-void colrv1_configure_skpaint(FT_Face face, const FT_Color* palette,
-                              FT_COLR_Paint colrv1_paint, SkPaint* paint) {
-
-    auto fetch_color_stops = [&face, &palette](FT_ColorStopIterator& color_stop_iterator,
-                                               std::vector<SkScalar>& stops,
-                                               std::vector<SkColor>& colors) {
-        const FT_UInt num_color_stops = color_stop_iterator.num_color_stops;
-
-        // 5.7.11.2.4 ColorIndex, ColorStop and ColorLine
-        // "Applications shall apply the colorStops in increasing stopOffset order."
-        struct ColorStop {
-          SkScalar stop_pos;
-          SkColor color;
-        };
-        std::vector<ColorStop> sorted_stops;
-        sorted_stops.resize(num_color_stops);
-
-        FT_ColorStop color_stop;
-        while (FT_Get_Colorline_Stops(face, &color_stop, &color_stop_iterator)) {
-            FT_UInt index = color_stop_iterator.current_color_stop - 1;
-            sorted_stops[index].stop_pos = color_stop.stop_offset / float(1 << 14);
-            FT_UInt16& palette_index = color_stop.color.palette_index;
-            // TODO(drott): Ensure palette_index is sanitized on the FreeType
-            // side and 0xFFFF foreground color will be handled correctly here.
-            sorted_stops[index].color = SkColorSetARGB(
-                    palette[palette_index].alpha * SkColrV1AlphaToFloat(color_stop.color.alpha),
-                    palette[palette_index].red,
-                    palette[palette_index].green,
-                    palette[palette_index].blue);
-        }
+using ColorStops = std::vector<SkColrV1Glyph::ColorStop>;
+
+// An unconfigured SkPaint draws opaque black, degenerate fills keep doing so.
+constexpr SkColrV1Glyph::ColorStop kBlackColorStop = {0, SkColrV1Glyph::kForegroundPaletteIndex,
+                                                      1.0f};
+
+void colrv1_fetch_color_stops(FT_Face face,
+                              FT_ColorStopIterator& color_stop_iterator,
+                              ColorStops* stops) {
+    const FT_UInt num_color_stops = color_stop_iterator.num_color_stops;
+    stops->clear();
+    stops->resize(num_color_stops);
+
+    FT_ColorStop color_stop;
+    while (FT_Get_Colorline_Stops(face, &color_stop, &color_stop_iterator)) {
+        FT_UInt index = color_stop_iterator.current_color_stop - 1;
+        // TODO(drott): Ensure palette_index is sanitized on the FreeType
+        // side and 0xFFFF foreground color will be handled correctly here.
+        (*stops)[index] = {color_stop.stop_offset / float(1 << 14),
+                           color_stop.color.palette_index,
+                           SkColrV1AlphaToFloat(color_stop.color.alpha)};
+    }
 
-        std::stable_sort(
-                sorted_stops.begin(),
-                sorted_stops.end(),
-                [](const ColorStop& a, const ColorStop& b) { return a.stop_pos < b.stop_pos; });
+    // 5.7.11.2.4 ColorIndex, ColorStop and ColorLine
+    // "Applications shall apply the colorStops in increasing stopOffset order."
+    std::stable_sort(stops->begin(), stops->end(),
+                     [](const SkColrV1Glyph::ColorStop& a, const SkColrV1Glyph::ColorStop& b) {
+                         return a.fOffset < b.fOffset;
+                     });
+}
 
-        stops.resize(num_color_stops);
-        colors.resize(num_color_stops);
-        for (size_t i = 0; i < num_color_stops; ++i) {
-            stops[i] = sorted_stops[i].stop_pos;
-            colors[i] = sorted_stops[i].color;
-        }
+/* Converts a COLRv1 fill paint into its palette and size independent SkColrV1Glyph form. */
+void colrv1_make_fill(FT_Face face,
+                      FT_COLR_Paint colrv1_paint,
+                      SkColrV1Glyph::Fill* fill,
+                      ColorStops* stops) {
+    *fill = {};
+    fill->fType = SkColrV1Glyph::Fill::Type::kSolid;
+    fill->fTileMode = SkTileMode::kClamp;
+
+    auto make_solid = [fill, stops](const SkColrV1Glyph::ColorStop& stop) {
+        fill->fType = SkColrV1Glyph::Fill::Type::kSolid;
+        stops->assign(1, stop);
     };
+    make_solid(kBlackColorStop);
 
     switch (colrv1_paint.format) {
         case FT_COLR_PAINTFORMAT_SOLID: {
             FT_PaintSolid solid = colrv1_paint.u.solid;
-            SkColor color =
-                    SkColorSetARGB(palette[solid.color.palette_index].alpha *
-                                           SkColrV1AlphaToFloat(solid.color.alpha),
-                                   palette[solid.color.palette_index].red,
-                                   palette[solid.color.palette_index].green,
-                                   palette[solid.color.palette_index].blue);
-            paint->setShader(nullptr);
-            paint->setColor(color);
+            make_solid({0, solid.color.palette_index, SkColrV1AlphaToFloat(solid.color.alpha)});
             break;
         }
         case FT_COLR_PAINTFORMAT_LINEAR_GRADIENT: {
@@ -568,16 +566,16 @@ void colrv1_configure_skpaint(FT_Face face, const FT_Color* palette,
             perpendicular_to_p2_p0 = SkPoint::Make(perpendicular_to_p2_p0.y(), -perpendicular_to_p2_p0.x());
             line_positions[1] = p0 + SkVectorProjection((p1 - p0), perpendicular_to_p2_p0);
 
-            std::vector<SkScalar> stops;
-            std::vector<SkColor> colors;
-            fetch_color_stops(linear_gradient.colorline.color_stop_iterator, stops, colors);
+            ColorStops color_stops;
+            colrv1_fetch_color_stops(face, linear_gradient.colorline.color_stop_iterator,
+                                     &color_stops);
 
-            if (stops.empty()) {
+            if (color_stops.empty()) {
                 break;
             }
 
-            if (stops.size() == 1) {
-                paint->setColor(colors[0]);
+            if (color_stops.size() == 1) {
+                make_solid(color_stops[0]);
                 break;
             }
 
@@ -588,64 +586,58 @@ void colrv1_configure_skpaint(FT_Face face, const FT_Color* palette,
             // that range.
             SkVector p0p1 = p1 - p0;
             SkVector new_p0_offset = p0p1;
-            new_p0_offset.scale(stops.front());
+            new_p0_offset.scale(color_stops.front().fOffset);
             SkVector new_p1_offset = p0p1;
-            new_p1_offset.scale(stops.back());
+            new_p1_offset.scale(color_stops.back().fOffset);
 
             line_positions[0] = p0 + new_p0_offset;
             line_positions[1] = p0 + new_p1_offset;
 
-            SkScalar scale_factor = 1 / (stops.back() - stops.front());
-            SkScalar start_offset = stops.front();
-            for (SkScalar& stop : stops) {
-                stop = (stop - start_offset) * scale_factor;
+            SkScalar scale_factor = 1 / (color_stops.back().fOffset - color_stops.front().fOffset);
+            SkScalar start_offset = color_stops.front().fOffset;
+            for (SkColrV1Glyph::ColorStop& stop : color_stops) {
+                stop.fOffset = (stop.fOffset - start_offset) * scale_factor;
             }
 
-            sk_sp<SkShader> shader(SkGradientShader::MakeLinear(
-                    line_positions,
-                    colors.data(),
-                    stops.data(),
-                    stops.size(),
-                    ToSkTileMode(linear_gradient.colorline.extend)));
-            SkASSERT(shader);
-            // An opaque color is needed to ensure the gradient's not modulated by alpha.
-            paint->setColor(SK_ColorBLACK);
-            paint->setShader(shader);
-
+            fill->fType = SkColrV1Glyph::Fill::Type::kLinearGradient;
+            fill->fTileMode = ToSkTileMode(linear_gradient.colorline.extend);
+            fill->fPoints[0] = line_positions[0];
+            fill->fPoints[1] = line_positions[1];
+            *stops = std::move(color_stops);
             break;
         }
         case FT_COLR_PAINTFORMAT_RADIAL_GRADIENT: {
             FT_PaintRadialGradient& radial_gradient = colrv1_paint.u.radial_gradient;
-            SkPoint start = SkPoint::Make(radial_gradient.c0.x, -radial_gradient.c0.y);
-            SkScalar radius = radial_gradient.r0;
-            SkPoint end = SkPoint::Make(radial_gradient.c1.x, -radial_gradient.c1.y);
-            SkScalar end_radius = radial_gradient.r1;
 
+            ColorStops color_stops;
+            colrv1_fetch_color_stops(face, radial_gradient.colorline.color_stop_iterator,
+                                     &color_stops);
+            if (color_stops.size() < 2) {
+                make_solid(color_stops.empty() ? kBlackColorStop : color_stops[0]);
+                break;
+            }
 
-            std::vector<SkScalar> stops;
-            std::vector<SkColor> colors;
-            fetch_color_stops(radial_gradient.colorline.color_stop_iterator, stops, colors);
-
-            // An opaque color is needed to ensure the gradient's not modulated by alpha.
-            paint->setColor(SK_ColorBLACK);
-
-            paint->setShader(SkGradientShader::MakeTwoPointConical(
-                    start, radius, end, end_radius, colors.data(), stops.data(), stops.size(),
-                    ToSkTileMode(radial_gradient.colorline.extend)));
+            fill->fType = SkColrV1Glyph::Fill::Type::kRadialGradient;
+            fill->fTileMode = ToSkTileMode(radial_gradient.colorline.extend);
+            fill->fPoints[0] = SkPoint::Make(radial_gradient.c0.x, -radial_gradient.c0.y);
+            fill->fScalars[0] = radial_gradient.r0;
+            fill->fPoints[1] = SkPoint::Make(radial_gradient.c1.x, -radial_gradient.c1.y);
+            fill->fScalars[1] = radial_gradient.r1;
+            *stops = std::move(color_stops);
             break;
         }
         case FT_COLR_PAINTFORMAT_SWEEP_GRADIENT: {
             FT_PaintSweepGradient& sweep_gradient = colrv1_paint.u.sweep_gradient;
-            SkPoint center = SkPoint::Make(sweep_gradient.center.x, -sweep_gradient.center.y);
             SkScalar startAngle = SkFixedToScalar(sweep_gradient.start_angle * 180.0f);
             SkScalar endAngle = SkFixedToScalar(sweep_gradient.end_angle * 180.0f);
 
-            std::vector<SkScalar> stops;
-            std::vector<SkColor> colors;
-            fetch_color_stops(sweep_gradient.colorline.color_stop_iterator, stops, colors);
-
-            // An opaque color is needed to ensure the gradient's not modulated by alpha.
-            paint->setColor(SK_ColorBLACK);
+            ColorStops color_stops;
+            colrv1_fetch_color_stops(face, sweep_gradient.colorline.color_stop_iterator,
+                                     &color_stops);
+            if (color_stops.size() < 2) {
+                make_solid(color_stops.empty() ? kBlackColorStop : color_stops[0]);
+                break;
+            }
 
             // Prepare angles to be within range for the shader.
             auto clampAngleToRange= [](SkScalar angle) {
@@ -662,15 +654,12 @@ void colrv1_configure_skpaint(FT_Face face, const FT_Color* palette,
             if (startAngle >= endAngle)
               endAngle += 360.f;
 
-            // Skia's angles start from the horizontal x-Axis, rotate left 90
-            // degrees and then mirror horizontally to correct for Skia angles
-            // going clockwise, COLR v1 angles going counterclockwise.
-            SkMatrix angle_adjust = SkMatrix::RotateDeg(-90.f, center);
-            angle_adjust.postScale(-1, 1, center.x(), center.y());
-
-            paint->setShader(SkGradientShader::MakeSweep(
-                    center.x(), center.y(), colors.data(), stops.data(), stops.size(),
-                    SkTileMode::kDecal, startAngle, endAngle, 0, &angle_adjust));
+            fill->fType = SkColrV1Glyph::Fill::Type::kSweepGradient;
+            fill->fTileMode = SkTileMode::kDecal;
+            fill->fPoints[0] = SkPoint::Make(sweep_gradient.center.x, -sweep_gradient.center.y);
+            fill->fScalars[0] = startAngle;
+            fill->fScalars[1] = endAngle;
+            *stops = std::move(color_stops);
             break;
         }
         default: {
@@ -679,96 +668,36 @@ void colrv1_configure_skpaint(FT_Face face, const FT_Color* palette,
     }
 }
 
-
-void colrv1_draw_paint(SkCanvas* canvas,
-                       const FT_Color* palette,
-                       FT_Face face,
-                       FT_COLR_Paint colrv1_paint) {
-    SkPaint paint;
-
-    switch (colrv1_paint.format) {
-        case FT_COLR_PAINTFORMAT_GLYPH: {
-            FT_UInt glyphID = colrv1_paint.u.glyph.glyphID;
-            SkPath path;
-            /* TODO: Currently this call retrieves the path at units_per_em size. If we want to get
-             * correct hinting for the scaled size under the transforms at this point in the color
-             * glyph graph, we need to extract at least the requested glyph width and height and
-             * pass that to the path generation. */
-            if (generateFacePathCOLRv1(face, glyphID, &path)) {
-
-#ifdef SK_SHOW_TEXT_BLIT_COVERAGE
-              SkPaint highlight_paint;
-              highlight_paint.setColor(0x33FF0000);
-              canvas->drawRect(path.getBounds(), highlight_paint);
-#endif
-              canvas->clipPath(path, true /* doAntiAlias */);
-            }
-            break;
-        }
-        case FT_COLR_PAINTFORMAT_SOLID:
-        case FT_COLR_PAINTFORMAT_LINEAR_GRADIENT:
-        case FT_COLR_PAINTFORMAT_RADIAL_GRADIENT:
-        case FT_COLR_PAINTFORMAT_SWEEP_GRADIENT: {
-            SkPaint colrPaint;
-            colrv1_configure_skpaint(face, palette, colrv1_paint, &colrPaint);
-            canvas->drawPaint(colrPaint);
-            break;
-        }
-        case FT_COLR_PAINTFORMAT_TRANSFORM:
-        case FT_COLR_PAINTFORMAT_TRANSLATE:
-        case FT_COLR_PAINTFORMAT_SCALE:
-        case FT_COLR_PAINTFORMAT_ROTATE:
-        case FT_COLR_PAINTFORMAT_SKEW:
-            SkASSERT(false);  // Transforms handled in colrv1_transform.
-            break;
-        default:
-            paint.setShader(nullptr);
-            paint.setColor(SK_ColorCYAN);
-            break;
-    }
-}
-
-void colrv1_draw_glyph_with_path(SkCanvas* canvas, const FT_Color* palette, FT_Face face,
-                                 FT_COLR_Paint glyphPaint, FT_COLR_Paint fillPaint) {
+void colrv1_draw_glyph_with_path(SkColrV1Glyph::Builder* builder, FT_Face face,
+                                 SkColrV1GlyphCache* cache, FT_COLR_Paint glyphPaint,
+                                 FT_COLR_Paint fillPaint) {
     SkASSERT(glyphPaint.format == FT_COLR_PAINTFORMAT_GLYPH);
     SkASSERT(fillPaint.format == FT_COLR_PAINTFORMAT_SOLID ||
              fillPaint.format == FT_COLR_PAINTFORMAT_LINEAR_GRADIENT ||
              fillPaint.format == FT_COLR_PAINTFORMAT_RADIAL_GRADIENT ||
              fillPaint.format == FT_COLR_PAINTFORMAT_SWEEP_GRADIENT);
 
-    SkPaint skiaFillPaint;
-    skiaFillPaint.setAntiAlias(true);
-    colrv1_configure_skpaint(face, palette, fillPaint, &skiaFillPaint);
-
     FT_UInt glyphID = glyphPaint.u.glyph.glyphID;
     SkPath path;
     /* TODO: Currently this call retrieves the path at units_per_em size. If we want to get
      * correct hinting for the scaled size under the transforms at this point in the color
      * glyph graph, we need to extract at least the requested glyph width and height and
      * pass that to the path generation. */
-    if (generateFacePathCOLRv1(face, glyphID, &path)) {
-#ifdef SK_SHOW_TEXT_BLIT_COVERAGE
-        SkPaint highlight_paint;
-        highlight_paint.setColor(0x33FF0000);
-        canvas->drawRect(path.getBounds(), highlight_paint);
-#endif
-        {
-            canvas->drawPath(path, skiaFillPaint);
-        }
+    if (generateFacePathCOLRv1(face, cache, glyphID, &path)) {
+        SkColrV1Glyph::Fill fill;
+        ColorStops stops;
+        colrv1_make_fill(face, fillPaint, &fill, &stops);
+        builder->drawPath(path, fill, SkMakeSpan(stops));
     }
 }
 
-
-/* In drawing mode, concatenates the transforms directly on SkCanvas. In
- * bounding box calculation mode, no SkCanvas is specified, but we only want to
- * retrieve the transform from the FreeType paint object. */
+/* Retrieves the transform from a FreeType transform paint object. */
 void colrv1_transform(FT_Face face,
                       FT_COLR_Paint colrv1_paint,
-                      SkCanvas* canvas,
-                      SkMatrix* out_transform = 0) {
+                      SkMatrix* out_transform) {
     SkMatrix transform;
 
-    SkASSERT(canvas || out_transform);
+    SkASSERT(out_transform);
 
     switch (colrv1_paint.format) {
         case FT_COLR_PAINTFORMAT_TRANSFORM: {
@@ -820,25 +749,167 @@ void colrv1_transform(FT_Face face,
             SkASSERT(false);
         }
     }
-    if (canvas) {
-        canvas->concat(transform);
-    }
-    if (out_transform) {
-        *out_transform = transform;
-    }
+    *out_transform = transform;
 }
 
-bool colrv1_start_glyph(SkCanvas* canvas,
-                        const FT_Color* palette,
+bool colrv1_start_glyph(SkColrV1Glyph::Builder* builder,
                         FT_Face ft_face,
+                        SkColrV1GlyphCache* cache,
                         uint16_t glyph_id,
-                        FT_Color_Root_Transform root_transform);
+                        FT_Color_Root_Transform root_transform,
+                        bool elide_layers);
+
+bool colrv1_paint_bounds(FT_Face face, SkColrV1GlyphCache* cache, FT_OpaquePaint opaque_paint,
+                         SkRect* bounds);
+
+/* Returns true if compositing a transparent source with mode leaves the backdrop unchanged. */
+bool colrv1_mode_preserves_backdrop(SkBlendMode mode) {
+    switch (mode) {
+        case SkBlendMode::kClear:
+        case SkBlendMode::kSrc:
+        case SkBlendMode::kSrcIn:
+        case SkBlendMode::kDstIn:
+        case SkBlendMode::kSrcOut:
+        case SkBlendMode::kDstATop:
+        case SkBlendMode::kModulate:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/* Returns true if compositing a source with mode onto a transparent backdrop yields the source. */
+bool colrv1_mode_preserves_source(SkBlendMode mode) {
+    switch (mode) {
+        case SkBlendMode::kClear:
+        case SkBlendMode::kDst:
+        case SkBlendMode::kSrcIn:
+        case SkBlendMode::kDstIn:
+        case SkBlendMode::kDstOut:
+        case SkBlendMode::kSrcATop:
+        case SkBlendMode::kModulate:
+            return false;
+        default:
+            return true;
+    }
+}
 
-bool colrv1_traverse_paint(SkCanvas* canvas,
-                           const FT_Color* palette,
+bool colrv1_traverse_paint(SkColrV1Glyph::Builder* builder,
                            FT_Face face,
+                           SkColrV1GlyphCache* cache,
                            FT_OpaquePaint opaque_paint,
-                           VisitedSet* visited_set) {
+                           VisitedSet* visited_set,
+                           bool elide_layers);
+
+/* Records a PaintComposite as a layer for the backdrop, holding a layer for the source which is
+ * composited with the composite mode. The layers are bounded by the given bounds, if any. */
+bool colrv1_composite_in_layers(SkColrV1Glyph::Builder* builder,
+                                FT_Face face,
+                                SkColrV1GlyphCache* cache,
+                                const FT_PaintComposite& composite,
+                                const SkRect* layerBounds,
+                                const SkRect* sourceLayerBounds,
+                                VisitedSet* visited_set,
+                                bool elide_layers) {
+    builder->saveLayer(SkBlendMode::kSrcOver, layerBounds);
+    bool traverse_result = colrv1_traverse_paint(builder, face, cache, composite.backdrop_paint,
+                                                 visited_set, elide_layers);
+    builder->saveLayer(ToSkBlendMode(composite.composite_mode), sourceLayerBounds);
+    traverse_result = traverse_result &&
+                      colrv1_traverse_paint(builder, face, cache, composite.source_paint,
+                                            visited_set, elide_layers);
+    builder->restore();
+    builder->restore();
+    return traverse_result;
+}
+
+/* Records a PaintComposite. Two nested layers are only used when the composite mode needs them;
+ * otherwise the backdrop and source are drawn straight into the current layer. Layers are bounded
+ * by the outlines the backdrop and source are drawn with, when those are known. */
+bool colrv1_composite(SkColrV1Glyph::Builder* builder,
+                      FT_Face face,
+                      SkColrV1GlyphCache* cache,
+                      const FT_PaintComposite& composite,
+                      VisitedSet* visited_set,
+                      bool elide_layers) {
+    const SkBlendMode mode = ToSkBlendMode(composite.composite_mode);
+    const FT_OpaquePaint& backdrop = composite.backdrop_paint;
+    const FT_OpaquePaint& source = composite.source_paint;
+    auto traverse = [&](const FT_OpaquePaint& paint) {
+        return colrv1_traverse_paint(builder, face, cache, paint, visited_set, elide_layers);
+    };
+
+    if (!elide_layers) {
+        return colrv1_composite_in_layers(builder, face, cache, composite, nullptr, nullptr,
+                                          visited_set, elide_layers);
+    }
+
+    switch (mode) {
+        case SkBlendMode::kClear:
+            return true;
+        case SkBlendMode::kSrc:
+            return traverse(source);
+        case SkBlendMode::kDst:
+            return traverse(backdrop);
+        case SkBlendMode::kSrcOver:
+            // src-over is associative, so the layers make no difference.
+            return traverse(backdrop) && traverse(source);
+        case SkBlendMode::kDstOver:
+            return traverse(source) && traverse(backdrop);
+        default:
+            break;
+    }
+
+    SkRect backdropBounds, sourceBounds;
+    const bool backdropBounded = colrv1_paint_bounds(face, cache, backdrop, &backdropBounds);
+    const bool sourceBounded = colrv1_paint_bounds(face, cache, source, &sourceBounds);
+
+    // Where only one of them draws the mode yields that one, so if they do not overlap they can
+    // be drawn with src-over.
+    if (backdropBounded && sourceBounded &&
+        !SkRect::Intersects(backdropBounds, sourceBounds) &&
+        colrv1_mode_preserves_backdrop(mode) && colrv1_mode_preserves_source(mode))
+    {
+        return traverse(backdrop) && traverse(source);
+    }
+
+    SkRect unionBounds = backdropBounds;
+    unionBounds.join(sourceBounds);
+    const SkRect* layerBounds = backdropBounded && sourceBounded ? &unionBounds : nullptr;
+    // Outside of the source's bounds the source layer is transparent, which only leaves the
+    // backdrop as is for some modes.
+    const SkRect* sourceLayerBounds = sourceBounded && colrv1_mode_preserves_backdrop(mode)
+                                    ? &sourceBounds : layerBounds;
+    return colrv1_composite_in_layers(builder, face, cache, composite, layerBounds,
+                                      sourceLayerBounds, visited_set, elide_layers);
+}
+
+/* Returns the paint a transform paint object applies its transform to. */
+FT_OpaquePaint colrv1_transform_child(const FT_COLR_Paint& colrv1_paint) {
+    switch (colrv1_paint.format) {
+        case FT_COLR_PAINTFORMAT_TRANSFORM:
+            return colrv1_paint.u.transform.paint;
+        case FT_COLR_PAINTFORMAT_TRANSLATE:
+            return colrv1_paint.u.translate.paint;
+        case FT_COLR_PAINTFORMAT_SCALE:
+            return colrv1_paint.u.scale.paint;
+        case FT_COLR_PAINTFORMAT_ROTATE:
+            return colrv1_paint.u.rotate.paint;
+        case FT_COLR_PAINTFORMAT_SKEW:
+            return colrv1_paint.u.skew.paint;
+        default:
+            // Only transforms are handled in this function.
+            SkASSERT(false);
+            return {nullptr, 0};
+    }
+}
+
+bool colrv1_traverse_paint(SkColrV1Glyph::Builder* builder,
+                           FT_Face face,
+                           SkColrV1GlyphCache* cache,
+                           FT_OpaquePaint opaque_paint,
+                           VisitedSet* visited_set,
+                           bool elide_layers) {
     // Cycle detection, see section "5.7.11.1.9 Color glyphs as a directed acyclic graph".
     if (visited_set->contains(opaque_paint)) {
         return false;
@@ -855,18 +926,18 @@ bool colrv1_traverse_paint(SkCanvas* canvas,
     // Keep track of failures to retrieve the FT_COLR_Paint from FreeType in the
     // recursion, cancel recursion when a paint retrieval fails.
     bool traverse_result = true;
-    SkAutoCanvasRestore autoRestore(canvas, true /* do_save */);
     switch (paint.format) {
         case FT_COLR_PAINTFORMAT_COLR_LAYERS: {
             FT_LayerIterator& layer_iterator = paint.u.colr_layers.layer_iterator;
             FT_OpaquePaint opaque_paint_fetch;
             opaque_paint_fetch.p = nullptr;
             while (FT_Get_Paint_Layers(face, &layer_iterator, &opaque_paint_fetch)) {
-                colrv1_traverse_paint(canvas, palette, face, opaque_paint_fetch, visited_set);
+                colrv1_traverse_paint(builder, face, cache, opaque_paint_fetch, visited_set,
+                                      elide_layers);
             }
             break;
         }
-        case FT_COLR_PAINTFORMAT_GLYPH:
+        case FT_COLR_PAINTFORMAT_GLYPH: {
             // Special case paint graph leaf situations to improve
             // performance. These are situations in the graph where a GlyphPaint
             // is followed by either a solid or a gradient fill. Here we can use
@@ -880,64 +951,59 @@ bool colrv1_traverse_paint(SkCanvas* canvas,
                 fillPaint.format == FT_COLR_PAINTFORMAT_LINEAR_GRADIENT ||
                 fillPaint.format == FT_COLR_PAINTFORMAT_RADIAL_GRADIENT ||
                 fillPaint.format == FT_COLR_PAINTFORMAT_SWEEP_GRADIENT) {
-                colrv1_draw_glyph_with_path(canvas, palette, face, paint, fillPaint);
+                colrv1_draw_glyph_with_path(builder, face, cache, paint, fillPaint);
             } else {
-                colrv1_draw_paint(canvas, palette, face, paint);
-                traverse_result = colrv1_traverse_paint(canvas, palette, face,
-                                                        paint.u.glyph.paint, visited_set);
+                builder->save();
+                FT_UInt glyphID = paint.u.glyph.glyphID;
+                SkPath path;
+                /* TODO: Currently this call retrieves the path at units_per_em size. If we want to
+                 * get correct hinting for the scaled size under the transforms at this point in
+                 * the color glyph graph, we need to extract at least the requested glyph width
+                 * and height and pass that to the path generation. */
+                if (generateFacePathCOLRv1(face, cache, glyphID, &path)) {
+                    builder->clipPath(path);
+                }
+                traverse_result = colrv1_traverse_paint(builder, face, cache,
+                                                        paint.u.glyph.paint, visited_set,
+                                                        elide_layers);
+                builder->restore();
             }
             break;
+        }
         case FT_COLR_PAINTFORMAT_COLR_GLYPH:
-            traverse_result = colrv1_start_glyph(canvas, palette, face, paint.u.colr_glyph.glyphID,
-                                                 FT_COLOR_NO_ROOT_TRANSFORM);
+            builder->save();
+            traverse_result = colrv1_start_glyph(builder, face, cache,
+                                                 paint.u.colr_glyph.glyphID,
+                                                 FT_COLOR_NO_ROOT_TRANSFORM, elide_layers);
+            builder->restore();
             break;
         case FT_COLR_PAINTFORMAT_TRANSFORM:
-            colrv1_transform(face, paint, canvas);
-            traverse_result = colrv1_traverse_paint(canvas, palette, face,
-                                                    paint.u.transform.paint, visited_set);
-            break;
         case FT_COLR_PAINTFORMAT_TRANSLATE:
-            colrv1_transform(face, paint, canvas);
-            traverse_result = colrv1_traverse_paint(canvas, palette, face,
-                                                    paint.u.translate.paint, visited_set);
-            break;
         case FT_COLR_PAINTFORMAT_SCALE:
-            colrv1_transform(face, paint, canvas);
-            traverse_result = colrv1_traverse_paint(canvas, palette, face,
-                                                    paint.u.scale.paint, visited_set);
-            break;
         case FT_COLR_PAINTFORMAT_ROTATE:
-            colrv1_transform(face, paint, canvas);
-            traverse_result =
-                    colrv1_traverse_paint(canvas, palette, face,
-                                          paint.u.rotate.paint, visited_set);
-            break;
-        case FT_COLR_PAINTFORMAT_SKEW:
-            colrv1_transform(face, paint, canvas);
-            traverse_result =
-                    colrv1_traverse_paint(canvas, palette, face,
-                                          paint.u.skew.paint, visited_set);
-            break;
-        case FT_COLR_PAINTFORMAT_COMPOSITE: {
-            canvas->saveLayer(nullptr, nullptr);
-            traverse_result = colrv1_traverse_paint(
-                    canvas, palette, face, paint.u.composite.backdrop_paint, visited_set);
-            SkPaint blend_mode_paint;
-            blend_mode_paint.setBlendMode(ToSkBlendMode(paint.u.composite.composite_mode));
-            canvas->saveLayer(nullptr, &blend_mode_paint);
-            traverse_result =
-                    traverse_result &&
-                    colrv1_traverse_paint(
-                            canvas, palette, face, paint.u.composite.source_paint, visited_set);
-            canvas->restore();
-            canvas->restore();
+        case FT_COLR_PAINTFORMAT_SKEW: {
+            SkMatrix transform;
+            colrv1_transform(face, paint, &transform);
+            builder->save();
+            builder->concat(transform);
+            traverse_result = colrv1_traverse_paint(builder, face, cache,
+                                                    colrv1_transform_child(paint), visited_set,
+                                                    elide_layers);
+            builder->restore();
             break;
         }
+        case FT_COLR_PAINTFORMAT_COMPOSITE:
+            traverse_result = colrv1_composite(builder, face, cache, paint.u.composite,
+                                               visited_set, elide_layers);
+            break;
         case FT_COLR_PAINTFORMAT_SOLID:
         case FT_COLR_PAINTFORMAT_LINEAR_GRADIENT:
         case FT_COLR_PAINTFORMAT_RADIAL_GRADIENT:
         case FT_COLR_PAINTFORMAT_SWEEP_GRADIENT: {
-            colrv1_draw_paint(canvas, palette, face, paint);
+            SkColrV1Glyph::Fill fill;
+            ColorStops stops;
+            colrv1_make_fill(face, paint, &fill, &stops);
+            builder->drawPaint(fill, SkMakeSpan(stops));
             break;
         }
         default:
@@ -946,9 +1012,13 @@ bool colrv1_traverse_paint(SkCanvas* canvas,
     }
     return traverse_result;
 }
-
-SkPath GetClipBoxPath(FT_Face ft_face, uint16_t glyph_id, bool untransformed) {
+SkPath GetClipBoxPath(FT_Face ft_face, SkColrV1GlyphCache* cache, uint16_t glyph_id,
+                      bool untransformed) {
     SkPath resultPath;
+    // Clip boxes in font units do not depend on the strike, so only those are cached.
+    if (untransformed && cache->findClipBox(glyph_id, &resultPath)) {
+        return resultPath;
+    }
 
     using DoneFTSize = SkFunctionWrapper<decltype(FT_Done_Size), FT_Done_Size>;
     std::unique_ptr<std::remove_pointer_t<FT_Size>, DoneFTSize> unscaledFtSize = nullptr;
@@ -1008,45 +1078,135 @@ SkPath GetClipBoxPath(FT_Face ft_face, uint16_t glyph_id, bool untransformed) {
           return resultPath;
         }
         FT_Set_Transform(ft_face, &oldTransform, &oldDelta);
+        cache->addClipBox(glyph_id, resultPath);
     }
 
     return resultPath;
 }
 
-bool colrv1_start_glyph(SkCanvas* canvas,
-                        const FT_Color* palette,
+bool colrv1_start_glyph(SkColrV1Glyph::Builder* builder,
                         FT_Face ft_face,
+                        SkColrV1GlyphCache* cache,
                         uint16_t glyph_id,
-                        FT_Color_Root_Transform root_transform) {
+                        FT_Color_Root_Transform root_transform,
+                        bool elide_layers) {
     FT_OpaquePaint opaque_paint;
     opaque_paint.p = nullptr;
     bool has_colrv1_layers = false;
     if (FT_Get_Color_Glyph_Paint(ft_face, glyph_id, root_transform, &opaque_paint)) {
         has_colrv1_layers = true;
 
-        SkPath clipBoxPath =
-                GetClipBoxPath(ft_face, glyph_id, root_transform == FT_COLOR_NO_ROOT_TRANSFORM);
+        SkPath clipBoxPath = GetClipBoxPath(ft_face, cache, glyph_id,
+                                            root_transform == FT_COLOR_NO_ROOT_TRANSFORM);
         if (!clipBoxPath.isEmpty()) {
-            canvas->clipPath(clipBoxPath, true);
+            builder->clipPath(clipBoxPath);
         }
 
         VisitedSet visited_set;
-        colrv1_traverse_paint(canvas, palette, ft_face, opaque_paint, &visited_set);
+        colrv1_traverse_paint(builder, ft_face, cache, opaque_paint, &visited_set, elide_layers);
     }
     return has_colrv1_layers;
 }
 
+/* Returns the decoded paint graph of glyph_id, decoding it from the COLR table on first use.
+ * Returns nullptr if glyph_id is not a COLRv1 glyph. */
+sk_sp<SkColrV1Glyph> colrv1_find_or_build_glyph(SkColrV1GlyphCache* cache,
+                                                FT_Face ft_face,
+                                                uint16_t glyph_id) {
+    sk_sp<SkColrV1Glyph> glyph;
+    if (cache->find(glyph_id, &glyph)) {
+        return glyph;
+    }
+
+    // Build without the root transform, so that the result is shared by all sizes and
+    // transforms; see colrv1_root_transform().
+    glyph = SkScalerContext_FreeType_Base::BuildColrV1Glyph(ft_face, cache, glyph_id, true);
+    return cache->add(glyph_id, std::move(glyph));
+}
+
+/* The transform FreeType would insert for FT_COLOR_INCLUDE_ROOT_TRANSFORM: font units to the
+ * active size, followed by the transform set with FT_Set_Transform. */
+SkMatrix colrv1_root_transform(FT_Face ft_face) {
+    FT_Matrix ft_matrix;
+    FT_Vector ft_delta;
+    FT_Get_Transform(ft_face, &ft_matrix, &ft_delta);
+
+    // x_scale and y_scale are 16.16 factors from font units to 26.6 pixels, match FreeType's
+    // rounding when converting them into 16.16 factors from font units to pixels.
+    const FT_Size_Metrics& metrics = ft_face->size->metrics;
+    SkMatrix root_transform = ToSkMatrix({ft_matrix.xx, ft_matrix.xy, 0,
+                                          ft_matrix.yx, ft_matrix.yy, 0});
+    root_transform.preScale(SkFixedToScalar((metrics.x_scale + 32) >> 6),
+                            SkFixedToScalar((metrics.y_scale + 32) >> 6));
+    root_transform.postTranslate(SkFDot6ToScalar(ft_delta.x), -SkFDot6ToScalar(ft_delta.y));
+    return root_transform;
+}
+
+/* The number of colors in each of the CPAL palettes of ft_face. */
+FT_UShort colrv1_palette_size(FT_Face ft_face) {
+    FT_Palette_Data palette_data;
+    if (FT_Palette_Data_Get(ft_face, &palette_data)) {
+        return 0;
+    }
+    return palette_data.num_palette_entries;
+}
+
+void colrv1_copy_palette(const FT_Color* palette, FT_UShort count, SkColor* dst) {
+    for (FT_UShort i = 0; i < count; ++i) {
+        dst[i] = SkColorSetARGB(palette[i].alpha, palette[i].red,
+                                palette[i].green, palette[i].blue);
+    }
+}
+
+/* Draws a COLRv1 glyph in strike space at any scale. The paint graph is shared with the
+ * typeface's SkColrV1GlyphCache, so only the palette and the transform are held here. */
+class ColrV1Drawable final : public SkDrawable {
+public:
+    ColrV1Drawable(sk_sp<SkColrV1Glyph> glyph, std::vector<SkColor> palette,
+                   const SkMatrix& matrix, const SkRect& bounds)
+        : fGlyph(std::move(glyph))
+        , fPalette(std::move(palette))
+        , fMatrix(matrix)
+        , fBounds(bounds) {}
+
+    size_t approximateBytesUsed() override {
+        return sizeof(*this) + fPalette.size() * sizeof(SkColor);
+    }
+
+protected:
+    SkRect onGetBounds() override { return fBounds; }
+
+    void onDraw(SkCanvas* canvas) override {
+        canvas->clipRect(fBounds, true);
+        canvas->concat(fMatrix);
+        fGlyph->draw(canvas, SkMakeSpan(fPalette));
+    }
+
+private:
+    const sk_sp<SkColrV1Glyph> fGlyph;
+    const std::vector<SkColor> fPalette;
+    // Font units to strike space.
+    const SkMatrix             fMatrix;
+    const SkRect               fBounds;
+};
+
 bool colrv1_start_glyph_bounds(SkMatrix *ctm,
                                SkRect* bounds,
                                FT_Face ft_face,
+                               SkColrV1GlyphCache* cache,
                                uint16_t glyph_id,
-                               FT_Color_Root_Transform root_transform);
+                               FT_Color_Root_Transform root_transform,
+                               bool* unbounded);
 
+/* Joins the bounds of the outlines drawn by opaque_paint, under ctm, into bounds. If unbounded is
+ * not nullptr it is set when the paint also fills without an outline, i.e. fills its whole clip. */
 bool colrv1_traverse_paint_bounds(SkMatrix* ctm,
                                   SkRect* bounds,
                                   FT_Face face,
+                                  SkColrV1GlyphCache* cache,
                                   FT_OpaquePaint opaque_paint,
-                                  VisitedSet* visited_set) {
+                                  VisitedSet* visited_set,
+                                  bool* unbounded) {
     // Cycle detection, see section "5.7.11.1.9 Color glyphs as a directed acyclic graph".
     if (visited_set->contains(opaque_paint)) {
         return false;
@@ -1072,14 +1232,15 @@ bool colrv1_traverse_paint_bounds(SkMatrix* ctm,
             FT_OpaquePaint opaque_paint_fetch;
             opaque_paint_fetch.p = nullptr;
             while (FT_Get_Paint_Layers(face, &layer_iterator, &opaque_paint_fetch)) {
-                colrv1_traverse_paint_bounds(ctm, bounds, face, opaque_paint_fetch, visited_set);
+                colrv1_traverse_paint_bounds(ctm, bounds, face, cache, opaque_paint_fetch,
+                                             visited_set, unbounded);
             }
             break;
         }
         case FT_COLR_PAINTFORMAT_GLYPH: {
             FT_UInt glyphID = paint.u.glyph.glyphID;
             SkPath path;
-            if ((traverse_result = generateFacePathCOLRv1(face, glyphID, &path))) {
+            if ((traverse_result = generateFacePathCOLRv1(face, cache, glyphID, &path))) {
               path.transform(*ctm);
               bounds->join(path.getBounds());
             }
@@ -1087,60 +1248,66 @@ bool colrv1_traverse_paint_bounds(SkMatrix* ctm,
         }
         case FT_COLR_PAINTFORMAT_COLR_GLYPH:
             traverse_result = colrv1_start_glyph_bounds(
-                    ctm, bounds, face, paint.u.colr_glyph.glyphID, FT_COLOR_NO_ROOT_TRANSFORM);
+                    ctm, bounds, face, cache, paint.u.colr_glyph.glyphID,
+                    FT_COLOR_NO_ROOT_TRANSFORM, unbounded);
             break;
 
         case FT_COLR_PAINTFORMAT_TRANSFORM: {
             SkMatrix transform_matrix;
-            colrv1_transform(face, paint, nullptr, &transform_matrix);
+            colrv1_transform(face, paint, &transform_matrix);
             ctm->preConcat(transform_matrix);
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.transform.paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.transform.paint, visited_set, unbounded);
             break;
         }
         case FT_COLR_PAINTFORMAT_TRANSLATE: {
             SkMatrix transform_matrix;
-            colrv1_transform(face, paint, nullptr, &transform_matrix);
+            colrv1_transform(face, paint, &transform_matrix);
             ctm->preConcat(transform_matrix);
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.translate.paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.translate.paint, visited_set, unbounded);
             break;
         }
         case FT_COLR_PAINTFORMAT_SCALE: {
             SkMatrix transform_matrix;
-            colrv1_transform(face, paint, nullptr, &transform_matrix);
+            colrv1_transform(face, paint, &transform_matrix);
             ctm->preConcat(transform_matrix);
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.scale.paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.scale.paint, visited_set, unbounded);
             break;
         }
         case FT_COLR_PAINTFORMAT_ROTATE: {
             SkMatrix transform_matrix;
-            colrv1_transform(face, paint, nullptr, &transform_matrix);
+            colrv1_transform(face, paint, &transform_matrix);
             ctm->preConcat(transform_matrix);
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.rotate.paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.rotate.paint, visited_set, unbounded);
             break;
         }
         case FT_COLR_PAINTFORMAT_SKEW: {
             SkMatrix transform_matrix;
-            colrv1_transform(face, paint, nullptr, &transform_matrix);
+            colrv1_transform(face, paint, &transform_matrix);
             ctm->preConcat(transform_matrix);
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.skew.paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.skew.paint, visited_set, unbounded);
             break;
         }
         case FT_COLR_PAINTFORMAT_COMPOSITE: {
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.composite.backdrop_paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.composite.backdrop_paint, visited_set,
+                    unbounded);
             traverse_result = colrv1_traverse_paint_bounds(
-                    ctm, bounds, face, paint.u.composite.source_paint, visited_set);
+                    ctm, bounds, face, cache, paint.u.composite.source_paint, visited_set,
+                    unbounded);
             break;
         }
         case FT_COLR_PAINTFORMAT_SOLID:
         case FT_COLR_PAINTFORMAT_LINEAR_GRADIENT:
         case FT_COLR_PAINTFORMAT_RADIAL_GRADIENT:
         case FT_COLR_PAINTFORMAT_SWEEP_GRADIENT: {
+            if (unbounded) {
+                *unbounded = true;
+            }
             break;
         }
         default:
@@ -1154,22 +1321,93 @@ bool colrv1_traverse_paint_bounds(SkMatrix* ctm,
 bool colrv1_start_glyph_bounds(SkMatrix *ctm,
                                SkRect* bounds,
                                FT_Face ft_face,
+                               SkColrV1GlyphCache* cache,
                                uint16_t glyph_id,
-                               FT_Color_Root_Transform root_transform) {
+                               FT_Color_Root_Transform root_transform,
+                               bool* unbounded) {
     FT_OpaquePaint opaque_paint;
     opaque_paint.p = nullptr;
     bool has_colrv1_layers = false;
     if (FT_Get_Color_Glyph_Paint(ft_face, glyph_id, root_transform, &opaque_paint)) {
         has_colrv1_layers = true;
         VisitedSet visited_set;
-        colrv1_traverse_paint_bounds(ctm, bounds, ft_face, opaque_paint, &visited_set);
+        colrv1_traverse_paint_bounds(ctm, bounds, ft_face, cache, opaque_paint, &visited_set,
+                                     unbounded);
     }
     return has_colrv1_layers;
 }
+
+/* Computes the bounds of what opaque_paint draws in its own coordinate space. Returns false if
+ * they are unknown, or if the paint fills its whole clip. */
+bool colrv1_paint_bounds(FT_Face face, SkColrV1GlyphCache* cache, FT_OpaquePaint opaque_paint,
+                         SkRect* bounds) {
+    SkMatrix ctm;
+    *bounds = SkRect::MakeEmpty();
+    bool unbounded = false;
+    VisitedSet visited_set;
+    if (!colrv1_traverse_paint_bounds(&ctm, bounds, face, cache, opaque_paint, &visited_set,
+                                      &unbounded)) {
+        return false;
+    }
+    bounds->sort();
+    return !unbounded;
+}
+
+/* Computes the bounds of what the paint graph of glyph_id draws in font units, once per glyph.
+ * *face_changed is set if other glyphs had to be loaded into face to compute them. */
+bool colrv1_paint_graph_font_bounds(FT_Face face, SkColrV1GlyphCache* cache, SkGlyphID glyph_id,
+                                    SkRect* bounds, bool* face_changed) {
+    *face_changed = false;
+    if (cache->findBounds(glyph_id, bounds)) {
+        return true;
+    }
+    *face_changed = true;
+    SkMatrix ctm;
+    *bounds = SkRect::MakeEmpty();
+    if (!colrv1_start_glyph_bounds(&ctm, bounds, face, cache, glyph_id,
+                                   FT_COLOR_NO_ROOT_TRANSFORM, nullptr)) {
+        return false;
+    }
+    bounds->sort();
+    cache->addBounds(glyph_id, *bounds);
+    return true;
+}
 #endif // TT_SUPPORT_COLRV1
 
 }  // namespace
 
+sk_sp<SkDrawable> SkScalerContext_FreeType_Base::generateGlyphDrawable(FT_Face face,
+                                                                      const SkGlyph& glyph) {
+#ifdef TT_SUPPORT_COLRV1
+    if (SkMask::kARGB32_Format != glyph.fMaskFormat) {
+        return nullptr;
+    }
+    SkTypeface_FreeType* typeface = static_cast<SkTypeface_FreeType*>(this->getTypeface());
+    sk_sp<SkColrV1Glyph> colrGlyph = colrv1_find_or_build_glyph(
+            typeface->colrV1GlyphCache(), face, glyph.getGlyphID());
+    if (!colrGlyph) {
+        return nullptr;
+    }
+
+    FT_Color* palette = this->selectPalette(face);
+    if (!palette) {
+        return nullptr;
+    }
+    std::vector<SkColor> skPalette(colrv1_palette_size(face));
+    colrv1_copy_palette(palette, skPalette.size(), skPalette.data());
+
+    SkMatrix matrix = colrv1_root_transform(face);
+    if (this->isSubpixel()) {
+        matrix.postTranslate(SkFixedToScalar(glyph.getSubXFixed()),
+                             SkFixedToScalar(glyph.getSubYFixed()));
+    }
+    return sk_make_sp<ColrV1Drawable>(std::move(colrGlyph), std::move(skPalette), matrix,
+                                      glyph.rect());
+#else
+    return nullptr;
+#endif
+}
+
 void SkScalerContext_FreeType_Base::generateGlyphImage(
     FT_Face face,
     const SkGlyph& glyph,
@@ -1219,54 +1457,73 @@ void SkScalerContext_FreeType_Base::generateGlyphImage(
                 SkPaint paint;
                 paint.setAntiAlias(true);
 
-                FT_Color *palette;
-                FT_Error err = FT_Palette_Select(face, 0, &palette);
-                if (err) {
-                    SK_TRACEFTR(err, "Could not get palette from %s fontFace.", face->family_name);
+                FT_Color* palette = this->selectPalette(face);
+                if (!palette) {
                     return;
                 }
 
-                FT_Bool haveLayers = false;
-
 #ifdef TT_SUPPORT_COLRV1
                 // Only attempt to draw COLRv1 glyph is FreeType is new enough
                 // to have the COLRv1 additions, as indicated by the
                 // TT_SUPPORT_COLRV1 flag defined by the FreeType headers in
                 // that case.
 
-                haveLayers = colrv1_start_glyph(&canvas, palette, face, glyph.getGlyphID(),
-                                                FT_COLOR_INCLUDE_ROOT_TRANSFORM);
-#else
-                haveLayers = false;
+                SkTypeface_FreeType* typeface =
+                        static_cast<SkTypeface_FreeType*>(this->getTypeface());
+                SkColrV1GlyphCache* colrCache = typeface->colrV1GlyphCache();
+                sk_sp<SkColrV1Glyph> colrGlyph = colrv1_find_or_build_glyph(
+                        colrCache, face, glyph.getGlyphID());
+                if (colrGlyph) {
+                    FT_UShort num_palette_entries = colrv1_palette_size(face);
+                    SkAutoSTMalloc<256, SkColor> skPalette(num_palette_entries);
+                    colrv1_copy_palette(palette, num_palette_entries, skPalette.get());
+                    SkSpan<const SkColor> paletteSpan = SkMakeSpan(skPalette.get(),
+                                                                   num_palette_entries);
+
+                    SkAutoCanvasRestore acr(&canvas, true);
+                    canvas.concat(colrv1_root_transform(face));
+
+                    // Glyphs which can be recolored are always drawn from their cached coverage,
+                    // so their images do not depend on which clones exist, and clones with other
+                    // palettes, which share the cache, only recolor it.
+                    sk_sp<SkColrV1Glyph::Coverage> coverage = colrCache->findOrMakeCoverage(
+                            glyph.getGlyphID(), *colrGlyph, dstBitmap.dimensions(),
+                            canvas.getTotalMatrix());
+                    if (coverage) {
+                        coverage->recolor(dstBitmap.pixmap(), paletteSpan);
+                    } else {
+                        colrGlyph->draw(&canvas, paletteSpan);
+                    }
+                    return;
+                }
 #endif
-                if (!haveLayers) {
-                    // If we didn't have colr v1 layers, try v0 layers.
-                    FT_LayerIterator layerIterator;
-                    layerIterator.p = NULL;
-                    FT_UInt layerGlyphIndex = 0;
-                    FT_UInt layerColorIndex = 0;
-                    while (FT_Get_Color_Glyph_Layer(face, glyph.getGlyphID(), &layerGlyphIndex,
-                                                    &layerColorIndex, &layerIterator)) {
-                        haveLayers = true;
-                        if (layerColorIndex == 0xFFFF) {
-                            paint.setColor(SK_ColorBLACK);
-                        } else {
-                            SkColor color = SkColorSetARGB(palette[layerColorIndex].alpha,
-                                                           palette[layerColorIndex].red,
-                                                           palette[layerColorIndex].green,
-                                                           palette[layerColorIndex].blue);
-                            paint.setColor(color);
-                        }
-                        SkPath path;
-                        if (this->generateFacePath(face, layerGlyphIndex, &path)) {
-                            canvas.drawPath(path, paint);
-                        }
+                // If we didn't have colr v1 layers, try v0 layers.
+                bool haveLayers = false;
+                FT_LayerIterator layerIterator;
+                layerIterator.p = NULL;
+                FT_UInt layerGlyphIndex = 0;
+                FT_UInt layerColorIndex = 0;
+                while (FT_Get_Color_Glyph_Layer(face, glyph.getGlyphID(), &layerGlyphIndex,
+                                                &layerColorIndex, &layerIterator)) {
+                    haveLayers = true;
+                    if (layerColorIndex == 0xFFFF) {
+                        paint.setColor(SK_ColorBLACK);
+                    } else {
+                        SkColor color = SkColorSetARGB(palette[layerColorIndex].alpha,
+                                                       palette[layerColorIndex].red,
+                                                       palette[layerColorIndex].green,
+                                                       palette[layerColorIndex].blue);
+                        paint.setColor(color);
+                    }
+                    SkPath path;
+                    if (this->generateFacePath(face, layerGlyphIndex, &path)) {
+                        canvas.drawPath(path, paint);
                     }
                 }
 
                 if (!haveLayers) {
-                    SK_TRACEFTR(err, "Could not get layers (neither v0, nor v1) from %s fontFace.",
-                                face->family_name);
+                    SkDEBUGF("Could not get layers (neither v0, nor v1) from %s fontFace.\n",
+                             face->family_name);
                     return;
                 }
             } else
@@ -1599,7 +1856,12 @@ bool generateFacePathStatic(FT_Face face, SkGlyphID glyphID, SkPath* path) {
 }
 
 #ifdef TT_SUPPORT_COLRV1
-bool generateFacePathCOLRv1(FT_Face face, SkGlyphID glyphID, SkPath* path) {
+bool generateFacePathCOLRv1(FT_Face face, SkColrV1GlyphCache* cache, SkGlyphID glyphID,
+                            SkPath* path) {
+    if (cache->findOutline(glyphID, path)) {
+        return true;
+    }
+
     uint32_t flags = 0;
     flags |= FT_LOAD_NO_BITMAP; // ignore embedded bitmaps so we're sure to get the outline
     flags &= ~FT_LOAD_RENDER;   // don't scan convert (we just want the outline)
@@ -1656,6 +1918,9 @@ bool generateFacePathCOLRv1(FT_Face face, SkGlyphID glyphID, SkPath* path) {
 
     FT_Activate_Size(oldSize);
 
+    if (path_generation_result) {
+        cache->addOutline(glyphID, *path);
+    }
     return path_generation_result;
 }
 #endif
@@ -1674,14 +1939,19 @@ bool SkScalerContext_FreeType_Base::generateFacePath(FT_Face face,
 
 bool SkScalerContext_FreeType_Base::computeColrV1GlyphBoundingBox(FT_Face face,
                                                                   SkGlyphID glyphID,
-                                                                  FT_BBox* boundingBox) {
+                                                                  FT_BBox* boundingBox,
+                                                                  bool* faceChanged) {
 #ifdef TT_SUPPORT_COLRV1
-    SkMatrix ctm;
-    SkRect bounds = SkRect::MakeEmpty();
-    if (!colrv1_start_glyph_bounds(&ctm, &bounds, face, glyphID, FT_COLOR_INCLUDE_ROOT_TRANSFORM)) {
+    SkColrV1GlyphCache* cache =
+            static_cast<SkTypeface_FreeType*>(this->getTypeface())->colrV1GlyphCache();
+    SkRect fontBounds;
+    if (!colrv1_paint_graph_font_bounds(face, cache, glyphID, &fontBounds, faceChanged)) {
         return false;
     }
 
+    // Mapping the bounds, rather than the outlines, is exact unless the strike rotates or skews.
+    SkRect bounds = colrv1_root_transform(face).mapRect(fontBounds);
+
     /* Convert back to FT_BBox as caller needs it in this format. */
     bounds.sort();
     boundingBox->xMin = SkScalarToFDot6(bounds.left());
@@ -1695,3 +1965,70 @@ bool SkScalerContext_FreeType_Base::computeColrV1GlyphBoundingBox(FT_Face face,
     return false;
 #endif
 }
+
+bool SkScalerContext_FreeType_Base::ComputeColrV1GlyphFontBounds(FT_Face face,
+                                                                 SkColrV1GlyphCache* cache,
+                                                                 SkGlyphID glyphID,
+                                                                 SkRect* bounds) {
+#ifdef TT_SUPPORT_COLRV1
+    FT_OpaquePaint opaque_paint;
+    opaque_paint.p = nullptr;
+    if (!FT_Get_Color_Glyph_Paint(face, glyphID, FT_COLOR_NO_ROOT_TRANSFORM, &opaque_paint)) {
+        return false;
+    }
+    SkPath clipBox = GetClipBoxPath(face, cache, glyphID, true);
+    if (!clipBox.isEmpty()) {
+        *bounds = clipBox.getBounds();
+        return true;
+    }
+    bool faceChanged;
+    return colrv1_paint_graph_font_bounds(face, cache, glyphID, bounds, &faceChanged);
+#else
+    return false;
+#endif
+}
+
+sk_sp<SkColrV1Glyph> SkScalerContext_FreeType_Base::BuildColrV1Glyph(FT_Face face,
+                                                                    SkColrV1GlyphCache* cache,
+                                                                    SkGlyphID glyphID,
+                                                                    bool elideCompositeLayers) {
+#ifdef TT_SUPPORT_COLRV1
+    SkColrV1Glyph::Builder builder;
+    if (colrv1_start_glyph(&builder, face, cache, glyphID, FT_COLOR_NO_ROOT_TRANSFORM,
+                           elideCompositeLayers)) {
+        return builder.detach();
+    }
+#endif
+    return nullptr;
+}
+
+FT_Color* SkScalerContext_FreeType_Base::selectPalette(FT_Face face) const {
+#ifdef FT_COLOR_H
+    FT_Palette_Data paletteData;
+    if (FT_Palette_Data_Get(face, &paletteData) || paletteData.num_palettes == 0) {
+        return nullptr;
+    }
+
+    // FT_Palette_Select() copies the palette into the face, undoing any earlier overrides.
+    FT_UShort index = 0 <= fPaletteIndex && fPaletteIndex < paletteData.num_palettes
+                    ? SkToU16(fPaletteIndex) : 0;
+    FT_Color* palette;
+    FT_Error err = FT_Palette_Select(face, index, &palette);
+    if (err) {
+        SK_TRACEFTR(err, "Could not select palette %d from %s fontFace.",
+                    index, face->family_name);
+        return nullptr;
+    }
+    for (const SkFontArguments::Palette::Override& entry : fPaletteOverrides) {
+        if (0 <= entry.index && entry.index < paletteData.num_palette_entries) {
+            palette[entry.index] = {(FT_Byte)SkColorGetB(entry.color),
+                                    (FT_Byte)SkColorGetG(entry.color),
+                                    (FT_Byte)SkColorGetR(entry.color),
+                                    (FT_Byte)SkColorGetA(entry.color)};
+        }
+    }
+    return palette;
+#else
+    return nullptr;
+#endif
+}
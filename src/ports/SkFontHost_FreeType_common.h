@@ -9,11 +9,13 @@
 #ifndef SKFONTHOST_FREETYPE_COMMON_H_
 #define SKFONTHOST_FREETYPE_COMMON_H_
 
+#include "include/core/SkSpan.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
 #include "src/core/SkGlyph.h"
 #include "src/core/SkScalerContext.h"
 #include "src/core/SkSharedMutex.h"
+#include "src/ports/SkColrV1Glyph.h"
 #include "src/utils/SkCharToGlyphCache.h"
 
 #include "include/core/SkFontMgr.h"
@@ -24,7 +26,7 @@ typedef struct FT_FaceRec_* FT_Face;
 typedef struct FT_StreamRec_* FT_Stream;
 typedef signed long FT_Pos;
 typedef struct FT_BBox_ FT_BBox;
-
+typedef struct FT_Color_ FT_Color;
 
 #ifdef SK_DEBUG
 const char* SkTraceFtrGetError(int);
@@ -37,6 +39,20 @@ const char* SkTraceFtrGetError(int);
 
 
 class SkScalerContext_FreeType_Base : public SkScalerContext {
+public:
+    // Computes bounds containing a COLRv1 glyph id in font units and Skia's y-down coordinate
+    // space, from its ClipBox if it has one and from its paint graph otherwise. Returns false for
+    // glyphs without a COLRv1 paint graph. This may load other glyphs into face.
+    static bool ComputeColrV1GlyphFontBounds(FT_Face face, SkColrV1GlyphCache* cache,
+                                             SkGlyphID glyphID, SkRect* bounds);
+
+    // Decodes the paint graph of a COLRv1 glyph id in font units, without looking it up in or
+    // adding it to cache. Unless elideCompositeLayers, every PaintComposite is recorded with two
+    // unbounded layers, which the elided and bounded layers can be checked against. Returns
+    // nullptr for glyphs without a COLRv1 paint graph.
+    static sk_sp<SkColrV1Glyph> BuildColrV1Glyph(FT_Face face, SkColrV1GlyphCache* cache,
+                                                 SkGlyphID glyphID, bool elideCompositeLayers);
+
 protected:
     // See http://freetype.sourceforge.net/freetype2/docs/reference/ft2-bitmap_handling.html#FT_Bitmap_Embolden
     // This value was chosen by eyeballing the result in Firefox and trying to match it.
@@ -51,14 +67,29 @@ protected:
     bool generateGlyphPath(FT_Face face, SkPath* path);
     bool generateFacePath(FT_Face face, SkGlyphID glyphID, SkPath* path);
 
+    // Returns a drawable for COLRv1 glyphs, and nullptr for all other glyphs. The size and
+    // transform of face must already be set up.
+    sk_sp<SkDrawable> generateGlyphDrawable(FT_Face face, const SkGlyph& glyph);
+
     // Computes a bounding box for a COLRv1 glyph id in FT_BBox 26.6 format and FreeType's y-up
     // coordinate space.
     // Needed to call into COLRv1 from generateMetrics().
     //
-    // Note : This method may change the configured size and transforms on FT_Face. Make sure to
-    // configure size, matrix and load glyphs as needed after using this function to restore the
-    // state of FT_Face.
-    bool computeColrV1GlyphBoundingBox(FT_Face face, SkGlyphID glyphID, FT_BBox* boundingBox);
+    // The bounds are computed in font units once per glyph and kept by the typeface, so only the
+    // first strike to measure a glyph walks its paint graph.
+    //
+    // Note : When *faceChanged is set this method changed the configured size and transforms on
+    // FT_Face, and loaded other glyphs. Make sure to configure size, matrix and load glyphs as
+    // needed after using this function to restore the state of FT_Face.
+    bool computeColrV1GlyphBoundingBox(FT_Face face, SkGlyphID glyphID, FT_BBox* boundingBox,
+                                       bool* faceChanged);
+
+    // Selects the CPAL palette of the typeface in face and applies the typeface's overrides to
+    // it. Returns the palette, or nullptr if face has no palettes.
+    FT_Color* selectPalette(FT_Face face) const;
+
+    int fPaletteIndex = 0;
+    SkSpan<const SkFontArguments::Palette::Override> fPaletteOverrides;
 
 private:
     using INHERITED = SkScalerContext;
@@ -106,13 +137,36 @@ public:
      */
     std::unique_ptr<SkFontData> makeFontData() const;
     class FaceRec;
+    /** Opens the face on first use. The face may only be used while holding its FaceRec's mutex. */
     FaceRec* getFaceRec() const;
 
+    /** See SkTypeface_SetFreeTypeFacePoolLimits(). */
+    static void SetFacePoolLimits(int maxFacesPerTypeface, size_t byteLimit);
+    /** See SkTypeface_GetFreeTypeFacePoolBytesUsed(). */
+    static size_t GetFacePoolBytesUsed();
+    /** Counts the pooled faces of this typeface which are open, and which of those are idle.
+     *  Only public for tests. */
+    void getFacePoolCounts(int* open, int* idle) const;
+    /** Limits the face pool of this typeface alone, instead of by the global limits. The byte
+     *  limit then only counts the pooled faces of this typeface. */
+    void setFacePoolLimits(int maxFaces, size_t byteLimit);
+    /** See SkScalerContext_FreeType_Base::BuildColrV1Glyph(). Only public for tests. */
+    sk_sp<SkColrV1Glyph> buildColrV1Glyph(SkGlyphID glyphID, bool elideCompositeLayers) const;
+
+    /** Decoded COLRv1 paint graphs of this typeface, shared by all of its scaler contexts. */
+    SkColrV1GlyphCache* colrV1GlyphCache() const { return fColrV1GlyphCache.get(); }
+
 protected:
     SkTypeface_FreeType(const SkFontStyle& style, bool isFixedPitch);
     ~SkTypeface_FreeType() override;
 
     std::unique_ptr<SkFontData> cloneFontData(const SkFontArguments&) const;
+    /** Called by onMakeClone(args) on its clone. If args leave the outlines as they are, e.g.
+     *  when they only select another palette, the clone shares this typeface's decoded COLRv1
+     *  glyphs. Returns clone.
+     */
+    sk_sp<SkTypeface> shareColrV1Glyphs(sk_sp<SkTypeface_FreeType> clone,
+                                        const SkFontArguments& args) const;
     std::unique_ptr<SkScalerContext> onCreateScalerContext(const SkScalerContextEffects&,
                                                            const SkDescriptor*) const override;
     void onFilterRec(SkScalerContextRec*) const override;
@@ -123,6 +177,8 @@ protected:
     int onGetUPEM() const override;
     bool onGetKerningPairAdjustments(const uint16_t glyphs[], int count,
                                      int32_t adjustments[]) const override;
+    void onGetColorGlyphBounds(const SkGlyphID glyphs[], int count, SkRect bounds[],
+                               bool found[]) const override;
     void onCharsToGlyphs(const SkUnichar uni[], int count, SkGlyphID glyphs[]) const override;
     int onCountGlyphs() const override;
 
@@ -146,6 +202,8 @@ private:
     mutable SkSharedMutex fC2GCacheMutex;
     mutable SkCharToGlyphCache fC2GCache;
 
+    sk_sp<SkColrV1GlyphCache> fColrV1GlyphCache;
+
     using INHERITED = SkTypeface;
 };
 
@@ -272,6 +272,7 @@ protected:
                                                      args.getCollectionIndex(),
                                                      axisValues.get(),
                                                      axisDefinitions.count());
+        fontData->setPalette(args.getPalette());
         return sk_sp<SkTypeface>(SkTypeface_FCI::Create(std::move(fontData), std::move(name),
                                                         style, isFixedPitch));
     }
@@ -97,22 +97,7 @@ public:
         return std::make_unique<SkFontData>(this->makeStream(), fIndex,
                                               fAxes.begin(), fAxes.count());
     }
-    sk_sp<SkTypeface> onMakeClone(const SkFontArguments& args) const override {
-        std::unique_ptr<SkFontData> data = this->cloneFontData(args);
-        if (!data) {
-            return nullptr;
-        }
-        return sk_make_sp<SkTypeface_AndroidSystem>(fPathName,
-                                                    fFile,
-                                                    fIndex,
-                                                    data->getAxis(),
-                                                    data->getAxisCount(),
-                                                    this->fontStyle(),
-                                                    this->isFixedPitch(),
-                                                    fFamilyName,
-                                                    fLang,
-                                                    fVariantStyle);
-    }
+    sk_sp<SkTypeface> onMakeClone(const SkFontArguments& args) const override;
 
     const SkString fPathName;
     int fIndex;
@@ -155,10 +140,11 @@ public:
         if (!data) {
             return nullptr;
         }
-        return sk_make_sp<SkTypeface_AndroidStream>(std::move(data),
-                                                    this->fontStyle(),
-                                                    this->isFixedPitch(),
-                                                    fFamilyName);
+        auto clone = sk_make_sp<SkTypeface_AndroidStream>(std::move(data),
+                                                          this->fontStyle(),
+                                                          this->isFixedPitch(),
+                                                          fFamilyName);
+        return this->shareColrV1Glyphs(std::move(clone), args);
     }
 
 private:
@@ -166,6 +152,32 @@ private:
     using INHERITED = SkTypeface_Android;
 };
 
+sk_sp<SkTypeface> SkTypeface_AndroidSystem::onMakeClone(const SkFontArguments& args) const {
+    std::unique_ptr<SkFontData> data = this->cloneFontData(args);
+    if (!data) {
+        return nullptr;
+    }
+    // A system typeface is recreated from its path and axes, which cannot hold a palette.
+    if (data->getPaletteIndex() != 0 || !data->getPaletteOverrides().empty()) {
+        auto clone = sk_make_sp<SkTypeface_AndroidStream>(std::move(data),
+                                                          this->fontStyle(),
+                                                          this->isFixedPitch(),
+                                                          fFamilyName);
+        return this->shareColrV1Glyphs(std::move(clone), args);
+    }
+    auto clone = sk_make_sp<SkTypeface_AndroidSystem>(fPathName,
+                                                      fFile,
+                                                      fIndex,
+                                                      data->getAxis(),
+                                                      data->getAxisCount(),
+                                                      this->fontStyle(),
+                                                      this->isFixedPitch(),
+                                                      fFamilyName,
+                                                      fLang,
+                                                      fVariantStyle);
+    return this->shareColrV1Glyphs(std::move(clone), args);
+}
+
 class SkFontStyleSet_Android : public SkFontStyleSet {
     typedef SkTypeface_FreeType::Scanner Scanner;
 
@@ -472,6 +484,7 @@ protected:
 
         auto data = std::make_unique<SkFontData>(std::move(stream), args.getCollectionIndex(),
                                                    axisValues.get(), axisDefinitions.count());
+        data->setPalette(args.getPalette());
         return sk_sp<SkTypeface>(new SkTypeface_AndroidStream(std::move(data),
                                                               style, isFixedPitch, name));
     }
@@ -80,11 +80,12 @@ sk_sp<SkTypeface> SkTypeface_Stream::onMakeClone(const SkFontArguments& args) co
     SkString familyName;
     this->getFamilyName(&familyName);
 
-    return sk_make_sp<SkTypeface_Stream>(std::move(data),
-                                         this->fontStyle(),
-                                         this->isFixedPitch(),
-                                         this->isSysFont(),
-                                         familyName);
+    auto clone = sk_make_sp<SkTypeface_Stream>(std::move(data),
+                                               this->fontStyle(),
+                                               this->isFixedPitch(),
+                                               this->isSysFont(),
+                                               familyName);
+    return this->shareColrV1Glyphs(std::move(clone), args);
 }
 
 SkTypeface_File::SkTypeface_File(const SkFontStyle& style, bool isFixedPitch, bool sysFont,
@@ -107,11 +108,12 @@ sk_sp<SkTypeface> SkTypeface_File::onMakeClone(const SkFontArguments& args) cons
     SkString familyName;
     this->getFamilyName(&familyName);
 
-    return sk_make_sp<SkTypeface_Stream>(std::move(data),
-                                         this->fontStyle(),
-                                         this->isFixedPitch(),
-                                         this->isSysFont(),
-                                         familyName);
+    auto clone = sk_make_sp<SkTypeface_Stream>(std::move(data),
+                                               this->fontStyle(),
+                                               this->isFixedPitch(),
+                                               this->isSysFont(),
+                                               familyName);
+    return this->shareColrV1Glyphs(std::move(clone), args);
 }
 
 std::unique_ptr<SkFontData> SkTypeface_File::onMakeFontData() const {
@@ -251,6 +253,7 @@ sk_sp<SkTypeface> SkFontMgr_Custom::onMakeFromStreamArgs(std::unique_ptr<SkStrea
 
     auto data = std::make_unique<SkFontData>(std::move(stream), args.getCollectionIndex(),
                                                axisValues.get(), axisDefinitions.count());
+    data->setPalette(args.getPalette());
     return sk_sp<SkTypeface>(new SkTypeface_Stream(std::move(data), style, isFixedPitch, false, name));
 }
 
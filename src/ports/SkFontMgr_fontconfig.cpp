@@ -427,10 +427,11 @@ public:
         if (!data) {
             return nullptr;
         }
-        return sk_make_sp<SkTypeface_stream>(std::move(data),
-                                             fFamilyName,
-                                             this->fontStyle(),
-                                             this->isFixedPitch());
+        auto clone = sk_make_sp<SkTypeface_stream>(std::move(data),
+                                                   fFamilyName,
+                                                   this->fontStyle(),
+                                                   this->isFixedPitch());
+        return this->shareColrV1Glyphs(std::move(clone), args);
     }
 
 private:
@@ -528,10 +529,11 @@ public:
         SkString familyName;
         this->getFamilyName(&familyName);
 
-        return sk_make_sp<SkTypeface_stream>(std::move(data),
-                                             familyName,
-                                             this->fontStyle(),
-                                             this->isFixedPitch());
+        auto clone = sk_make_sp<SkTypeface_stream>(std::move(data),
+                                                   familyName,
+                                                   this->fontStyle(),
+                                                   this->isFixedPitch());
+        return this->shareColrV1Glyphs(std::move(clone), args);
     }
 
     std::unique_ptr<SkFontData> onMakeFontData() const override {
@@ -990,6 +992,7 @@ protected:
 
         auto data = std::make_unique<SkFontData>(std::move(stream), args.getCollectionIndex(),
                                                    axisValues.get(), axisDefinitions.count());
+        data->setPalette(args.getPalette());
         return sk_sp<SkTypeface>(new SkTypeface_stream(std::move(data), std::move(name),
                                                        style, isFixedPitch));
     }
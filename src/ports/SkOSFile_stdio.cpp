@@ -12,13 +12,14 @@
 #include <stdio.h>
 #include <sys/stat.h>
 
-#ifdef SK_BUILD_FOR_UNIX
+#ifndef _WIN32
 #include <unistd.h>
 #endif
 
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#include <process.h>
 #include <vector>
 #include "src/utils/SkUTF.h"
 #endif
@@ -190,3 +191,11 @@ bool sk_mkdir(const char* path) {
 #endif
     return 0 == retval;
 }
+
+int sk_getpid() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
@@ -19,6 +19,7 @@
 #include "src/core/SkWriteBuffer.h"
 #include "src/shaders/gradients/Sk4fLinearGradient.h"
 #include "src/shaders/gradients/SkGradientShaderPriv.h"
+#include "src/shaders/gradients/SkGradientTable.h"
 #include "src/shaders/gradients/SkLinearGradient.h"
 #include "src/shaders/gradients/SkRadialGradient.h"
 #include "src/shaders/gradients/SkSweepGradient.h"
@@ -218,63 +219,6 @@ void SkGradientShaderBase::flatten(SkWriteBuffer& buffer) const {
     desc.flatten(buffer);
 }
 
-static void add_stop_color(SkRasterPipeline_GradientCtx* ctx, size_t stop, SkPMColor4f Fs, SkPMColor4f Bs) {
-    (ctx->fs[0])[stop] = Fs.fR;
-    (ctx->fs[1])[stop] = Fs.fG;
-    (ctx->fs[2])[stop] = Fs.fB;
-    (ctx->fs[3])[stop] = Fs.fA;
-
-    (ctx->bs[0])[stop] = Bs.fR;
-    (ctx->bs[1])[stop] = Bs.fG;
-    (ctx->bs[2])[stop] = Bs.fB;
-    (ctx->bs[3])[stop] = Bs.fA;
-}
-
-static void add_const_color(SkRasterPipeline_GradientCtx* ctx, size_t stop, SkPMColor4f color) {
-    add_stop_color(ctx, stop, { 0, 0, 0, 0 }, color);
-}
-
-// Calculate a factor F and a bias B so that color = F*t + B when t is in range of
-// the stop. Assume that the distance between stops is 1/gapCount.
-static void init_stop_evenly(
-    SkRasterPipeline_GradientCtx* ctx, float gapCount, size_t stop, SkPMColor4f c_l, SkPMColor4f c_r) {
-    // Clankium's GCC 4.9 targeting ARMv7 is barfing when we use Sk4f math here, so go scalar...
-    SkPMColor4f Fs = {
-        (c_r.fR - c_l.fR) * gapCount,
-        (c_r.fG - c_l.fG) * gapCount,
-        (c_r.fB - c_l.fB) * gapCount,
-        (c_r.fA - c_l.fA) * gapCount,
-    };
-    SkPMColor4f Bs = {
-        c_l.fR - Fs.fR*(stop/gapCount),
-        c_l.fG - Fs.fG*(stop/gapCount),
-        c_l.fB - Fs.fB*(stop/gapCount),
-        c_l.fA - Fs.fA*(stop/gapCount),
-    };
-    add_stop_color(ctx, stop, Fs, Bs);
-}
-
-// For each stop we calculate a bias B and a scale factor F, such that
-// for any t between stops n and n+1, the color we want is B[n] + F[n]*t.
-static void init_stop_pos(
-    SkRasterPipeline_GradientCtx* ctx, size_t stop, float t_l, float t_r, SkPMColor4f c_l, SkPMColor4f c_r) {
-    // See note about Clankium's old compiler in init_stop_evenly().
-    SkPMColor4f Fs = {
-        (c_r.fR - c_l.fR) / (t_r - t_l),
-        (c_r.fG - c_l.fG) / (t_r - t_l),
-        (c_r.fB - c_l.fB) / (t_r - t_l),
-        (c_r.fA - c_l.fA) / (t_r - t_l),
-    };
-    SkPMColor4f Bs = {
-        c_l.fR - Fs.fR*t_l,
-        c_l.fG - Fs.fG*t_l,
-        c_l.fB - Fs.fB*t_l,
-        c_l.fA - Fs.fA*t_l,
-    };
-    ctx->ts[stop] = t_l;
-    add_stop_color(ctx, stop, Fs, Bs);
-}
-
 bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
     SkRasterPipeline* p = rec.fPipeline;
     SkArenaAlloc* alloc = rec.fAlloc;
@@ -306,8 +250,8 @@ bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
             if (!fOrigPos) {
                 // We clamp only when the stops are evenly spaced.
                 // If not, there may be hard stops, and clamping ruins hard stops at 0 and/or 1.
-                // In that case, we must make sure we're using the general "gradient" stage,
-                // which is the only stage that will correctly handle unclamped t.
+                // In that case, we must make sure we're using the general "gradient" stage, or
+                // its "indexed_gradient" form, the only stages that correctly handle unclamped t.
                 p->append(SkRasterPipeline::clamp_x_1);
             }
             break;
@@ -315,97 +259,10 @@ bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
 
     const bool premulGrad = fGradFlags & SkGradientShader::kInterpolateColorsInPremul_Flag;
 
-    // Transform all of the colors to destination color space
-    SkColor4fXformer xformedColors(fOrigColors4f, fColorCount, fColorSpace.get(), rec.fDstCS);
-
-    auto prepareColor = [premulGrad, &xformedColors](int i) {
-        SkColor4f c = xformedColors.fColors[i];
-        return premulGrad ? c.premul()
-                          : SkPMColor4f{ c.fR, c.fG, c.fB, c.fA };
-    };
-
-    // The two-stop case with stops at 0 and 1.
-    if (fColorCount == 2 && fOrigPos == nullptr) {
-        const SkPMColor4f c_l = prepareColor(0),
-                          c_r = prepareColor(1);
-
-        // See F and B below.
-        auto ctx = alloc->make<SkRasterPipeline_EvenlySpaced2StopGradientCtx>();
-        (Sk4f::Load(c_r.vec()) - Sk4f::Load(c_l.vec())).store(ctx->f);
-        (                        Sk4f::Load(c_l.vec())).store(ctx->b);
-        ctx->interpolatedInPremul = premulGrad;
-
-        p->append(SkRasterPipeline::evenly_spaced_2_stop_gradient, ctx);
-    } else {
-        auto* ctx = alloc->make<SkRasterPipeline_GradientCtx>();
-        ctx->interpolatedInPremul = premulGrad;
-
-        // Note: In order to handle clamps in search, the search assumes a stop conceptully placed
-        // at -inf. Therefore, the max number of stops is fColorCount+1.
-        for (int i = 0; i < 4; i++) {
-            // Allocate at least at for the AVX2 gather from a YMM register.
-            ctx->fs[i] = alloc->makeArray<float>(std::max(fColorCount+1, 8));
-            ctx->bs[i] = alloc->makeArray<float>(std::max(fColorCount+1, 8));
-        }
-
-        if (fOrigPos == nullptr) {
-            // Handle evenly distributed stops.
-
-            size_t stopCount = fColorCount;
-            float gapCount = stopCount - 1;
-
-            SkPMColor4f c_l = prepareColor(0);
-            for (size_t i = 0; i < stopCount - 1; i++) {
-                SkPMColor4f c_r = prepareColor(i + 1);
-                init_stop_evenly(ctx, gapCount, i, c_l, c_r);
-                c_l = c_r;
-            }
-            add_const_color(ctx, stopCount - 1, c_l);
-
-            ctx->stopCount = stopCount;
-            p->append(SkRasterPipeline::evenly_spaced_gradient, ctx);
-        } else {
-            // Handle arbitrary stops.
-
-            ctx->ts = alloc->makeArray<float>(fColorCount+1);
-
-            // Remove the default stops inserted by SkGradientShaderBase::SkGradientShaderBase
-            // because they are naturally handled by the search method.
-            int firstStop;
-            int lastStop;
-            if (fColorCount > 2) {
-                firstStop = fOrigColors4f[0] != fOrigColors4f[1] ? 0 : 1;
-                lastStop = fOrigColors4f[fColorCount - 2] != fOrigColors4f[fColorCount - 1]
-                           ? fColorCount - 1 : fColorCount - 2;
-            } else {
-                firstStop = 0;
-                lastStop = 1;
-            }
-
-            size_t stopCount = 0;
-            float  t_l = fOrigPos[firstStop];
-            SkPMColor4f c_l = prepareColor(firstStop);
-            add_const_color(ctx, stopCount++, c_l);
-            // N.B. lastStop is the index of the last stop, not one after.
-            for (int i = firstStop; i < lastStop; i++) {
-                float  t_r = fOrigPos[i + 1];
-                SkPMColor4f c_r = prepareColor(i + 1);
-                SkASSERT(t_l <= t_r);
-                if (t_l < t_r) {
-                    init_stop_pos(ctx, stopCount, t_l, t_r, c_l, c_r);
-                    stopCount += 1;
-                }
-                t_l = t_r;
-                c_l = c_r;
-            }
-
-            ctx->ts[stopCount] = t_l;
-            add_const_color(ctx, stopCount++, c_l);
-
-            ctx->stopCount = stopCount;
-            p->append(SkRasterPipeline::gradient, ctx);
-        }
-    }
+    // The table is referenced by the pipeline, so it has to live as long as the arena.
+    const SkGradientTable* table = alloc->make<sk_sp<const SkGradientTable>>(
+            this->findOrMakeTable(rec.fDstCS))->get();
+    table->appendStages(p);
 
     if (decal_ctx) {
         p->append(SkRasterPipeline::check_decal_mask, decal_ctx);
@@ -420,6 +277,29 @@ bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
     return true;
 }
 
+sk_sp<const SkGradientTable> SkGradientShaderBase::findOrMakeTable(SkColorSpace* dstCS) const {
+    SkAutoMutexExclusive lock(fTableMutex);
+    if (fTable && SkColorSpace::Equals(fTableColorSpace.get(), dstCS)) {
+        return fTable;
+    }
+
+    const bool premulGrad = fGradFlags & SkGradientShader::kInterpolateColorsInPremul_Flag;
+
+    // Transform all of the colors to destination color space
+    SkColor4fXformer xformedColors(fOrigColors4f, fColorCount, fColorSpace.get(), dstCS);
+
+    SkSTArray<16, SkPMColor4f, true> colors(fColorCount);
+    for (int i = 0; i < fColorCount; ++i) {
+        SkColor4f c = xformedColors.fColors[i];
+        colors.push_back(premulGrad ? c.premul()
+                                    : SkPMColor4f{ c.fR, c.fG, c.fB, c.fA });
+    }
+
+    fTable = SkGradientTable::Make(colors.begin(), fOrigPos, fColorCount, premulGrad);
+    fTableColorSpace = sk_ref_sp(dstCS);
+    return fTable;
+}
+
 skvm::Color SkGradientShaderBase::onProgram(skvm::Builder* p,
                                             skvm::Coord device, skvm::Coord local,
                                             skvm::Color /*paint*/,
@@ -11,6 +11,7 @@
 #include "include/effects/SkGradientShader.h"
 
 #include "include/core/SkMatrix.h"
+#include "include/private/SkMutex.h"
 #include "include/private/SkTArray.h"
 #include "include/private/SkTemplates.h"
 #include "src/core/SkArenaAlloc.h"
@@ -18,6 +19,7 @@
 #include "src/shaders/SkShaderBase.h"
 
 class SkColorSpace;
+class SkGradientTable;
 class SkRasterPipeline;
 class SkReadBuffer;
 class SkWriteBuffer;
@@ -132,6 +134,9 @@ public:
     SkTileMode getTileMode() const { return fTileMode; }
 
 private:
+    // The color line in dstCS, which is kept for the next draw to the same color space.
+    sk_sp<const SkGradientTable> findOrMakeTable(SkColorSpace* dstCS) const;
+
     // Reserve inline space for up to 4 stops.
     static constexpr size_t kInlineStopCount   = 4;
     static constexpr size_t kInlineStorageSize = (sizeof(SkColor4f) + sizeof(SkScalar))
@@ -140,6 +145,10 @@ private:
 
     bool                                        fColorsAreOpaque;
 
+    mutable SkMutex                      fTableMutex;
+    mutable sk_sp<SkColorSpace>          fTableColorSpace SK_GUARDED_BY(fTableMutex);
+    mutable sk_sp<const SkGradientTable> fTable SK_GUARDED_BY(fTableMutex);
+
     using INHERITED = SkShaderBase;
 };
 
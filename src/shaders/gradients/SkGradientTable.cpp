@@ -0,0 +1,236 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/shaders/gradients/SkGradientTable.h"
+
+#include "include/private/SkNx.h"
+#include "src/core/SkMathPriv.h"
+
+#include <algorithm>
+
+namespace {
+
+void add_stop_color(SkRasterPipeline_GradientCtx* ctx, size_t stop,
+                    SkPMColor4f Fs, SkPMColor4f Bs) {
+    (ctx->fs[0])[stop] = Fs.fR;
+    (ctx->fs[1])[stop] = Fs.fG;
+    (ctx->fs[2])[stop] = Fs.fB;
+    (ctx->fs[3])[stop] = Fs.fA;
+
+    (ctx->bs[0])[stop] = Bs.fR;
+    (ctx->bs[1])[stop] = Bs.fG;
+    (ctx->bs[2])[stop] = Bs.fB;
+    (ctx->bs[3])[stop] = Bs.fA;
+}
+
+void add_const_color(SkRasterPipeline_GradientCtx* ctx, size_t stop, SkPMColor4f color) {
+    add_stop_color(ctx, stop, { 0, 0, 0, 0 }, color);
+}
+
+// Calculate a factor F and a bias B so that color = F*t + B when t is in range of
+// the stop. Assume that the distance between stops is 1/gapCount.
+void init_stop_evenly(SkRasterPipeline_GradientCtx* ctx, float gapCount, size_t stop,
+                      SkPMColor4f c_l, SkPMColor4f c_r) {
+    // Clankium's GCC 4.9 targeting ARMv7 is barfing when we use Sk4f math here, so go scalar...
+    SkPMColor4f Fs = {
+        (c_r.fR - c_l.fR) * gapCount,
+        (c_r.fG - c_l.fG) * gapCount,
+        (c_r.fB - c_l.fB) * gapCount,
+        (c_r.fA - c_l.fA) * gapCount,
+    };
+    SkPMColor4f Bs = {
+        c_l.fR - Fs.fR*(stop/gapCount),
+        c_l.fG - Fs.fG*(stop/gapCount),
+        c_l.fB - Fs.fB*(stop/gapCount),
+        c_l.fA - Fs.fA*(stop/gapCount),
+    };
+    add_stop_color(ctx, stop, Fs, Bs);
+}
+
+// For each stop we calculate a bias B and a scale factor F, such that
+// for any t between stops n and n+1, the color we want is B[n] + F[n]*t.
+void init_stop_pos(SkRasterPipeline_GradientCtx* ctx, size_t stop, float t_l, float t_r,
+                   SkPMColor4f c_l, SkPMColor4f c_r) {
+    // See note about Clankium's old compiler in init_stop_evenly().
+    SkPMColor4f Fs = {
+        (c_r.fR - c_l.fR) / (t_r - t_l),
+        (c_r.fG - c_l.fG) / (t_r - t_l),
+        (c_r.fB - c_l.fB) / (t_r - t_l),
+        (c_r.fA - c_l.fA) / (t_r - t_l),
+    };
+    SkPMColor4f Bs = {
+        c_l.fR - Fs.fR*t_l,
+        c_l.fG - Fs.fG*t_l,
+        c_l.fB - Fs.fB*t_l,
+        c_l.fA - Fs.fA*t_l,
+    };
+    ctx->ts[stop] = t_l;
+    add_stop_color(ctx, stop, Fs, Bs);
+}
+
+}  // namespace
+
+sk_sp<const SkGradientTable> SkGradientTable::Make(const SkPMColor4f colors[],
+                                                   const SkScalar pos[], int count, bool premul) {
+    SkASSERT(count >= 2);
+
+    sk_sp<SkGradientTable> table(new SkGradientTable);
+    table->init(colors, pos, count, premul);
+    return table;
+}
+
+void SkGradientTable::allocate(size_t stopCount) {
+    // Allocate at least 8 of each for the AVX2 gather from a YMM register. ts gets one more,
+    // for the sentinel past the last stop.
+    const size_t colorSize = std::max(stopCount, (size_t)8);
+    fStorageSize = 8 * colorSize + stopCount + 1;
+    fStorage.reset(new float[fStorageSize]());
+
+    float* storage = fStorage.get();
+    for (int i = 0; i < 4; i++) {
+        fCtx.fs[i] = storage + (2 * i + 0) * colorSize;
+        fCtx.bs[i] = storage + (2 * i + 1) * colorSize;
+    }
+    fCtx.ts = storage + 8 * colorSize;
+    fCtx.cells = nullptr;
+    fCtx.cellCount = 0;
+}
+
+void SkGradientTable::init(const SkPMColor4f colors[], const SkScalar pos[], int count,
+                           bool premul) {
+    // The two-stop case with stops at 0 and 1.
+    if (count == 2 && pos == nullptr) {
+        const SkPMColor4f c_l = colors[0],
+                          c_r = colors[1];
+
+        // See F and B below.
+        (Sk4f::Load(c_r.vec()) - Sk4f::Load(c_l.vec())).store(f2StopCtx.f);
+        (                        Sk4f::Load(c_l.vec())).store(f2StopCtx.b);
+        f2StopCtx.interpolatedInPremul = premul;
+        fStage = SkRasterPipeline::evenly_spaced_2_stop_gradient;
+        return;
+    }
+
+    fCtx.interpolatedInPremul = premul;
+
+    if (pos == nullptr) {
+        // Handle evenly distributed stops.
+        size_t stopCount = count;
+        float gapCount = stopCount - 1;
+        this->allocate(stopCount);
+
+        SkPMColor4f c_l = colors[0];
+        for (size_t i = 0; i < stopCount - 1; i++) {
+            SkPMColor4f c_r = colors[i + 1];
+            init_stop_evenly(&fCtx, gapCount, i, c_l, c_r);
+            c_l = c_r;
+        }
+        add_const_color(&fCtx, stopCount - 1, c_l);
+
+        fCtx.stopCount = stopCount;
+        fStage = SkRasterPipeline::evenly_spaced_gradient;
+        return;
+    }
+
+    // Handle arbitrary stops.
+
+    // Note: In order to handle clamps in search, the search assumes a stop conceptully placed
+    // at -inf. Therefore, the max number of stops is count+1.
+    this->allocate(count + 1);
+
+    // Remove the default stops inserted by SkGradientShaderBase::SkGradientShaderBase
+    // because they are naturally handled by the search method.
+    int firstStop;
+    int lastStop;
+    if (count > 2) {
+        firstStop = colors[0] != colors[1] ? 0 : 1;
+        lastStop = colors[count - 2] != colors[count - 1] ? count - 1 : count - 2;
+    } else {
+        firstStop = 0;
+        lastStop = 1;
+    }
+
+    size_t stopCount = 0;
+    float  t_l = pos[firstStop];
+    SkPMColor4f c_l = colors[firstStop];
+    add_const_color(&fCtx, stopCount++, c_l);
+    // N.B. lastStop is the index of the last stop, not one after.
+    for (int i = firstStop; i < lastStop; i++) {
+        float  t_r = pos[i + 1];
+        SkPMColor4f c_r = colors[i + 1];
+        SkASSERT(t_l <= t_r);
+        if (t_l < t_r) {
+            init_stop_pos(&fCtx, stopCount, t_l, t_r, c_l, c_r);
+            stopCount += 1;
+        }
+        t_l = t_r;
+        c_l = c_r;
+    }
+
+    fCtx.ts[stopCount] = t_l;
+    add_const_color(&fCtx, stopCount++, c_l);
+
+    // t never compares greater or equal to NaN, so the interval search never steps past the
+    // last stop, even for t = +inf.
+    fCtx.ts[stopCount] = SK_FloatNaN;
+    fCtx.stopCount = stopCount;
+    fStage = SkRasterPipeline::gradient;
+
+    if (stopCount >= kMinIndexedStopCount) {
+        this->buildIndex();
+    }
+}
+
+void SkGradientTable::buildIndex() {
+    // Cell c covers t in [c/N, (c+1)/N), and the last cell everything above it as well. The
+    // cell of t holds the number of stops below the cell, so t is in that interval or, if
+    // the cell holds a stop at or below t, in the next one. That only works when no cell holds
+    // two stops, so double the cells until none does.
+    const size_t stopCount = fCtx.stopCount;
+    const float* ts = fCtx.ts;
+    SkASSERT(ts[1] >= 0);
+
+    for (size_t cellCount = SkNextPow2(SkToInt(stopCount)); cellCount <= kMaxCellCount;
+         cellCount *= 2) {
+        std::unique_ptr<uint32_t[]> cells(new uint32_t[cellCount]);
+        bool singleStops = true;
+        size_t below = 0;
+        for (size_t c = 0; c < cellCount && singleStops; ++c) {
+            // N.B. c/cellCount is exact, so this places the stops as t * cellCount does.
+            const float start = (float)c / cellCount;
+            const size_t first = below;
+            // ts[0] is never compared, as the search assumes it is at -inf.
+            while (below + 1 < stopCount && ts[below + 1] < start) {
+                ++below;
+            }
+            singleStops = c == 0 || below - first <= 1;
+            cells[c] = SkToU32(below);
+        }
+        // Everything above the start of the last cell falls in it.
+        singleStops = singleStops && stopCount - 1 - below <= 1;
+        if (singleStops) {
+            fCells = std::move(cells);
+            fCtx.cells = fCells.get();
+            fCtx.cellCount = SkToU32(cellCount);
+            fStage = SkRasterPipeline::indexed_gradient;
+            return;
+        }
+    }
+    // The stops are too close together to be worth indexing.
+}
+
+void SkGradientTable::appendStages(SkRasterPipeline* p) const {
+    if (fStage == SkRasterPipeline::evenly_spaced_2_stop_gradient) {
+        p->append(fStage, &f2StopCtx);
+    } else {
+        p->append(fStage, &fCtx);
+    }
+}
+
+size_t SkGradientTable::approximateBytesUsed() const {
+    return sizeof(*this) + fStorageSize * sizeof(float) + fCtx.cellCount * sizeof(uint32_t);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradientTable_DEFINED
+#define SkGradientTable_DEFINED
+
+#include "include/core/SkRefCnt.h"
+#include "include/private/SkColorData.h"
+#include "src/core/SkRasterPipeline.h"
+
+#include <memory>
+
+class SkArenaAlloc;
+
+/**
+ *  The raster pipeline form of a gradient's color line: a scale and bias per interval between
+ *  stops, the stop positions, and, for lines with many unevenly spaced stops, an index from t
+ *  to the interval it falls in, so that finding the interval does not have to compare t with
+ *  every stop.
+ *
+ *  Tables are immutable once made, so a gradient shader makes its table once and shares it
+ *  between the pipelines of all of its draws.
+ */
+class SkGradientTable : public SkNVRefCnt<SkGradientTable> {
+public:
+    /**
+     *  colors must already be in the destination color space, and premultiplied if premul is
+     *  true. pos, if not nullptr, holds count positions, increasing from 0 to 1; otherwise the
+     *  stops are evenly spaced. count must be at least 2.
+     */
+    static sk_sp<const SkGradientTable> Make(const SkPMColor4f colors[], const SkScalar pos[],
+                                             int count, bool premul);
+
+    // Appends the stage which maps t, in r, to the color of the line. The caller must keep the
+    // table alive for as long as the pipeline is run.
+    void appendStages(SkRasterPipeline* p) const;
+    // The stage appendStages() appends.
+    SkRasterPipeline::StockStage stage() const { return fStage; }
+
+    size_t approximateBytesUsed() const;
+
+    // Lines with fewer stops than this just compare t with each of them; up to here the compares
+    // cost no more than the extra gathers of the index.
+    static constexpr size_t kMinIndexedStopCount = 32;
+    // The index has a power of two number of cells, small enough for any two stops to fall in
+    // different cells, but no more than this.
+    static constexpr size_t kMaxCellCount = 1024;
+
+private:
+    SkGradientTable() = default;
+
+    void init(const SkPMColor4f colors[], const SkScalar pos[], int count, bool premul);
+    void allocate(size_t stopCount);
+    void buildIndex();
+
+    SkRasterPipeline::StockStage                  fStage = SkRasterPipeline::gradient;
+    SkRasterPipeline_GradientCtx                  fCtx = {};
+    SkRasterPipeline_EvenlySpaced2StopGradientCtx f2StopCtx = {};
+    std::unique_ptr<float[]>                      fStorage;
+    size_t                                        fStorageSize = 0;
+    std::unique_ptr<uint32_t[]>                   fCells;
+};
+
+#endif
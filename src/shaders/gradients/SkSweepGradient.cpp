@@ -59,6 +59,19 @@ void SkSweepGradient::flatten(SkWriteBuffer& buffer) const {
 
 void SkSweepGradient::appendGradientStages(SkArenaAlloc* alloc, SkRasterPipeline* p,
                                            SkRasterPipeline*) const {
+    // Clamped sweeps over part of a turn, as COLRv1 fonts mostly draw them, find t in one
+    // stage. Other sweeps keep the stages they always had, and so their exact pixels.
+    const SkScalar t0 = -fTBias,
+                   t1 = t0 + 1 / fTScale;
+    if (fTileMode == SkTileMode::kClamp && fTScale != 1 &&
+        t0 >= 0 && t1 <= 1 + SK_ScalarNearlyZero) {
+        float* window = alloc->makeArrayDefault<float>(2);
+        window[0] = fTScale;
+        window[1] = fTScale * fTBias;
+        p->append(SkRasterPipeline::xy_to_sweep_window, window);
+        return;
+    }
+
     p->append(SkRasterPipeline::xy_to_unit_angle);
     p->append_matrix(alloc, SkMatrix::Scale(fTScale, 1) * SkMatrix::Translate(fTBias, 0));
 }
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/utils/SkTiledPicturePlayback.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPixmap.h"
+#include "include/utils/SkNoDrawCanvas.h"
+#include "src/core/SkTaskGroup.h"
+
+namespace {
+
+// Looks for saveLayers with a backdrop filter, in the picture and in the pictures and drawables
+// it draws. A backdrop filter reads the pixels around its layer, which may belong to other tiles.
+class BackdropFinder final : public SkNoDrawCanvas {
+public:
+    explicit BackdropFinder(const SkIRect& bounds) : SkNoDrawCanvas(bounds) {}
+
+    bool found() const { return fFound; }
+
+protected:
+    SaveLayerStrategy getSaveLayerStrategy(const SaveLayerRec& rec) override {
+        fFound |= rec.fBackdrop != nullptr;
+        return SkNoDrawCanvas::getSaveLayerStrategy(rec);
+    }
+
+    void onDrawPicture(const SkPicture* picture, const SkMatrix* matrix,
+                       const SkPaint* paint) override {
+        if (!fFound) {
+            this->SkCanvas::onDrawPicture(picture, matrix, paint);
+        }
+    }
+
+    void onDrawDrawable(SkDrawable* drawable, const SkMatrix* matrix) override {
+        if (!fFound) {
+            this->SkCanvas::onDrawDrawable(drawable, matrix);
+        }
+    }
+
+private:
+    bool fFound = false;
+};
+
+}  // namespace
+
+bool SkTiledPicturePlayback::Draw(const SkPixmap& dst, const SkPicture* picture,
+                                  const SkMatrix* matrix, SkExecutor& executor, int tileSize,
+                                  const SkSurfaceProps* props) {
+    if (!picture || !dst.addr() || tileSize <= 0) {
+        return false;
+    }
+    auto make_canvas = [&] {
+        return SkCanvas::MakeRasterDirect(dst.info(), dst.writable_addr(), dst.rowBytes(), props);
+    };
+    // MakeRasterDirect() fails the same way for every tile, so find out here, once.
+    if (!make_canvas()) {
+        return false;
+    }
+
+    // Tiles are not offset into their own devices, so each pixel is drawn with the same device
+    // coordinates, and so the same dither and the same rounding, as without tiles. The tiles
+    // only write inside their clips, and the clips do not overlap.
+    const int cols = (dst.width()  + tileSize - 1) / tileSize,
+              rows = (dst.height() + tileSize - 1) / tileSize;
+    const SkMatrix ctm = matrix ? *matrix : SkMatrix::I();
+
+    // A backdrop filter would read pixels of other tiles while they are drawn, so such pictures
+    // are drawn through one canvas, on this thread.
+    BackdropFinder finder(dst.bounds());
+    finder.concat(ctm);
+    struct StopOnBackdrop final : public SkPicture::AbortCallback {
+        explicit StopOnBackdrop(const BackdropFinder& finder) : fFinder(finder) {}
+        bool abort() override { return fFinder.found(); }
+        const BackdropFinder& fFinder;
+    } stopOnBackdrop(finder);
+    picture->playback(&finder, &stopOnBackdrop);
+    if (finder.found()) {
+        std::unique_ptr<SkCanvas> canvas = make_canvas();
+        canvas->concat(ctm);
+        picture->playback(canvas.get());
+        return true;
+    }
+
+    // Tiles are numbered row by row, and SkTaskGroup::parallelFor() hands each thread runs of
+    // consecutive indices, long at first and shorter as they run out. So a thread mostly draws
+    // neighbouring tiles along a row, nearby pixels and nearby parts of the picture's bounding
+    // box hierarchy, though runs may start or end mid-row.
+    SkTaskGroup tg(executor);
+    tg.parallelFor(cols * rows, [&](int i) {
+        SkIRect tile = SkIRect::MakeXYWH((i % cols) * tileSize, (i / cols) * tileSize,
+                                         tileSize, tileSize);
+        if (!tile.intersect(dst.bounds())) {
+            return;
+        }
+        std::unique_ptr<SkCanvas> canvas = make_canvas();
+        canvas->clipRect(SkRect::Make(tile));
+        canvas->concat(ctm);
+        picture->playback(canvas.get());
+    });
+    tg.wait();
+    return true;
+}
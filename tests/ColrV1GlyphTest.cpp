@@ -0,0 +1,229 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkData.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPath.h"
+#include "src/ports/SkColrV1Glyph.h"
+#include "tests/FreeTypeTestTypeface.h"
+#include "tests/Test.h"
+#include "tools/Resources.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using Fill = SkColrV1Glyph::Fill;
+using ColorStop = SkColrV1Glyph::ColorStop;
+
+Fill solid_fill() {
+    return {Fill::Type::kSolid, SkTileMode::kClamp, {}, {}, 0, 1};
+}
+
+// Draws solid colors through nested clips, like most emoji do.
+sk_sp<SkColrV1Glyph> make_solid_glyph() {
+    SkColrV1Glyph::Builder builder;
+    const ColorStop stops[] = {{0, 0, 1.0f}, {0, 1, 0.5f}, {0, 2, 1.0f},
+                               {0, SkColrV1Glyph::kForegroundPaletteIndex, 1.0f}};
+
+    builder.save();
+    builder.clipPath(SkPath::Circle(500, 500, 450));
+    builder.drawPath(SkPath::Rect(SkRect::MakeLTRB(0, 0, 1000, 600)), solid_fill(),
+                     SkMakeSpan(&stops[0], 1));
+    builder.save();
+    builder.concat(SkMatrix::RotateDeg(30, {500, 500}));
+    builder.drawPath(SkPath::Polygon({{100, 900}, {500, 100}, {900, 900}}, true), solid_fill(),
+                     SkMakeSpan(&stops[1], 1));
+    builder.restore();
+    builder.restore();
+
+    builder.save();
+    builder.clipPath(SkPath::Oval(SkRect::MakeLTRB(300, 650, 700, 950)));
+    builder.drawPaint(solid_fill(), SkMakeSpan(&stops[2], 1));
+    builder.restore();
+    builder.drawPath(SkPath::Rect(SkRect::MakeLTRB(450, 450, 550, 550)), solid_fill(),
+                     SkMakeSpan(&stops[3], 1));
+    return builder.detach();
+}
+
+}  // namespace
+
+DEF_TEST(ColrV1Glyph_recolor, r) {
+    sk_sp<SkColrV1Glyph> glyph = make_solid_glyph();
+    REPORTER_ASSERT(r, glyph->canRecolor());
+
+    const SkISize dimensions = {61, 53};
+    SkMatrix matrix = SkMatrix::Scale(0.055f, 0.05f);
+    matrix.postTranslate(2.25f, 1.5f);
+    sk_sp<SkColrV1Glyph::Coverage> coverage = glyph->makeCoverage(dimensions, matrix);
+    REPORTER_ASSERT(r, coverage);
+
+    const SkColor palettes[][3] = {
+        {SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE},
+        {SK_ColorCYAN, SkColorSetARGB(0x80, 0xFF, 0x00, 0xFF), SK_ColorTRANSPARENT},
+    };
+    for (const auto& palette : palettes) {
+        SkBitmap drawn, recolored;
+        drawn.allocN32Pixels(dimensions.width(), dimensions.height());
+        recolored.allocN32Pixels(dimensions.width(), dimensions.height());
+        drawn.eraseColor(SK_ColorTRANSPARENT);
+        recolored.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(drawn);
+        canvas.concat(matrix);
+        glyph->draw(&canvas, SkMakeSpan(palette));
+        coverage->recolor(recolored.pixmap(), SkMakeSpan(palette));
+
+        // The coverage and the clip are multiplied once more, and so rounded once more, when
+        // they are cached.
+        int maxDiff = 0;
+        for (int y = 0; y < dimensions.height(); ++y) {
+            for (int x = 0; x < dimensions.width(); ++x) {
+                const uint8_t* a = static_cast<const uint8_t*>(drawn.getAddr(x, y));
+                const uint8_t* b = static_cast<const uint8_t*>(recolored.getAddr(x, y));
+                for (int i = 0; i < 4; ++i) {
+                    maxDiff = std::max(maxDiff, std::abs(a[i] - b[i]));
+                }
+            }
+        }
+        REPORTER_ASSERT(r, maxDiff <= 2, "max difference %d", maxDiff);
+    }
+}
+
+DEF_TEST(ColrV1Glyph_recolorNeedsSolidFillsWithoutLayers, r) {
+    const ColorStop stops[] = {{0, 0, 1.0f}, {1, 1, 1.0f}};
+    const SkPath path = SkPath::Rect(SkRect::MakeWH(100, 100));
+
+    SkColrV1Glyph::Builder builder;
+    builder.saveLayer(SkBlendMode::kMultiply);
+    builder.drawPath(path, solid_fill(), SkMakeSpan(stops, 1));
+    builder.restore();
+    sk_sp<SkColrV1Glyph> layered = builder.detach();
+    REPORTER_ASSERT(r, !layered->canRecolor());
+    REPORTER_ASSERT(r, !layered->makeCoverage({10, 10}, SkMatrix::I()));
+
+    Fill linear = {Fill::Type::kLinearGradient, SkTileMode::kClamp, {{0, 0}, {100, 0}}, {}, 0, 2};
+    builder.drawPath(path, linear, SkMakeSpan(stops));
+    sk_sp<SkColrV1Glyph> gradient = builder.detach();
+    REPORTER_ASSERT(r, !gradient->canRecolor());
+}
+
+DEF_TEST(ColrV1GlyphCache_outlines, r) {
+    auto cache = sk_make_sp<SkColrV1GlyphCache>();
+    const SkPath outline = SkPath::Circle(500, 500, 450);
+    SkPath found;
+    REPORTER_ASSERT(r, !cache->findOutline(7, &found));
+    REPORTER_ASSERT(r, !cache->findClipBox(7, &found));
+
+    cache->addOutline(7, outline);
+    REPORTER_ASSERT(r, cache->findOutline(7, &found));
+    REPORTER_ASSERT(r, found == outline);
+    REPORTER_ASSERT(r, cache->bytesUsed() > 0);
+
+    // A glyph without a clip box is remembered as such.
+    cache->addClipBox(7, SkPath());
+    found = outline;
+    REPORTER_ASSERT(r, cache->findClipBox(7, &found));
+    REPORTER_ASSERT(r, found.isEmpty());
+    REPORTER_ASSERT(r, !cache->findOutline(8, &found));
+
+    // Past the budget, the least recently used outlines are dropped, one at a time.
+    std::vector<SkPoint> points(10000);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = {(float)i, (float)(i % 7)};
+    }
+    const SkPath large = SkPath::Polygon(points.data(), SkToInt(points.size()), true);
+    cache->addOutline(100, large);
+    cache->addOutline(101, large);
+    for (SkGlyphID glyphID = 102; glyphID < 150; ++glyphID) {
+        REPORTER_ASSERT(r, cache->findOutline(100, &found));
+        cache->addOutline(glyphID, large);
+    }
+    REPORTER_ASSERT(r, cache->findOutline(100, &found));
+    REPORTER_ASSERT(r, cache->findOutline(149, &found));
+    REPORTER_ASSERT(r, !cache->findOutline(101, &found));
+    REPORTER_ASSERT(r, cache->bytesUsed() < 2 * 1024 * 1024, "%zu bytes", cache->bytesUsed());
+}
+
+DEF_TEST(ColrV1GlyphCache_coverage, r) {
+    auto cache = sk_make_sp<SkColrV1GlyphCache>();
+    sk_sp<SkColrV1Glyph> glyph = make_solid_glyph();
+    const SkISize dimensions = {600, 600};
+    const SkMatrix matrix = SkMatrix::Scale(0.6f, 0.6f);
+
+    sk_sp<SkColrV1Glyph::Coverage> first = cache->findOrMakeCoverage(1, *glyph, dimensions, matrix);
+    REPORTER_ASSERT(r, first);
+    REPORTER_ASSERT(r, cache->findOrMakeCoverage(1, *glyph, dimensions, matrix) == first);
+    REPORTER_ASSERT(r, cache->bytesUsed() >= first->approximateBytesUsed());
+
+    // Large coverage is dropped past the budget, least recently used first.
+    for (SkGlyphID glyphID = 2; glyphID < 10; ++glyphID) {
+        cache->findOrMakeCoverage(glyphID, *glyph, dimensions, matrix);
+    }
+    REPORTER_ASSERT(r, cache->findOrMakeCoverage(1, *glyph, dimensions, matrix) != first);
+    REPORTER_ASSERT(r, cache->bytesUsed() < 2 * 1024 * 1024, "%zu bytes", cache->bytesUsed());
+}
+
+DEF_TEST(ColrV1Glyph_compositeLayers, r) {
+    // The composite samples use every composite mode, with overlapping and disjoint inputs.
+    const SkGlyphID glyphs[] = {40, 41, 42, 43, 44, 45, 46};
+    constexpr int kSize = 320;
+    sk_sp<SkData> data = GetResourceAsData("fonts/more_samples-glyf_colr_1.ttf");
+    if (!data) {
+        ERRORF(r, "Could not load font.");
+        return;
+    }
+    sk_sp<FreeTypeTestTypeface> typeface = sk_make_sp<FreeTypeTestTypeface>(std::move(data));
+    SkColor palette[256];
+    for (int i = 0; i < 256; ++i) {
+        palette[i] = SkColorSetRGB((i * 101) & 0xFF, (i * 53) & 0xFF, (i * 29) & 0xFF);
+    }
+
+    auto render = [&](const SkColrV1Glyph& glyph) {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(kSize, kSize);
+        bitmap.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(bitmap);
+        canvas.translate(0, kSize * 0.8f);
+        canvas.scale(kSize * 0.8f / typeface->getUnitsPerEm(),
+                     kSize * 0.8f / typeface->getUnitsPerEm());
+        glyph.draw(&canvas, SkMakeSpan(palette));
+        return bitmap;
+    };
+
+    // Layers round their pixels, so colors may be one off.
+    auto differ = [](SkColor a, SkColor b) {
+        return std::abs((int)SkColorGetA(a) - (int)SkColorGetA(b)) > 1 ||
+               std::abs((int)SkColorGetR(a) - (int)SkColorGetR(b)) > 1 ||
+               std::abs((int)SkColorGetG(a) - (int)SkColorGetG(b)) > 1 ||
+               std::abs((int)SkColorGetB(a) - (int)SkColorGetB(b)) > 1;
+    };
+
+    // The elided and bounded layers draw what a layer for every PaintComposite would.
+    for (SkGlyphID glyphID : glyphs) {
+        sk_sp<SkColrV1Glyph> elided = typeface->buildColrV1Glyph(glyphID, true);
+        sk_sp<SkColrV1Glyph> layered = typeface->buildColrV1Glyph(glyphID, false);
+        if (!elided || !layered) {
+            ERRORF(r, "Glyph %d is not a COLRv1 glyph.", glyphID);
+            continue;
+        }
+        SkBitmap expected = render(*layered),
+                 actual = render(*elided);
+        int drawn = 0, differences = 0;
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                drawn += expected.getColor(x, y) != SK_ColorTRANSPARENT;
+                differences += differ(expected.getColor(x, y), actual.getColor(x, y));
+            }
+        }
+        REPORTER_ASSERT(r, drawn > 0, "glyph %d draws nothing", glyphID);
+        REPORTER_ASSERT(r, differences == 0, "glyph %d: %d pixels differ", glyphID, differences);
+    }
+}
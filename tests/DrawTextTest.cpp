@@ -10,6 +10,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkMatrix.h"
+#include "include/core/SkOverdrawCanvas.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPathEffect.h"
 #include "include/core/SkPoint.h"
@@ -21,9 +22,15 @@
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
 #include "include/effects/SkDashPathEffect.h"
+#include "src/core/SkGlyphRun.h"
+#include "src/core/SkGlyphRunPainter.h"
+#include "src/core/SkStrikeCache.h"
+#include "src/core/SkStrikeSpec.h"
 #include "tests/Test.h"
+#include "tools/Resources.h"
 
 #include <cmath>
+#include <vector>
 
 static const SkColor bgColor = SK_ColorWHITE;
 
@@ -178,3 +185,239 @@ DEF_TEST(DrawText_noglyphs, r) {
             "\x0d\xf3\xf2\xf2\xe9\x0d\x0d\x0d\x05\x0d\x0d\xe3\xe3\xe3\xe3\xe3\xe3\xe3\xe3\xe3",
             10, 20, SkFont(), SkPaint());
 }
+
+namespace {
+// Counts the glyphs drawn each way by SkGlyphRunListPainter.
+class GlyphCounter : public SkGlyphRunListPainter::BitmapDevicePainter {
+public:
+    void paintPaths(SkDrawableGlyphBuffer* drawables, SkScalar, SkPoint,
+                    const SkPaint&) const override {
+        fPaths += drawables->drawable().size();
+    }
+    void paintMasks(SkDrawableGlyphBuffer* drawables, const SkPaint&) const override {
+        fMasks += drawables->drawable().size();
+    }
+    void paintDrawables(SkDrawableGlyphBuffer* drawables, SkScalar, SkPoint,
+                        const SkPaint&) const override {
+        fDrawables += drawables->drawable().size();
+    }
+    void drawBitmap(const SkBitmap&, const SkMatrix&, const SkRect*, const SkSamplingOptions&,
+                    const SkPaint&) const override {}
+
+    mutable size_t fPaths = 0, fMasks = 0, fDrawables = 0;
+};
+}  // namespace
+
+// Color glyphs too large for masks are drawn from a drawable that is shared by all sizes. They
+// should look like the glyph's mask at that size.
+DEF_TEST(DrawText_largeColorGlyphs, r) {
+    sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/more_samples-glyf_colr_1.ttf");
+    if (!typeface) {
+        return;
+    }
+    SkFont font(typeface, 300);
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+    sk_sp<SkStrike> strike = strikeSpec.findOrCreateStrike();
+
+    for (SkGlyphID glyphID = 0; glyphID < typeface->countGlyphs(); ++glyphID) {
+        SkPackedGlyphID packedID{glyphID};
+        const SkGlyph* glyph;
+        strike->prepareImages(SkMakeSpan(&packedID, 1), &glyph);
+        if (!glyph->isColor() || glyph->isEmpty() || glyph->image() == nullptr) {
+            continue;
+        }
+        SkBitmap mask;
+        mask.installPixels(SkImageInfo::MakeN32Premul(glyph->width(), glyph->height()),
+                           const_cast<void*>(glyph->image()), glyph->rowBytes());
+
+        SkBitmap drawn;
+        drawn.allocN32Pixels(glyph->width(), glyph->height());
+        drawn.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(drawn);
+        SkTextBlobBuilder builder;
+        builder.allocRun(font, 1, -glyph->left(), -glyph->top()).glyphs[0] = glyphID;
+        sk_sp<SkTextBlob> blob = builder.make();
+        canvas.drawTextBlob(blob, 0, 0, SkPaint());
+
+        // The glyph was drawn from its drawable, not from a mask or a path.
+        SkSurfaceProps props(0, kUnknown_SkPixelGeometry);
+        SkGlyphRunListPainter painter(props, kN32_SkColorType, nullptr,
+                                      SkStrikeCache::GlobalStrikeCache());
+        SkGlyphRunBuilder runBuilder;
+        GlyphCounter counter;
+        painter.drawForBitmapDevice(runBuilder.blobToGlyphRunList(*blob, {0, 0}), SkPaint(),
+                                    SkMatrix::I(), &counter);
+        REPORTER_ASSERT(r, counter.fDrawables == 1 && counter.fMasks == 0 && counter.fPaths == 0,
+                        "glyph %d: %zu drawables, %zu masks, %zu paths", glyphID,
+                        counter.fDrawables, counter.fMasks, counter.fPaths);
+
+        // SkOverdrawCanvas counts the bounds of the drawable as drawn once.
+        SkBitmap overdraw;
+        overdraw.allocN32Pixels(glyph->width(), glyph->height());
+        overdraw.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas overdrawTarget(overdraw);
+        SkOverdrawCanvas(&overdrawTarget).drawTextBlob(blob, 0, 0, SkPaint());
+        REPORTER_ASSERT(r, SkColorGetA(overdraw.getColor(glyph->width() / 2,
+                                                         glyph->height() / 2)) == 1);
+
+        // Edges are anti-aliased by different rasterizers, so allow a few pixels to differ.
+        int different = 0;
+        for (int y = 0; y < glyph->height(); ++y) {
+            for (int x = 0; x < glyph->width(); ++x) {
+                SkColor a = mask.getColor(x, y),
+                        b = drawn.getColor(x, y);
+                int diff = std::max({abs((int)SkColorGetA(a) - (int)SkColorGetA(b)),
+                                     abs((int)SkColorGetR(a) - (int)SkColorGetR(b)),
+                                     abs((int)SkColorGetG(a) - (int)SkColorGetG(b)),
+                                     abs((int)SkColorGetB(a) - (int)SkColorGetB(b))});
+                different += diff > 16;
+            }
+        }
+        REPORTER_ASSERT(r, different <= glyph->width() * glyph->height() / 50,
+                        "glyph %d: %d of %d pixels differ", glyphID, different,
+                        glyph->width() * glyph->height());
+    }
+}
+
+// A palette chosen when cloning a typeface is used to draw its color glyphs.
+DEF_TEST(DrawText_colorGlyphPalette, r) {
+    sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/more_samples-glyf_colr_1.ttf");
+    if (!typeface) {
+        return;
+    }
+    // Override every palette entry with green, so that every pixel drawn is green.
+    constexpr int kOverrideCount = 16;
+    SkFontArguments::Palette::Override overrides[kOverrideCount];
+    for (int i = 0; i < kOverrideCount; ++i) {
+        overrides[i] = {i, SK_ColorGREEN};
+    }
+    SkFontArguments args;
+    args.setPalette({0, overrides, kOverrideCount});
+    sk_sp<SkTypeface> green = typeface->makeClone(args);
+    REPORTER_ASSERT(r, green && green->uniqueID() != typeface->uniqueID());
+
+    auto draw = [](sk_sp<SkTypeface> typeface, SkBitmap* bitmap) {
+        bitmap->allocN32Pixels(120, 120);
+        bitmap->eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(*bitmap);
+        SkFont font(std::move(typeface), 50);
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        // The solid color composite and transform samples.
+        canvas.drawString("MN", 5, 55, font, SkPaint());
+        canvas.drawString("DE", 5, 110, font, SkPaint());
+    };
+    SkBitmap original, recolored;
+    draw(typeface, &original);
+    draw(green, &recolored);
+
+    int notGreen = 0, drawn = 0;
+    for (int y = 0; y < recolored.height(); ++y) {
+        for (int x = 0; x < recolored.width(); ++x) {
+            SkColor color = recolored.getColor(x, y);
+            drawn += SkColorGetA(color) != 0;
+            notGreen += SkColorGetR(color) != 0 || SkColorGetB(color) != 0;
+        }
+    }
+    REPORTER_ASSERT(r, drawn > 0);
+    REPORTER_ASSERT(r, notGreen == 0, "%d pixels are not green", notGreen);
+
+    // The original typeface still draws with its own palette.
+    bool originalHasOtherColors = false;
+    for (int y = 0; y < original.height(); ++y) {
+        for (int x = 0; x < original.width(); ++x) {
+            SkColor color = original.getColor(x, y);
+            originalHasOtherColors |= SkColorGetR(color) != 0 || SkColorGetB(color) != 0;
+        }
+    }
+    REPORTER_ASSERT(r, originalHasOtherColors);
+}
+
+// Draws glyph at (50, 150) into a 200x200 bitmap, and counts the pixels it draws outside of
+// bounds, which are relative to the origin.
+static int count_pixels_outside(const SkFont& font, SkGlyphID glyph, const SkRect& bounds) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(200, 200);
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(bitmap);
+    const SkPoint origin = {50, 150};
+    canvas.drawSimpleText(&glyph, sizeof(SkGlyphID), SkTextEncoding::kGlyphID,
+                          origin.x(), origin.y(), font, SkPaint());
+    const SkIRect deviceBounds = bounds.makeOffset(origin).roundOut();
+    int outside = 0;
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            outside += !deviceBounds.contains(x, y) && SkColorGetA(bitmap.getColor(x, y)) != 0;
+        }
+    }
+    return outside;
+}
+
+// Color glyph bounds are kept by the typeface in font units, so they must not depend on which
+// strike measured a glyph first, and must still contain everything the glyph draws.
+DEF_TEST(DrawText_colorGlyphBounds, r) {
+    sk_sp<SkTypeface> cold = MakeResourceAsTypeface("fonts/more_samples-glyf_colr_1.ttf");
+    sk_sp<SkTypeface> warm = MakeResourceAsTypeface("fonts/more_samples-glyf_colr_1.ttf");
+    if (!cold || !warm) {
+        return;
+    }
+    const int glyphCount = std::min(cold->countGlyphs(), 64);
+    std::vector<SkGlyphID> glyphs(glyphCount);
+    for (int i = 0; i < glyphCount; ++i) {
+        glyphs[i] = SkTo<SkGlyphID>(i);
+    }
+    std::vector<SkRect> coldBounds(glyphCount), warmBounds(glyphCount);
+    SkFont(warm, 13).getBounds(glyphs.data(), glyphCount, warmBounds.data(), nullptr);
+
+    SkFont coldFont(cold, 50), warmFont(warm, 50);
+    coldFont.setEdging(SkFont::Edging::kAntiAlias);
+    coldFont.getBounds(glyphs.data(), glyphCount, coldBounds.data(), nullptr);
+    warmFont.getBounds(glyphs.data(), glyphCount, warmBounds.data(), nullptr);
+    for (int i = 0; i < glyphCount; ++i) {
+        REPORTER_ASSERT(r, coldBounds[i] == warmBounds[i], "glyph %d", i);
+    }
+
+    for (int i = 0; i < glyphCount; ++i) {
+        if (coldBounds[i].isEmpty()) {
+            continue;
+        }
+        const int outside = count_pixels_outside(coldFont, glyphs[i], coldBounds[i]);
+        REPORTER_ASSERT(r, outside == 0, "glyph %d draws %d pixels outside its bounds", i,
+                        outside);
+    }
+}
+
+// Conservative bounds of color glyphs are not rounded out to pixels, but still contain what is
+// drawn.
+DEF_TEST(DrawText_colorGlyphConservativeBounds, r) {
+    sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/more_samples-glyf_colr_1.ttf");
+    if (!typeface) {
+        return;
+    }
+    const int glyphCount = std::min(typeface->countGlyphs(), 64);
+    std::vector<SkGlyphID> glyphs(glyphCount);
+    for (int i = 0; i < glyphCount; ++i) {
+        glyphs[i] = SkTo<SkGlyphID>(i);
+    }
+    SkFont font(typeface, 50);
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    std::vector<SkRect> conservativeBounds(glyphCount), bounds(glyphCount);
+    font.getConservativeBounds(glyphs.data(), glyphCount, conservativeBounds.data());
+    font.getBounds(glyphs.data(), glyphCount, bounds.data(), nullptr);
+
+    int tighter = 0;
+    for (int i = 0; i < glyphCount; ++i) {
+        if (conservativeBounds[i].isEmpty()) {
+            continue;
+        }
+        REPORTER_ASSERT(r, bounds[i].contains(conservativeBounds[i]), "glyph %d", i);
+        tighter += bounds[i] != conservativeBounds[i];
+
+        const int outside = count_pixels_outside(font, glyphs[i], conservativeBounds[i]);
+        REPORTER_ASSERT(r, outside == 0, "glyph %d draws %d pixels outside its bounds", i,
+                        outside);
+    }
+    REPORTER_ASSERT(r, tighter > 0);
+}
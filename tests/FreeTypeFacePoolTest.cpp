@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkFont.h"
+#include "include/ports/SkTypeface_freetype.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkGlyph.h"
+#include "src/core/SkScalerContext.h"
+#include "src/core/SkStrikeSpec.h"
+#include "src/core/SkTaskGroup.h"
+#include "tests/FreeTypeTestTypeface.h"
+#include "tests/Test.h"
+#include "tools/Resources.h"
+
+#include <vector>
+
+namespace {
+
+using Contexts = std::vector<std::unique_ptr<SkScalerContext>>;
+
+Contexts make_contexts(sk_sp<SkTypeface> typeface, SkSpan<const SkScalar> sizes) {
+    Contexts contexts;
+    for (SkScalar size : sizes) {
+        SkFont font(typeface, size);
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        contexts.push_back(SkStrikeSpec::MakeWithNoDevice(font).createScalerContext());
+    }
+    return contexts;
+}
+
+// Rasterizes the same glyphs with each context, each context on a thread of the executor.
+// Returns the dimensions and pixels of the glyphs of each context.
+std::vector<std::vector<uint8_t>> rasterize(const Contexts& contexts, SkExecutor& executor) {
+    static constexpr SkGlyphID kGlyphs[] = {36, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79};
+    std::vector<std::vector<uint8_t>> images(contexts.size());
+    SkTaskGroup(executor).batch(SkToInt(contexts.size()), [&](int i) {
+        SkArenaAlloc alloc(4096);
+        for (SkGlyphID glyphID : kGlyphs) {
+            SkGlyph glyph = contexts[i]->makeGlyph(SkPackedGlyphID{glyphID});
+            const uint16_t dimensions[] = {glyph.width(), glyph.height()};
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(dimensions);
+            images[i].insert(images[i].end(), bytes, bytes + sizeof(dimensions));
+            if (glyph.setImage(&alloc, contexts[i].get())) {
+                const uint8_t* image = static_cast<const uint8_t*>(glyph.image());
+                images[i].insert(images[i].end(), image, image + glyph.imageSize());
+            }
+        }
+    });
+    return images;
+}
+
+}  // namespace
+
+DEF_TEST(FreeTypeFacePool, r) {
+    sk_sp<SkData> data = GetResourceAsData("fonts/Roboto-Regular.ttf");
+    if (!data) {
+        ERRORF(r, "Could not load font.");
+        return;
+    }
+    sk_sp<FreeTypeTestTypeface> typeface = sk_make_sp<FreeTypeTestTypeface>(std::move(data));
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    const SkScalar sizes[] = {9, 12, 16, 23, 31, 40};
+    int open, idle;
+
+    // The pool is off by default, and every context shares the typeface's face.
+    Contexts contexts = make_contexts(typeface, SkMakeSpan(sizes));
+    const std::vector<std::vector<uint8_t>> expected = rasterize(contexts, *executor);
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 0 && idle == 0, "open %d idle %d", open, idle);
+    contexts.clear();
+
+    // With three faces, two contexts get pooled faces and the rest share. The limits are set on
+    // this typeface alone, so neither other tests nor other typefaces interfere.
+    typeface->setFacePoolLimits(3, SIZE_MAX);
+    contexts = make_contexts(typeface, SkMakeSpan(sizes));
+    REPORTER_ASSERT(r, rasterize(contexts, *executor) == expected);
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 2 && idle == 0, "open %d idle %d", open, idle);
+    REPORTER_ASSERT(r, SkTypeface_GetFreeTypeFacePoolBytesUsed() > 0);
+    contexts.clear();
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 2 && idle == 2, "open %d idle %d", open, idle);
+
+    // Later contexts reuse the idle faces instead of opening more.
+    contexts = make_contexts(typeface, SkMakeSpan(sizes));
+    REPORTER_ASSERT(r, rasterize(contexts, *executor) == expected);
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 2 && idle == 0, "open %d idle %d", open, idle);
+
+    // Faces over a lowered limit are closed when they are returned.
+    typeface->setFacePoolLimits(2, SIZE_MAX);
+    contexts.clear();
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 1 && idle == 1, "open %d idle %d", open, idle);
+
+    // Over the byte limit no more faces are opened, and returned faces are closed.
+    typeface->setFacePoolLimits(3, 1);
+    contexts = make_contexts(typeface, SkMakeSpan(sizes));
+    REPORTER_ASSERT(r, rasterize(contexts, *executor) == expected);
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 1 && idle == 0, "open %d idle %d", open, idle);
+    contexts.clear();
+    typeface->getFacePoolCounts(&open, &idle);
+    REPORTER_ASSERT(r, open == 0 && idle == 0, "open %d idle %d", open, idle);
+}
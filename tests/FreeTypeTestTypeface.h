@@ -0,0 +1,43 @@
+/*
+ * Copyright 2021 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef FreeTypeTestTypeface_DEFINED
+#define FreeTypeTestTypeface_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkStream.h"
+#include "src/core/SkFontDescriptor.h"
+#include "src/ports/SkFontHost_FreeType_common.h"
+
+// A FreeType typeface of its own, whatever the platform's font manager makes, so tests can reach
+// into SkTypeface_FreeType and its caches only see what the test does.
+class FreeTypeTestTypeface : public SkTypeface_FreeType {
+public:
+    explicit FreeTypeTestTypeface(sk_sp<SkData> data)
+        : SkTypeface_FreeType(SkFontStyle(), false), fData(std::move(data)) {}
+
+protected:
+    std::unique_ptr<SkStreamAsset> onOpenStream(int* ttcIndex) const override {
+        *ttcIndex = 0;
+        return SkMemoryStream::Make(fData);
+    }
+    std::unique_ptr<SkFontData> onMakeFontData() const override {
+        return std::make_unique<SkFontData>(SkMemoryStream::Make(fData), 0, nullptr, 0);
+    }
+    sk_sp<SkTypeface> onMakeClone(const SkFontArguments&) const override {
+        return sk_ref_sp(this);
+    }
+    void onGetFamilyName(SkString* familyName) const override { *familyName = "FreeTypeTest"; }
+    void onGetFontDescriptor(SkFontDescriptor*, bool* isLocal) const override {
+        *isLocal = true;
+    }
+
+private:
+    sk_sp<SkData> fData;
+};
+
+#endif
@@ -13,11 +13,17 @@
 #include "include/effects/SkGradientShader.h"
 #include "include/private/SkTemplates.h"
 #include "src/core/SkMatrixProvider.h"
+#include "src/core/SkRasterPipeline.h"
 #include "src/core/SkTLazy.h"
 #include "src/gpu/GrColorInfo.h"
 #include "src/shaders/SkColorShader.h"
+#include "src/shaders/gradients/SkGradientTable.h"
 #include "tests/Test.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 // https://code.google.com/p/chromium/issues/detail?id=448299
 // Giant (inverse) matrix causes overflow when converting/computing using 32.32
 // Before the fix, we would assert (and then crash).
@@ -585,3 +591,137 @@ DEF_TEST(Gradient, reporter) {
     test_sweep_fuzzer(reporter);
     test_unsorted_degenerate(reporter);
 }
+
+// Gradients with many unevenly spaced stops look their interval up in an index rather than
+// comparing t with every stop. Check that it finds the same intervals, hard stops included.
+DEF_TEST(Gradient_indexedStops, reporter) {
+    constexpr int kStopCount = 40;
+    SkPMColor4f colors[kStopCount];
+    SkScalar pos[kStopCount];
+    SkScalar t = 0;
+    for (int i = 0; i < kStopCount; ++i) {
+        colors[i] = {(i % 3) / 2.0f, (i % 5) / 4.0f, (i % 7) / 6.0f, 1};
+        pos[i] = t;
+        // Uneven gaps, with hard stops after every fifth stop.
+        t += i % 5 == 4 ? 0 : 0.01f + (i % 3) * 0.015f;
+    }
+    pos[kStopCount - 1] = 1;
+
+    sk_sp<const SkGradientTable> table = SkGradientTable::Make(colors, pos, kStopCount, true);
+    REPORTER_ASSERT(reporter, table);
+    REPORTER_ASSERT(reporter, table->stage() == SkRasterPipeline::indexed_gradient);
+
+    auto expected = [&](float t, int channel) {
+        int i = 0;
+        while (i + 1 < kStopCount && pos[i + 1] <= t) {
+            ++i;
+        }
+        if (i + 1 == kStopCount || t < pos[0]) {
+            return colors[i][channel];
+        }
+        float f = (t - pos[i]) / (pos[i + 1] - pos[i]);
+        return colors[i][channel] + f * (colors[i + 1][channel] - colors[i][channel]);
+    };
+
+    // t in r, from below 0 to above 1, and exactly at each stop.
+    constexpr int kCount = 512;
+    float rgba[kCount + kStopCount][4] = {};
+    for (int i = 0; i < kCount; ++i) {
+        rgba[i][0] = -0.25f + 1.5f * i / (kCount - 1);
+    }
+    for (int i = 0; i < kStopCount; ++i) {
+        rgba[kCount + i][0] = pos[i];
+    }
+
+    SkRasterPipeline_MemoryCtx ctx = { rgba, 0 };
+    SkRasterPipeline_<256> p;
+    p.append(SkRasterPipeline::load_f32, &ctx);
+    table->appendStages(&p);
+    p.append(SkRasterPipeline::store_f32, &ctx);
+    std::vector<float> ts;
+    for (const auto& px : rgba) {
+        ts.push_back(px[0]);
+    }
+    p.run(0,0, SK_ARRAY_COUNT(rgba),1);
+
+    for (size_t i = 0; i < ts.size(); ++i) {
+        for (int c = 0; c < 4; ++c) {
+            float want = expected(ts[i], c);
+            if (std::abs(rgba[i][c] - want) > 1e-4f) {
+                ERRORF(reporter, "t %g channel %d: want %g, got %g", ts[i], c, want, rgba[i][c]);
+            }
+        }
+    }
+
+    // NaN and infinite t only have to stay within the table.
+    float nonFinite[3][4] = {{SK_FloatNaN}, {SK_FloatInfinity}, {SK_FloatNegativeInfinity}};
+    ctx = { nonFinite, 0 };
+    p.run(0,0, 3,1);
+
+    // t from below 0 to above 1 again, at pixel centers, through an 8888 pipeline. Builds with
+    // lowp stages run this one in lowp, where t comes from x rather than r.
+    const float matrix[] = {1.5f / kCount, 0, -0.25f, 0};
+    uint32_t pixels[kCount] = {};
+    SkRasterPipeline_MemoryCtx dst = { pixels, 0 };
+    SkRasterPipeline_<256> lowp;
+    lowp.append(SkRasterPipeline::seed_shader);
+    lowp.append(SkRasterPipeline::matrix_scale_translate, matrix);
+    table->appendStages(&lowp);
+    lowp.append(SkRasterPipeline::store_8888, &dst);
+    lowp.run(0,0, kCount,1);
+
+    for (int i = 0; i < kCount; ++i) {
+        // The stage may round t differently, which only matters right at a hard stop.
+        const float t = (i + 0.5f) * matrix[0] + matrix[2];
+        auto atStop = [&](float stop) { return std::abs(t - stop) < 1e-5f; };
+        if (std::any_of(pos, pos + kStopCount, atStop)) {
+            continue;
+        }
+        for (int c = 0; c < 4; ++c) {
+            const int want = (int)std::lround(expected(t, c) * 255),
+                      got  = (pixels[i] >> (8 * c)) & 0xff;
+            if (std::abs(got - want) > 1) {
+                ERRORF(reporter, "lowp t %g channel %d: want %d, got %d", t, c, want, got);
+            }
+        }
+    }
+}
+
+// Sweeps over part of a turn find t in one stage, with a bounded error in the angle.
+DEF_TEST(Gradient_sweepWindow, reporter) {
+    // The window from 45 to 225 degrees.
+    const float window[] = { 2, -0.25f };
+
+    // The last point is the center, which has no angle and is drawn as if at 0 degrees.
+    constexpr int kCount = 256;
+    float rgba[kCount + 1][4] = {};
+    for (int i = 0; i < kCount; ++i) {
+        const float angle = 2 * SK_FloatPI * i / kCount;
+        const float radius = 0.5f + (i % 7) * 100;
+        rgba[i][0] = radius * std::cos(angle);
+        rgba[i][1] = radius * std::sin(angle);
+    }
+    std::vector<std::pair<float, float>> xys;
+    for (const auto& px : rgba) {
+        xys.push_back({px[0], px[1]});
+    }
+
+    SkRasterPipeline_MemoryCtx ctx = { rgba, 0 };
+    SkRasterPipeline_<256> p;
+    p.append(SkRasterPipeline::load_f32, &ctx);
+    p.append(SkRasterPipeline::xy_to_sweep_window, window);
+    p.append(SkRasterPipeline::store_f32, &ctx);
+    p.run(0,0, SK_ARRAY_COUNT(rgba),1);
+
+    for (size_t i = 0; i < xys.size(); ++i) {
+        auto [x, y] = xys[i];
+        float turns = std::atan2(y, x) / (2 * SK_FloatPI);
+        if (turns < 0) {
+            turns += 1;
+        }
+        const float want = turns * window[0] + window[1];
+        if (std::abs(rgba[i][0] - want) > 2.7e-5f * window[0] + 1e-6f) {
+            ERRORF(reporter, "(%g, %g): want %g, got %g", x, y, want, rgba[i][0]);
+        }
+    }
+}
@@ -70,3 +70,20 @@ DEF_TEST(LRUCacheRandom, r) {
     }
     REPORTER_ASSERT(r, 0 == instances);
 }
+
+DEF_TEST(LRUCacheRemoveLeastRecentlyUsed, r) {
+    int instances = 0;
+    {
+        SkLRUCache<int, std::unique_ptr<Value>> test(10);
+        for (int i = 1; i <= 3; i++) {
+            test.insert(i, std::make_unique<Value>(i, &instances));
+        }
+        test.find(1);
+        std::unique_ptr<Value> removed = test.removeLeastRecentlyUsed();
+        REPORTER_ASSERT(r, removed->fValue == 2);
+        REPORTER_ASSERT(r, !test.find(2));
+        REPORTER_ASSERT(r, 2 == test.count());
+        REPORTER_ASSERT(r, 3 == instances);
+    }
+    REPORTER_ASSERT(r, 0 == instances);
+}
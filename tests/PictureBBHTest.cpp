@@ -7,9 +7,14 @@
 
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkPictureRecorder.h"
+#include "include/effects/SkGradientShader.h"
+#include "include/effects/SkImageFilters.h"
+#include "include/utils/SkRandom.h"
+#include "include/utils/SkTiledPicturePlayback.h"
 #include "src/core/SkRectPriv.h"
 
 #include "tests/Test.h"
@@ -122,3 +127,108 @@ DEF_TEST(PictureNegativeSpace, r) {
         REPORTER_ASSERT(r, pic->cullRect() == (SkRect{-20,-20,-10,-10}));
     }
 }
+
+DEF_TEST(PictureBBH_tiledPlayback, r) {
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(400, 300), &factory);
+    // Clipping to a tile can move the edges of paths by a pixel, as any clip can, so this sticks
+    // to rectangles, which rasterize the same whatever the clip.
+    SkRandom rand;
+    for (int i = 0; i < 300; i++) {
+        const SkRect rect = SkRect::MakeXYWH(rand.nextRangeScalar(-20, 400),
+                                             rand.nextRangeScalar(-20, 300),
+                                             rand.nextRangeScalar(1, 80),
+                                             rand.nextRangeScalar(1, 80));
+        SkPaint paint;
+        paint.setColor(rand.nextU() | 0x40000000);
+        switch (i % 3) {
+            case 0: canvas->drawRect(rect, paint); break;
+            case 1: {
+                // Dithered gradients show whether tiles keep their device coordinates.
+                const SkPoint pts[] = {{rect.fLeft, rect.fTop}, {rect.fRight, rect.fBottom}};
+                const SkColor colors[] = {rand.nextU(), rand.nextU()};
+                paint.setShader(SkGradientShader::MakeLinear(pts, colors, nullptr, 2,
+                                                             SkTileMode::kClamp));
+                paint.setDither(true);
+                canvas->drawRect(rect, paint);
+            } break;
+            case 2: {
+                canvas->saveLayerAlpha(&rect, 0x80);
+                canvas->drawRect(rect.makeInset(rect.width()/4, 0), paint);
+                paint.setBlendMode(SkBlendMode::kXor);
+                canvas->drawRect(rect.makeInset(0, rect.height()/4), paint);
+                canvas->restore();
+            } break;
+        }
+    }
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    // Tiles that do not divide the pixels evenly, and a matrix that moves some of the picture
+    // off the pixels.
+    SkMatrix matrix = SkMatrix::Scale(0.9f, 1.1f);
+    matrix.postTranslate(-7.5f, 3.25f);
+    SkBitmap expected, tiled;
+    expected.allocN32Pixels(301, 197);
+    tiled.allocN32Pixels(301, 197);
+    expected.eraseColor(SK_ColorWHITE);
+    {
+        SkCanvas direct(expected);
+        direct.concat(matrix);
+        picture->playback(&direct);
+    }
+
+    std::unique_ptr<SkExecutor> pool = SkExecutor::MakeFIFOThreadPool(4);
+    for (SkExecutor* executor : {&SkExecutor::GetDefault(), pool.get()}) {
+        for (int tileSize : {64, 100, 1000}) {
+            tiled.eraseColor(SK_ColorWHITE);
+            REPORTER_ASSERT(r, SkTiledPicturePlayback::Draw(tiled.pixmap(), picture.get(),
+                                                            &matrix, *executor, tileSize));
+            REPORTER_ASSERT(r, !memcmp(expected.getPixels(), tiled.getPixels(),
+                                       expected.computeByteSize()),
+                            "tile size %d", tileSize);
+        }
+    }
+
+    // Canvases cannot draw into pixmaps without pixels.
+    SkPixmap empty(tiled.info(), nullptr, tiled.rowBytes());
+    REPORTER_ASSERT(r, !SkTiledPicturePlayback::Draw(empty, picture.get(), nullptr,
+                                                     SkExecutor::GetDefault()));
+}
+
+// A backdrop filter reads pixels across tile edges, so pictures with one, even nested in another
+// picture, are not split into tiles.
+DEF_TEST(PictureBBH_tiledPlaybackBackdrop, r) {
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(200, 200));
+    for (int i = 0; i < 10; ++i) {
+        SkPaint paint;
+        paint.setColor(i % 2 ? SK_ColorRED : SK_ColorBLUE);
+        canvas->drawRect(SkRect::MakeXYWH(i * 20, 0, 10, 200), paint);
+    }
+    sk_sp<SkImageFilter> blur = SkImageFilters::Blur(8, 8, nullptr);
+    const SkRect layerBounds = SkRect::MakeLTRB(30, 30, 170, 170);
+    canvas->saveLayer(SkCanvas::SaveLayerRec(&layerBounds, nullptr, blur.get(), 0));
+    canvas->restore();
+    sk_sp<SkPicture> inner = recorder.finishRecordingAsPicture();
+
+    canvas = recorder.beginRecording(SkRect::MakeWH(200, 200));
+    canvas->drawPicture(inner);
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    SkBitmap expected, tiled;
+    expected.allocN32Pixels(200, 200);
+    tiled.allocN32Pixels(200, 200);
+    expected.eraseColor(SK_ColorWHITE);
+    {
+        SkCanvas direct(expected);
+        picture->playback(&direct);
+    }
+
+    std::unique_ptr<SkExecutor> pool = SkExecutor::MakeFIFOThreadPool(4);
+    tiled.eraseColor(SK_ColorWHITE);
+    REPORTER_ASSERT(r, SkTiledPicturePlayback::Draw(tiled.pixmap(), picture.get(), nullptr,
+                                                    *pool, 64));
+    REPORTER_ASSERT(r, !memcmp(expected.getPixels(), tiled.getPixels(),
+                               expected.computeByteSize()));
+}
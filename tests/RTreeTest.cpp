@@ -89,3 +89,43 @@ DEF_TEST(RTree, reporter) {
                                   expectedDepthMax >= rtree.getDepth());
     }
 }
+
+DEF_TEST(RTree_queryEdges, reporter) {
+    // Enough rects for a few levels, with the last node not full, and some empty ones, which are
+    // never found.
+    std::vector<SkRect> rects;
+    for (int i = 0; i < 130; ++i) {
+        const float x = SkIntToScalar(i % 13) * 10,
+                    y = SkIntToScalar(i / 13) * 10;
+        rects.push_back(i % 7 == 3 ? SkRect::MakeXYWH(x, y, 0, 10)
+                                   : SkRect::MakeXYWH(x, y, 10, 10));
+    }
+    SkRTree rtree;
+    rtree.insert(rects.data(), (int)rects.size());
+
+    auto expect = [&](const SkRect& query) {
+        std::vector<int> expected, found;
+        for (int i = 0; i < (int)rects.size(); ++i) {
+            if (SkRect::Intersects(query, rects[i])) {
+                expected.push_back(i);
+            }
+        }
+        rtree.search(query, &found);
+        return found == expected;
+    };
+    // Rects which only share an edge do not intersect.
+    REPORTER_ASSERT(reporter, expect(SkRect::MakeLTRB(20, 20, 30, 30)));
+    REPORTER_ASSERT(reporter, expect(SkRect::MakeLTRB(29.5f, 29.5f, 30.5f, 30.5f)));
+    REPORTER_ASSERT(reporter, expect(SkRect::MakeLTRB(-SK_ScalarInfinity, -SK_ScalarInfinity,
+                                                      SK_ScalarInfinity, SK_ScalarInfinity)));
+    REPORTER_ASSERT(reporter, expect(SkRect::MakeLTRB(125, 85, SK_ScalarInfinity, 95)));
+    REPORTER_ASSERT(reporter, expect(SkRect::MakeLTRB(40, 40, 30, 50)));
+    REPORTER_ASSERT(reporter, expect(SkRect::MakeLTRB(1000, 0, 1010, 10)));
+
+    // A single rect still makes a tree one node deep.
+    SkRTree single;
+    single.insert(&rects[5], 1);
+    std::vector<int> found;
+    single.search(SkRect::MakeLTRB(55, 5, 56, 6), &found);
+    REPORTER_ASSERT(reporter, single.getDepth() == 1 && found == std::vector<int>{0});
+}
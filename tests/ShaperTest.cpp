@@ -15,7 +15,9 @@
 #include "modules/skshaper/include/SkShaper.h"
 #include "tools/Resources.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 
 namespace {
@@ -95,6 +97,72 @@ void cluster_test(skiatest::Reporter* reporter, const char* resource) {
 
 DEF_TEST(Shaper_cluster_empty, r) { shaper_test(r, "empty", SkData::MakeEmpty().get()); }
 
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+// The HarfBuzz caches are shared by every shaper, so tests which change them run on their own.
+DEF_SERIAL_TEST(Shaper_harfBuzzCacheStats, r) {
+    auto shaper = SkShaper::MakeShapeThenWrap();
+    sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/Em.ttf");
+    if (!shaper || !typeface) {
+        return;
+    }
+    SkShaper::SetHarfBuzzCacheCapacity(50);
+    REPORTER_ASSERT(r, SkShaper::GetHarfBuzzCacheStats().fCapacity == 50);
+
+    constexpr char kText[] = "Em";
+    RunHandler rh("Em", r);
+    SkShaper::HarfBuzzCacheStats before = SkShaper::GetHarfBuzzCacheStats();
+    shaper->shape(kText, strlen(kText), SkFont(typeface, 12), true, 400, &rh);
+    SkShaper::HarfBuzzCacheStats missed = SkShaper::GetHarfBuzzCacheStats();
+    REPORTER_ASSERT(r, missed.fMisses > before.fMisses);
+    REPORTER_ASSERT(r, missed.fFaceCount >= 1);
+
+    // Another size needs another HarfBuzz font, but reuses the face.
+    shaper->shape(kText, strlen(kText), SkFont(typeface, 13), true, 400, &rh);
+    SkShaper::HarfBuzzCacheStats sized = SkShaper::GetHarfBuzzCacheStats();
+    REPORTER_ASSERT(r, sized.fHits > missed.fHits);
+
+    // The same font again is found in the cache of this thread.
+    shaper->shape(kText, strlen(kText), SkFont(typeface, 13), true, 400, &rh);
+    REPORTER_ASSERT(r, SkShaper::GetHarfBuzzCacheStats().fFontHits > sized.fFontHits);
+
+    // Purging drops the fonts of this thread as well, so the face is made again.
+    SkShaper::PurgeHarfBuzzCache();
+    SkShaper::HarfBuzzCacheStats purged = SkShaper::GetHarfBuzzCacheStats();
+    shaper->shape(kText, strlen(kText), SkFont(typeface, 13), true, 400, &rh);
+    REPORTER_ASSERT(r, SkShaper::GetHarfBuzzCacheStats().fMisses > purged.fMisses);
+
+    SkShaper::SetHarfBuzzCacheCapacity(100);
+}
+
+DEF_SERIAL_TEST(Shaper_harfBuzzShapeCache, r) {
+    auto shaper = SkShaper::MakeShapeThenWrap();
+    auto data = GetResourceAsData("text/english.txt");
+    if (!shaper || !data) {
+        return;
+    }
+    SkShaper::SetHarfBuzzShapeCacheLimit(1 << 20);
+    SkFont font(SkTypeface::MakeDefault(), 17);
+
+    RunHandler shaped("shaped", r), replayed("replayed", r);
+    shaper->shape((const char*)data->data(), data->size(), font, true, 400, &shaped);
+    SkShaper::HarfBuzzCacheStats before = SkShaper::GetHarfBuzzCacheStats();
+    shaper->shape((const char*)data->data(), data->size(), font, true, 400, &replayed);
+    SkShaper::HarfBuzzCacheStats after = SkShaper::GetHarfBuzzCacheStats();
+    REPORTER_ASSERT(r, after.fShapeHits > before.fShapeHits);
+    REPORTER_ASSERT(r, after.fShapeBytesUsed > 0);
+
+    REPORTER_ASSERT(r, shaped.fGlyphCount == replayed.fGlyphCount);
+    for (unsigned i = 0; i < std::min(shaped.fGlyphCount, replayed.fGlyphCount); ++i) {
+        REPORTER_ASSERT(r, shaped.fGlyphs[i] == replayed.fGlyphs[i]);
+        REPORTER_ASSERT(r, shaped.fPositions[i] == replayed.fPositions[i]);
+        REPORTER_ASSERT(r, shaped.fClusters[i] == replayed.fClusters[i]);
+    }
+
+    SkShaper::SetHarfBuzzShapeCacheLimit(0);
+    REPORTER_ASSERT(r, SkShaper::GetHarfBuzzCacheStats().fShapeBytesUsed == 0);
+}
+#endif
+
 #define SHAPER_TEST(X) DEF_TEST(Shaper_cluster_ ## X, r) { cluster_test(r, "text/" #X ".txt"); }
 SHAPER_TEST(arabic)
 SHAPER_TEST(armenian)
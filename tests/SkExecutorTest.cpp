@@ -0,0 +1,85 @@
+/*
+ * Copyright 2021 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkExecutor.h"
+#include "src/core/SkTaskGroup.h"
+#include "tests/Test.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+DEF_TEST(SkExecutor_batch, r) {
+    std::unique_ptr<SkExecutor> pools[] = {
+        SkExecutor::MakeFIFOThreadPool(4),
+        SkExecutor::MakeLIFOThreadPool(4),
+        SkExecutor::MakeWorkStealingThreadPool(4),
+        nullptr,  // The default executor.
+    };
+    for (const auto& pool : pools) {
+        SkExecutor& executor = pool ? *pool : SkExecutor::GetDefault();
+        for (int N : {0, 1, 3, 1000}) {
+            std::unique_ptr<std::atomic<int>[]> calls(new std::atomic<int>[N]);
+            for (int i = 0; i < N; i++) {
+                calls[i] = 0;
+            }
+            SkTaskGroup tg(executor);
+            tg.batch(N, [&](int i) { calls[i]++; });
+            tg.parallelFor(N, [&](int i) { calls[i]++; });
+            tg.wait();
+            for (int i = 0; i < N; i++) {
+                REPORTER_ASSERT(r, calls[i] == 2, "index %d of %d called %d times",
+                                i, N, calls[i].load());
+            }
+        }
+    }
+}
+
+// batch() makes a task per index, so its calls may wait for each other, even when the pool has
+// more threads than the machine.
+DEF_TEST(SkExecutor_batchCallsAreConcurrent, r) {
+    constexpr int kThreadCount = 4;
+    std::unique_ptr<SkExecutor> pool = SkExecutor::MakeFIFOThreadPool(kThreadCount);
+    std::atomic<int> arrived{0};
+    SkTaskGroup tg(*pool);
+    tg.batch(kThreadCount, [&](int) {
+        arrived++;
+        while (arrived.load() < kThreadCount) {
+            std::this_thread::yield();
+        }
+    });
+    tg.wait();
+    REPORTER_ASSERT(r, arrived.load() == kThreadCount);
+}
+
+// Tasks which add tasks and wait for them, as nested SkTaskGroups do, must neither deadlock nor
+// lose work on a work stealing pool.
+static int sum_below(SkExecutor& executor, int n) {
+    if (n < 8) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += i;
+        }
+        return sum;
+    }
+    int half[2];
+    SkTaskGroup tg(executor);
+    tg.add([&] { half[0] = sum_below(executor, n / 2); });
+    tg.add([&] {
+        half[1] = sum_below(executor, n - n / 2);
+        half[1] += (n - n / 2) * (n / 2);
+    });
+    tg.wait();
+    return half[0] + half[1];
+}
+
+DEF_TEST(SkExecutor_workStealingNested, r) {
+    std::unique_ptr<SkExecutor> pool = SkExecutor::MakeWorkStealingThreadPool(4);
+    for (int n : {1, 100, 5000}) {
+        REPORTER_ASSERT(r, sum_below(*pool, n) == n * (n - 1) / 2);
+    }
+}
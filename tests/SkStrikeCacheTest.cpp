@@ -5,9 +5,16 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkExecutor.h"
+#include "include/core/SkStream.h"
+#include "include/private/SkTHash.h"
+#include "src/core/SkGlyphRunPainter.h"
+#include "src/core/SkOSFile.h"
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkStrikeSpec.h"
+#include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
+#include "tools/Resources.h"
 #include "tools/ToolUtils.h"
 
 DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
@@ -51,3 +58,159 @@ DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
 
 
 }
+
+DEF_TEST(SkStrikeCache_Prewarm, Reporter) {
+    SkStrikeCache cache;
+
+    sk_sp<SkTypeface> typeface =
+            ToolUtils::create_portable_typeface("serif", SkFontStyle::Italic());
+
+    SkFont font;
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    font.setTypeface(typeface);
+
+    SkPaint defaultPaint;
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, defaultPaint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+
+    SkGlyphID glyphIDs[100];
+    for (int i = 0; i < 100; i++) {
+        glyphIDs[i] = font.unicharToGlyph(' ' + (i % 95));
+    }
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+    cache.prewarm(strikeSpec, SkMakeSpan(glyphIDs), *executor);
+
+    sk_sp<SkStrike> strike = strikeSpec.findOrCreateStrike(&cache);
+    // Repeated glyphs are only added once.
+    SkTHashSet<SkGlyphID> uniqueGlyphIDs;
+    for (SkGlyphID glyphID : glyphIDs) {
+        uniqueGlyphIDs.add(glyphID);
+    }
+    REPORTER_ASSERT(Reporter, strike->fScalerCache.countCachedGlyphs() == uniqueGlyphIDs.count());
+
+    // The prewarmed images match the ones the strike makes itself.
+    SkStrikeCache reference;
+    sk_sp<SkStrike> referenceStrike = strikeSpec.findOrCreateStrike(&reference);
+    for (SkGlyphID glyphID : glyphIDs) {
+        SkPackedGlyphID packedID{glyphID};
+        const SkGlyph* glyph;
+        const SkGlyph* referenceGlyph;
+        strike->prepareImages(SkMakeSpan(&packedID, 1), &glyph);
+        referenceStrike->prepareImages(SkMakeSpan(&packedID, 1), &referenceGlyph);
+        REPORTER_ASSERT(Reporter, glyph->iRect() == referenceGlyph->iRect());
+        REPORTER_ASSERT(Reporter, glyph->imageSize() == referenceGlyph->imageSize());
+        REPORTER_ASSERT(Reporter,
+                        glyph->imageSize() == 0 ||
+                        !memcmp(glyph->image(), referenceGlyph->image(), glyph->imageSize()));
+    }
+}
+
+DEF_TEST(SkStrikeCache_PrewarmSkipsLargeGlyphs, Reporter) {
+    SkStrikeCache cache;
+
+    sk_sp<SkTypeface> typeface =
+            ToolUtils::create_portable_typeface("serif", SkFontStyle::Italic());
+
+    // At this size the glyph is drawn as a path, so prewarming its image would be wasted.
+    SkFont font(typeface, 512);
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+
+    SkGlyphID glyphID = font.unicharToGlyph('M');
+    auto executor = SkExecutor::MakeFIFOThreadPool(2);
+    cache.prewarm(strikeSpec, SkMakeSpan(&glyphID, 1), *executor);
+
+    sk_sp<SkStrike> strike = strikeSpec.findOrCreateStrike(&cache);
+    REPORTER_ASSERT(Reporter, strike->fScalerCache.countCachedGlyphs() == 1);
+    const SkGlyph* glyph;
+    strike->metrics(SkMakeSpan(&glyphID, 1), &glyph);
+    REPORTER_ASSERT(Reporter, glyph->maxDimension() > SkStrikeCommon::kSkSideTooBigForAtlas);
+    REPORTER_ASSERT(Reporter, !glyph->setImageHasBeenCalled());
+}
+
+DEF_TEST(SkStrikeCache_DiskCache, Reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    SkString dir = SkOSPath::Join(tmpDir.c_str(), "glyph_disk_cache");
+    sk_sp<SkGlyphDiskCache> diskCache = SkGlyphDiskCache::Make(dir.c_str());
+    REPORTER_ASSERT(Reporter, diskCache);
+
+    // The font data is part of the key, so the typeface must have some.
+    sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/Roboto-Regular.ttf");
+    if (!typeface) {
+        return;
+    }
+    SkFont font(typeface, 24);
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+
+    SkGlyphID glyphIDs[26];
+    SkPackedGlyphID packedIDs[26];
+    for (int i = 0; i < 26; i++) {
+        glyphIDs[i] = font.unicharToGlyph('a' + i);
+        packedIDs[i] = SkPackedGlyphID{glyphIDs[i]};
+    }
+
+    SkStrikeCache cache;
+    cache.setDiskCache(diskCache);
+    sk_sp<SkStrike> strike = strikeSpec.findOrCreateStrike(&cache);
+    const SkGlyph* glyphs[26];
+    const SkGlyph* paths[26];
+    strike->prepareImages(SkMakeSpan(packedIDs), glyphs);
+    strike->preparePaths(SkMakeSpan(glyphIDs), paths);
+    cache.saveToDiskCache();
+
+    // A fresh cache, as in another process, starts with the saved glyphs.
+    {
+        SkStrikeCache loading;
+        loading.setDiskCache(diskCache);
+        sk_sp<SkStrike> loaded = strikeSpec.findOrCreateStrike(&loading);
+        REPORTER_ASSERT(Reporter, loaded->fScalerCache.countCachedGlyphs() ==
+                                  strike->fScalerCache.countCachedGlyphs());
+        REPORTER_ASSERT(Reporter, !memcmp(&loaded->getFontMetrics(), &strike->getFontMetrics(),
+                                          sizeof(SkFontMetrics)));
+        const SkGlyph* loadedGlyphs[26];
+        const SkGlyph* loadedPaths[26];
+        size_t memoryUsed = loading.getTotalMemoryUsed();
+        loaded->prepareImages(SkMakeSpan(packedIDs), loadedGlyphs);
+        loaded->preparePaths(SkMakeSpan(glyphIDs), loadedPaths);
+        // Nothing had to be made again.
+        REPORTER_ASSERT(Reporter, loading.getTotalMemoryUsed() == memoryUsed);
+        for (int i = 0; i < 26; i++) {
+            const SkGlyph* glyph = loadedGlyphs[i];
+            REPORTER_ASSERT(Reporter, glyph->iRect() == glyphs[i]->iRect());
+            REPORTER_ASSERT(Reporter,
+                            glyph->imageSize() == 0 ||
+                            !memcmp(glyph->image(), glyphs[i]->image(), glyph->imageSize()));
+            const SkPath* path = loadedPaths[i]->path();
+            REPORTER_ASSERT(Reporter, (path == nullptr) == (paths[i]->path() == nullptr));
+            REPORTER_ASSERT(Reporter, path == nullptr || *path == *paths[i]->path());
+        }
+    }
+
+    // Damaged files are ignored.
+    SkOSFile::Iter saved(dir.c_str(), ".glyphs");
+    for (SkString name; saved.next(&name);) {
+        SkString path = SkOSPath::Join(dir.c_str(), name.c_str());
+        sk_sp<SkData> data = SkData::MakeFromFileName(path.c_str());
+        REPORTER_ASSERT(Reporter, data && data->size() > 64);
+        sk_sp<SkData> damaged = SkData::MakeWithCopy(data->data(), data->size());
+        ((uint8_t*)damaged->writable_data())[data->size() / 2] ^= 0xFF;
+        data = nullptr;
+        SkFILEWStream(path.c_str()).write(damaged->data(), damaged->size());
+    }
+    {
+        SkStrikeCache loading;
+        loading.setDiskCache(diskCache);
+        sk_sp<SkStrike> loaded = strikeSpec.findOrCreateStrike(&loading);
+        REPORTER_ASSERT(Reporter, loaded->fScalerCache.countCachedGlyphs() == 0);
+    }
+}
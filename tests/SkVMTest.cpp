@@ -5,13 +5,24 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
 #include "include/core/SkColorPriv.h"
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
+#include "include/effects/SkGradientShader.h"
 #include "include/private/SkColorData.h"
 #include "src/core/SkCpu.h"
 #include "src/core/SkMSAN.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/core/SkVM.h"
+#include "src/core/SkVMBlitter.h"
 #include "tests/Test.h"
 
+#include <functional>
+#include <map>
+#include <string>
+
 template <typename Fn>
 static void test_jit_and_interpreter(const skvm::Builder& b, Fn&& test) {
     skvm::Program p = b.done();
@@ -107,6 +118,228 @@ DEF_TEST(SkVM_allow_jit, r) {
     }
 }
 
+DEF_TEST(SkVM_compileJIT, r) {
+    skvm::Builder b;
+    {
+        skvm::Ptr arg = b.varying<int>();
+        b.store32(arg, b.mul(b.load32(arg), b.splat(3)));
+    }
+    const bool canJIT = b.done("", /*allow_jit=*/true).hasJIT();
+
+    std::vector<skvm::OptimizedInstruction> instructions = b.optimize();
+    skvm::Program p(instructions, b.strides(), "", /*allow_jit=*/false);
+    REPORTER_ASSERT(r, !p.hasJIT());
+    const size_t interpreterBytes = p.approximateBytesUsed();
+
+    // Keep evaluating on other threads while the program is compiled.
+    int bufs[4][64];
+    auto run = [&](int* buf) {
+        for (int i = 0; i < 64; i++) { buf[i] = i; }
+        p.eval(64, buf);
+    };
+    {
+        auto pool = SkExecutor::MakeFIFOThreadPool(3);
+        SkTaskGroup tg(*pool);
+        tg.batch(3, [&](int i) {
+            for (int n = 0; n < 100; n++) { run(bufs[i]); }
+        });
+        p.compileJIT(instructions, "");
+        tg.wait();
+    }
+    run(bufs[3]);
+
+    REPORTER_ASSERT(r, p.hasJIT() == canJIT);
+    REPORTER_ASSERT(r, p.approximateBytesUsed() >= interpreterBytes);
+    for (const int* buf : bufs) {
+        for (int i = 0; i < 64; i++) {
+            REPORTER_ASSERT(r, buf[i] == 3*i);
+        }
+    }
+}
+
+DEF_TEST(SkVM_serialize, r) {
+    skvm::Builder b;
+    {
+        skvm::Ptr src = b.varying<int>(),
+                  dst = b.varying<int>();
+        skvm::UPtr uniforms = b.uniform();
+        b.store32(dst, b.add(b.load32(src), b.uniform32(uniforms, 0)));
+    }
+    std::vector<skvm::OptimizedInstruction> instructions = b.optimize();
+    sk_sp<SkData> data = skvm::Serialize(instructions, b.strides());
+
+    // src and dst are varyings; only the int at uniforms may be read.
+    const size_t uniformSizes[] = {0, 0, sizeof(int)};
+    const SkSpan<const size_t> uniformBytes = SkMakeSpan(uniformSizes);
+    std::vector<skvm::OptimizedInstruction> loaded;
+    std::vector<int> strides;
+    REPORTER_ASSERT(r, skvm::Deserialize(*data, uniformBytes, &loaded, &strides));
+    REPORTER_ASSERT(r, strides == b.strides());
+    REPORTER_ASSERT(r, loaded.size() == instructions.size());
+    for (size_t i = 0; i < loaded.size() && i < instructions.size(); i++) {
+        REPORTER_ASSERT(r, 0 == memcmp(&loaded[i].x, &instructions[i].x, 8 * sizeof(int)));
+        REPORTER_ASSERT(r, loaded[i].op == instructions[i].op &&
+                           loaded[i].can_hoist == instructions[i].can_hoist);
+    }
+
+    skvm::Program p(loaded, strides, "", /*allow_jit=*/true);
+    int src[] = {1,2,3,4,5,6,7,8,9},
+        dst[9] = {},
+        uniform = 40;
+    p.eval(9, src, dst, &uniform);
+    for (int i = 0; i < 9; i++) {
+        REPORTER_ASSERT(r, dst[i] == src[i] + 40);
+    }
+
+    // Truncated or damaged data is rejected.
+    sk_sp<SkData> truncated = SkData::MakeSubset(data.get(), 0, data->size() - 4);
+    REPORTER_ASSERT(r, !skvm::Deserialize(*truncated, uniformBytes, &loaded, &strides));
+    for (size_t offset : {(size_t)0, (size_t)4, data->size() - 1}) {
+        sk_sp<SkData> damaged = SkData::MakeWithCopy(data->data(), data->size());
+        static_cast<uint8_t*>(damaged->writable_data())[offset] ^= 0x10;
+        REPORTER_ASSERT(r, !skvm::Deserialize(*damaged, uniformBytes, &loaded, &strides));
+    }
+
+    // So are instructions which break the invariants of optimize(), even with a valid checksum.
+    auto find = [&](skvm::Op op) {
+        for (size_t i = 0; i < instructions.size(); i++) {
+            if (instructions[i].op == op) { return (int)i; }
+        }
+        SkASSERT(false);
+        return -1;
+    };
+    const int load      = find(skvm::Op::load32),
+              add       = find(skvm::Op::add_i32),
+              store     = find(skvm::Op::store32),
+              uniform32 = find(skvm::Op::uniform32);
+    const std::function<void(std::vector<skvm::OptimizedInstruction>*)> breakages[] = {
+        // A missing argument.
+        [&](auto* insts) { (*insts)[add].y = skvm::NA; },
+        // An argument the op does not have.
+        [&](auto* insts) { (*insts)[store].y = load; },
+        // A value which dies before it is made.
+        [&](auto* insts) { (*insts)[add].death = add - 1; },
+        // An argument which dies before it is used.
+        [&](auto* insts) { (*insts)[load].death = load; },
+        // A hoisted value which depends on a varying one.
+        [&](auto* insts) { (*insts)[add].can_hoist = true; },
+        // A hoisted load.
+        [&](auto* insts) { (*insts)[load].can_hoist = true; },
+        // A uniform read past the end of the uniforms.
+        [&](auto* insts) { (*insts)[uniform32].immB = sizeof(int); },
+        // A uniform read before the start of the uniforms.
+        [&](auto* insts) { (*insts)[uniform32].immB = -(int)sizeof(int); },
+        // A uniform read from a varying.
+        [&](auto* insts) { (*insts)[uniform32].immA = (*insts)[load].immA; },
+        // A load wider than its varying.
+        [&](auto* insts) { (*insts)[load].op = skvm::Op::load64; },
+    };
+    for (const auto& breakage : breakages) {
+        std::vector<skvm::OptimizedInstruction> broken = instructions;
+        breakage(&broken);
+        sk_sp<SkData> malformed = skvm::Serialize(broken, b.strides());
+        REPORTER_ASSERT(r, !skvm::Deserialize(*malformed, uniformBytes, &loaded, &strides));
+    }
+
+    // The uniforms must be described for every argument.
+    REPORTER_ASSERT(r, !skvm::Deserialize(*data, SkMakeSpan(uniformSizes, 2), &loaded, &strides));
+}
+
+namespace {
+    class MemoryPersistentCache final : public SkVMBlitter::PersistentCache {
+    public:
+        sk_sp<SkData> load(const SkData& key) override {
+            auto found = fEntries.find(ToString(key));
+            if (found == fEntries.end()) {
+                return nullptr;
+            }
+            fHits++;
+            return found->second;
+        }
+        void store(const SkData& key, const SkData& data) override {
+            fEntries[ToString(key)] = SkData::MakeWithCopy(data.data(), data.size());
+            fStores++;
+        }
+
+        static std::string ToString(const SkData& data) {
+            return std::string(static_cast<const char*>(data.data()), data.size());
+        }
+
+        std::map<std::string, sk_sp<SkData>> fEntries;
+        int fHits = 0,
+            fStores = 0;
+    };
+}  // namespace
+
+extern bool gUseSkVMBlitter;
+
+static SkBitmap draw_with_skvm_blitter(SkVMBlitter::PersistentCache* cache) {
+    const bool wasUsingSkVMBlitter = gUseSkVMBlitter;
+    gUseSkVMBlitter = true;
+    SkVMBlitter::SetPersistentCache(cache);
+    SkVMBlitter::PurgeProgramCacheForTesting();
+
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(32, 32);
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(bitmap);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    const SkPoint pts[] = {{0, 0}, {32, 32}};
+    const SkColor colors[] = {SK_ColorRED, SK_ColorBLUE};
+    paint.setShader(SkGradientShader::MakeLinear(pts, colors, nullptr, 2, SkTileMode::kClamp));
+    canvas.drawCircle(16, 16, 12, paint);
+
+    SkVMBlitter::SetPersistentCache(nullptr);
+    gUseSkVMBlitter = wasUsingSkVMBlitter;
+    return bitmap;
+}
+
+static bool equal_pixels(const SkBitmap& a, const SkBitmap& b) {
+    return 0 == memcmp(a.getPixels(), b.getPixels(), a.computeByteSize());
+}
+
+// Sets the persistent cache and the blitter program cache, both global.
+DEF_SERIAL_TEST(SkVMBlitter_persistentCache, r) {
+    // Programs are built and stored the first time.
+    MemoryPersistentCache first;
+    const SkBitmap expected = draw_with_skvm_blitter(&first);
+    REPORTER_ASSERT(r, first.fStores > 0);
+    REPORTER_ASSERT(r, first.fHits == 0);
+
+    // A fresh cache holding those programs, as in another process, makes the same pixels without
+    // building any of them.
+    MemoryPersistentCache second;
+    second.fEntries = first.fEntries;
+    REPORTER_ASSERT(r, equal_pixels(draw_with_skvm_blitter(&second), expected));
+    REPORTER_ASSERT(r, second.fHits == (int)first.fEntries.size());
+    REPORTER_ASSERT(r, second.fStores == 0);
+
+    // Programs reading past the end of the blitter's uniforms are rejected, and built again.
+    MemoryPersistentCache tampered;
+    for (const auto& [key, data] : first.fEntries) {
+        std::vector<skvm::OptimizedInstruction> instructions;
+        std::vector<int> strides;
+        for (int args = 0; args <= 7; args++) {
+            const std::vector<size_t> anything(args, SIZE_MAX);
+            if (skvm::Deserialize(*data, SkMakeSpan(anything), &instructions, &strides)) {
+                break;
+            }
+        }
+        int uniforms = 0;
+        for (skvm::OptimizedInstruction& inst : instructions) {
+            if (inst.op == skvm::Op::uniform32) {
+                inst.immB += 1 << 20;
+                uniforms++;
+            }
+        }
+        REPORTER_ASSERT(r, uniforms > 0);
+        tampered.fEntries[key] = skvm::Serialize(instructions, strides);
+    }
+    REPORTER_ASSERT(r, equal_pixels(draw_with_skvm_blitter(&tampered), expected));
+    REPORTER_ASSERT(r, tampered.fStores == (int)first.fEntries.size());
+}
+
 DEF_TEST(SkVM_LoopCounts, r) {
     // Make sure we cover all the exact N we want.
 
@@ -75,6 +75,14 @@ struct Test {
     bool needsGpu;
     TestProc proc;
     ContextOptionsProc fContextOptionsProc;
+    // CPU tests which change global state run on their own, after the other tests.
+    bool serial = false;
+
+    static Test MakeSerial(const char* n, TestProc p) {
+        Test test(n, false, p);
+        test.serial = true;
+        return test;
+    }
 
     void modifyGrContextOptions(GrContextOptions* options) {
         if (fContextOptionsProc) {
@@ -178,6 +186,11 @@ static inline SkString reporter_string(const char* fmt, Args... args)  {
     skiatest::TestRegistry name##TestRegistry(skiatest::Test(#name, false, test_##name)); \
     void test_##name(skiatest::Reporter* reporter, const GrContextOptions&)
 
+#define DEF_SERIAL_TEST(name, reporter)                                                        \
+    static void test_##name(skiatest::Reporter*, const GrContextOptions&);                     \
+    skiatest::TestRegistry name##TestRegistry(skiatest::Test::MakeSerial(#name, test_##name)); \
+    void test_##name(skiatest::Reporter* reporter, const GrContextOptions&)
+
 #define DEF_GPUTEST(name, reporter, options)                                             \
     static void test_##name(skiatest::Reporter*, const GrContextOptions&);               \
     skiatest::TestRegistry name##TestRegistry(skiatest::Test(#name, true, test_##name)); \
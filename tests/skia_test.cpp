@@ -233,6 +233,7 @@ int main(int argc, char** argv) {
     SkTaskGroup::Enabler enabled(FLAGS_threads);
     SkTaskGroup cpuTests;
     SkTArray<const Test*> gpuTests;
+    SkTArray<const Test*> serialTests;
 
     Status status(toRun);
 
@@ -241,6 +242,8 @@ int main(int argc, char** argv) {
             ++skipCount;
         } else if (test.needsGpu) {
             gpuTests.push_back(&test);
+        } else if (test.serial) {
+            serialTests.push_back(&test);
         } else {
             cpuTests.add(SkTestRunnable(test, &status));
         }
@@ -254,6 +257,11 @@ int main(int argc, char** argv) {
     // Block until threaded tests finish.
     cpuTests.wait();
 
+    // Run tests which change global state once nothing else runs.
+    for (int i = 0; i < serialTests.count(); i++) {
+        SkTestRunnable(*serialTests[i], &status)();
+    }
+
     if (FLAGS_verbose) {
         SkDebugf(
                 "\nFinished %d tests, %d failures, %d skipped. "
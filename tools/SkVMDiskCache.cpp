@@ -0,0 +1,56 @@
+/*
+ * Copyright 2021 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "tools/SkVMDiskCache.h"
+
+#include "include/core/SkData.h"
+#include "include/core/SkStream.h"
+#include "src/core/SkOSFile.h"
+#include "src/utils/SkOSPath.h"
+
+#include <atomic>
+#include <cstdio>
+
+SkVMDiskCache::SkVMDiskCache(const char* dir) : fDir(dir) {
+    if (!sk_isdir(dir)) {
+        sk_mkdir(dir);
+    }
+}
+
+SkString SkVMDiskCache::path(const SkData& key) const {
+    // Keys are short, so they make their own file names.
+    SkString name;
+    for (size_t i = 0; i < key.size(); ++i) {
+        name.appendf("%02x", key.bytes()[i]);
+    }
+    name.append(".skvm");
+    return SkOSPath::Join(fDir.c_str(), name.c_str());
+}
+
+sk_sp<SkData> SkVMDiskCache::load(const SkData& key) {
+    return SkData::MakeFromFileName(this->path(key).c_str());
+}
+
+void SkVMDiskCache::store(const SkData& key, const SkData& data) {
+    const SkString path = this->path(key);
+    // Another thread or process may be writing the same program, so write a file of our own and
+    // rename it into place; readers only ever see whole files. The process id and a counter
+    // make the temporary name unique among all writers.
+    static std::atomic<uint32_t> gTempCounter{0};
+    const SkString temp = SkStringPrintf(
+            "%s.%d.%u.tmp", path.c_str(), sk_getpid(),
+            gTempCounter.fetch_add(1, std::memory_order_relaxed));
+    bool written;
+    {
+        SkFILEWStream stream(temp.c_str());
+        written = stream.isValid() && stream.write(data.data(), data.size());
+    }
+    // Renaming over an existing file fails on some platforms; then the program is already there.
+    if (!written || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+    }
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2021 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkVMDiskCache_DEFINED
+#define SkVMDiskCache_DEFINED
+
+#include "include/core/SkString.h"
+#include "src/core/SkVMBlitter.h"
+
+/**
+ *  Keeps optimized SkVMBlitter programs in a directory, one file per program, so that they are
+ *  shared by every process using that directory. Files are written whole and then renamed into
+ *  place, so processes can share the directory while they run.
+ */
+class SkVMDiskCache final : public SkVMBlitter::PersistentCache {
+public:
+    // Creates dir if it does not exist.
+    explicit SkVMDiskCache(const char* dir);
+
+    sk_sp<SkData> load(const SkData& key) override;
+    void store(const SkData& key, const SkData& data) override;
+
+private:
+    SkString path(const SkData& key) const;
+
+    const SkString fDir;
+};
+
+#endif
@@ -1,5 +1,6 @@
 
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkFontMetrics.h"
 #include "include/core/SkFontMgr.h"
@@ -14,12 +15,19 @@
 
 #include "include/ports/SkFontMgr_empty.h"
 
+#include "src/core/SkTaskGroup.h"
 #include "tools/flags/CommandLineFlags.h"
 
 #include "hb-ot.h"
 
+#include <atomic>
+#include <fstream>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 static DEFINE_string(font, "skia_test/samples-colr_1.ttf", "Font to load.");
 static DEFINE_string(text, "simple_linearsimple_radial", "Text to render in font.");
@@ -28,15 +36,53 @@ static DEFINE_bool(show_bbox, false, "Whether to draw bbox markers.");
 static DEFINE_int(margin, 0, "Margin.");
 static DEFINE_int(height, -1, "Canvas height. If -1, autosize to fit.");
 static DEFINE_int(width, -1, "Canvas height. If -1, autosize to fit.");
+static DEFINE_string(manifest, "",
+                     "Render every line of this file instead of --text. Each "
+                     "line is font, text, height, palette and output, "
+                     "separated by tabs; height is as for --height.");
+static DEFINE_int(threads, 0, "Threads to render --manifest on. If 0, one per core.");
 
 const double kFontSizeScale = 64.0f;
 const float kFontSize = 128;
 const float kDefaultFontSize = 128;
 
-int main(int argc, char** argv) {
-  CommandLineFlags::Parse(argc, argv);
+// A font loaded once and shared by every string rendered with it. HarfBuzz
+// objects are made immutable, so they may be used to shape on many threads.
+struct LoadedFont {
+  ~LoadedFont() {
+    hb_font_destroy(hb_font);
+    hb_face_destroy(hb_face);
+  }
 
-  auto font_mgr = sk_sp<SkFontMgr>(SkFontMgr_New_Custom_Empty());
+  sk_sp<SkTypeface> typeface;
+  // Clones of typeface by CPAL palette index.
+  std::map<int, sk_sp<SkTypeface>> palettes;
+  hb_face_t* hb_face = nullptr;
+  hb_font_t* hb_font = nullptr;
+};
+
+// One string to render, from the flags or from a line of the manifest.
+struct Job {
+  std::string font;
+  std::string text;
+  int height = -1;
+  int palette = 0;
+  std::string output;
+};
+
+static std::unique_ptr<LoadedFont> load_font(SkFontMgr* font_mgr,
+                                             const char* path) {
+  auto data = SkData::MakeFromFileName(path);
+  if (!data) {
+    return nullptr;
+  }
+  std::unique_ptr<SkStreamAsset> data_stream(new SkMemoryStream(data));
+  auto loaded = std::make_unique<LoadedFont>();
+  loaded->typeface = font_mgr->makeFromStream(std::move(data_stream));
+  if (!loaded->typeface) {
+    return nullptr;
+  }
+  loaded->palettes[0] = loaded->typeface;
 
   // Shape & thus measure our text
   // Initially based on https://harfbuzz.github.io/ch03s03.html
@@ -44,22 +90,6 @@ int main(int argc, char** argv) {
   // Then based on https://github.com/aam/skiaex/blob/master/app/main.cpp,
   // which is referenced from Skia faq about how to get shaping.
 
-  auto data = SkData::MakeFromFileName(FLAGS_font[0]);
-  std::unique_ptr<SkStreamAsset> data_stream(new SkMemoryStream(data));
-  sk_sp<SkTypeface> face(
-      font_mgr->makeFromStream(std::move(data_stream)));
-  SkASSERT(face);
-
-
-  SkFont font(face);
-  if (FLAGS_height == -1) {
-      font.setSize(kDefaultFontSize);
-  } else {
-      // IIUC, the view box of the SVG is scaled to ascender plus descender, but
-      // the font size is scaling the 1024 em box. Correct for that.
-      font.setSize(FLAGS_height * 1024.f / (950 + 250));
-  }
-
   // get a blob of our font file
   auto destroy = [](void *d) { static_cast<SkData*>(d)->unref(); };
   const char* bytes = (const char*)data->data();
@@ -72,25 +102,60 @@ int main(int argc, char** argv) {
   hb_blob_make_immutable(hb_font_blob);
 
   // We'll need an hb face & font to shape
-  hb_face_t* hb_face = hb_face_create(hb_font_blob, /* index */ 0);
+  loaded->hb_face = hb_face_create(hb_font_blob, /* index */ 0);
   hb_blob_destroy(hb_font_blob);
 
-  hb_font_t *hb_font = hb_font_create(hb_face);
+  loaded->hb_font = hb_font_create(loaded->hb_face);
   /*hb_font_set_scale(hb_font,
         kFontSizeScale * kFontSize,
         kFontSizeScale * kFontSize);*/
-  hb_ot_font_set_funcs(hb_font);
+  hb_ot_font_set_funcs(loaded->hb_font);
 
   // Let's all agree on upem
-  hb_face_set_upem(hb_face, face->getUnitsPerEm());
-  printf("upem %d\n", face->getUnitsPerEm());
+  hb_face_set_upem(loaded->hb_face, loaded->typeface->getUnitsPerEm());
+  hb_face_make_immutable(loaded->hb_face);
+  hb_font_make_immutable(loaded->hb_font);
+  return loaded;
+}
+
+// Makes the clone of font for palette, if there is none yet. Not thread safe,
+// so all palettes are made before rendering starts.
+static bool add_palette(LoadedFont* font, int palette) {
+  if (font->palettes.count(palette)) {
+    return true;
+  }
+  SkFontArguments args;
+  args.setPalette({palette, nullptr, 0});
+  sk_sp<SkTypeface> clone = font->typeface->makeClone(args);
+  if (!clone) {
+    return false;
+  }
+  font->palettes[palette] = std::move(clone);
+  return true;
+}
+
+// Renders job into a PNG, or returns nullptr on failure.
+static sk_sp<SkData> render(const LoadedFont& loaded, const Job& job,
+                            bool verbose) {
+  SkFont font(loaded.palettes.at(job.palette));
+  if (job.height == -1) {
+      font.setSize(kDefaultFontSize);
+  } else {
+      // IIUC, the view box of the SVG is scaled to ascender plus descender, but
+      // the font size is scaling the 1024 em box. Correct for that.
+      font.setSize(job.height * 1024.f / (950 + 250));
+  }
+
+  if (verbose) {
+    printf("upem %d\n", loaded.typeface->getUnitsPerEm());
+  }
 
   // Oh wise and powerful HarfBuzz, what glyphs and where?
   hb_buffer_t *hb_buffer = hb_buffer_create ();
-  hb_buffer_add_utf8 (hb_buffer, FLAGS_text[0], -1, 0, -1);
+  hb_buffer_add_utf8 (hb_buffer, job.text.c_str(), -1, 0, -1);
   hb_buffer_guess_segment_properties (hb_buffer);
 
-  hb_shape (hb_font, hb_buffer, NULL, 0);
+  hb_shape (loaded.hb_font, hb_buffer, NULL, 0);
 
   // Stand back, I'm thinking about drawing
   SkTextBlobBuilder textBlobBuilder;
@@ -105,7 +170,9 @@ int main(int argc, char** argv) {
   for (unsigned int i = 0; i < len; i++)
   {
     runBuffer.glyphs[i] = info[i].codepoint;
-    printf("gid %d (%.01f %.01f)\n", info[i].codepoint, x, y);
+    if (verbose) {
+      printf("gid %d (%.01f %.01f)\n", info[i].codepoint, x, y);
+    }
     reinterpret_cast<SkPoint*>(runBuffer.pos)[i] = SkPoint::Make(
       x + pos[i].x_offset / kFontSizeScale,
       y - pos[i].y_offset / kFontSizeScale);
@@ -113,50 +180,185 @@ int main(int argc, char** argv) {
     x += pos[i].x_advance / kFontSizeScale;
     y += pos[i].y_advance / kFontSizeScale;
   }
+  hb_buffer_destroy (hb_buffer);
+
+  // The blob's own bounds are those of the whole font, so autosize to the
+  // bounds of the glyphs instead. Color glyphs are measured without rendering
+  // them.
+  std::vector<SkRect> glyph_bounds(len);
+  font.getConservativeBounds(runBuffer.glyphs, len, glyph_bounds.data());
+  SkRect ink = SkRect::MakeEmpty();
+  for (unsigned int i = 0; i < len; i++) {
+    ink.join(glyph_bounds[i].makeOffset(
+        reinterpret_cast<SkPoint*>(runBuffer.pos)[i]));
+  }
+  ink.roundOut(&ink);
 
   auto textBlob = textBlobBuilder.make();
+  if (!textBlob) {
+    return nullptr;
+  }
 
   // How much space y'all need?
   auto margin = FLAGS_margin;
-  auto bbox = textBlob->bounds();
-  x = 2 * margin + (FLAGS_width > -1 ? FLAGS_width : bbox.width());
-  y = 2 * margin + (FLAGS_height > -1 ? FLAGS_height : bbox.height());
+  x = 2 * margin + (FLAGS_width > -1 ? FLAGS_width : ink.width());
+  y = 2 * margin + (job.height > -1 ? job.height : ink.height());
 
   // Let's paint something!
-  printf("Making %.1f x %.1f canvas\n", x, y);
+  if (verbose) {
+    printf("Making %.1f x %.1f canvas\n", x, y);
+  }
   SkImageInfo image_info =
       SkImageInfo::Make(x, y, SkColorType::kRGBA_8888_SkColorType,
                         SkAlphaType::kPremul_SkAlphaType);
   sk_sp<SkSurface> surface(SkSurface::MakeRaster(image_info));
   if (!surface)
-    return 1;
+    return nullptr;
   SkCanvas* canvas = surface->getCanvas();
   canvas->clear(SK_ColorTRANSPARENT);
 
   SkPaint paint;
 
-  SkFontMetrics metrics;
-  font.getMetrics(&metrics);
-
   if (FLAGS_show_bbox) {
     canvas->drawLine(margin, margin, x - margin, margin, paint);
     canvas->drawLine(margin, y - margin, x - margin, y - margin, paint);
   }
 
-  // The view box of the SVG is scaled to ascender plus descender and centerd
-  // within the advance width.  Ascender is 950, descender 250, advance width is
-  // 1295. So it's 1200 centered in 1295.  Reverse this centering here.
-  canvas->drawTextBlob(textBlob,
-                       margin - (FLAGS_height * (1295 - (950 + 250)) / 1295 / 2),
-                       y - metrics.fDescent + margin,
-                       paint);
+  if (job.height > -1) {
+    // The view box of the SVG is scaled to ascender plus descender and centerd
+    // within the advance width.  Ascender is 950, descender 250, advance width
+    // is 1295. So it's 1200 centered in 1295.  Reverse this centering here.
+    SkFontMetrics metrics;
+    font.getMetrics(&metrics);
+    canvas->drawTextBlob(textBlob,
+                         margin - (job.height * (1295 - (950 + 250)) / 1295 / 2),
+                         y - metrics.fDescent + margin,
+                         paint);
+  } else {
+    // Autosized: put the ink in the top left corner, inside the margin.
+    canvas->drawTextBlob(textBlob, margin - ink.left(), margin - ink.top(), paint);
+  }
 
   sk_sp<SkImage> image = surface->makeImageSnapshot();
-  sk_sp<SkData> png = image->encodeToData(SkEncodedImageFormat::kPNG, 100);
-  SkFILEWStream{FLAGS_output[0]}.write(png->data(), png->size());
+  return image->encodeToData(SkEncodedImageFormat::kPNG, 100);
+}
 
-  // Cleanup
-  hb_buffer_destroy (hb_buffer);
-  hb_font_destroy(hb_font);
-  hb_face_destroy(hb_face);
+static bool write_png(const std::string& path, const SkData& png) {
+  SkFILEWStream file(path.c_str());
+  return file.isValid() && file.write(png.data(), png.size());
+}
+
+// Reads one job per line: font, text, height, palette and output, separated by
+// tabs. Empty lines and lines starting with '#' are skipped.
+static bool read_manifest(const char* path, std::vector<Job>* jobs) {
+  std::ifstream manifest(path);
+  if (!manifest) {
+    fprintf(stderr, "Could not open manifest %s\n", path);
+    return false;
+  }
+  std::string line;
+  for (int line_number = 1; std::getline(manifest, line); ++line_number) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    for (std::string field; std::getline(stream, field, '\t');) {
+      fields.push_back(field);
+    }
+    if (fields.size() != 5) {
+      fprintf(stderr, "%s:%d: expected 5 tab separated fields, got %zu\n",
+              path, line_number, fields.size());
+      return false;
+    }
+    Job job;
+    job.font = fields[0];
+    job.text = fields[1];
+    job.height = atoi(fields[2].c_str());
+    job.palette = atoi(fields[3].c_str());
+    job.output = fields[4];
+    jobs->push_back(std::move(job));
+  }
+  return true;
+}
+
+// Loads each font of the manifest once, then shapes and renders on a thread
+// pool while a single thread writes the PNGs.
+static int run_batch(SkFontMgr* font_mgr) {
+  std::vector<Job> jobs;
+  if (!read_manifest(FLAGS_manifest[0], &jobs)) {
+    return 1;
+  }
+
+  std::map<std::string, std::unique_ptr<LoadedFont>> fonts;
+  std::vector<const LoadedFont*> job_fonts(jobs.size(), nullptr);
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    std::unique_ptr<LoadedFont>& font = fonts[jobs[i].font];
+    if (!font) {
+      font = load_font(font_mgr, jobs[i].font.c_str());
+      if (!font) {
+        fprintf(stderr, "Could not load font %s\n", jobs[i].font.c_str());
+        return 1;
+      }
+    }
+    if (!add_palette(font.get(), jobs[i].palette)) {
+      fprintf(stderr, "Could not select palette %d of %s\n",
+              jobs[i].palette, jobs[i].font.c_str());
+      return 1;
+    }
+    job_fonts[i] = font.get();
+  }
+
+  std::unique_ptr<SkExecutor> render_pool =
+      SkExecutor::MakeFIFOThreadPool(FLAGS_threads);
+  std::unique_ptr<SkExecutor> write_pool = SkExecutor::MakeFIFOThreadPool(1);
+  std::atomic<int> failures{0};
+  {
+    // Destroyed, and so waited for, after the renders which add to it.
+    SkTaskGroup writes(*write_pool);
+    SkTaskGroup renders(*render_pool);
+    renders.batch(jobs.size(), [&](int i) {
+      sk_sp<SkData> png = render(*job_fonts[i], jobs[i], /* verbose */ false);
+      if (!png) {
+        fprintf(stderr, "Could not render %s\n", jobs[i].output.c_str());
+        failures++;
+        return;
+      }
+      writes.add([&, i, png] {
+        if (!write_png(jobs[i].output, *png)) {
+          fprintf(stderr, "Could not write %s\n", jobs[i].output.c_str());
+          failures++;
+        }
+      });
+    });
+  }
+  printf("Rendered %zu strings with %zu fonts, %d failed\n",
+         jobs.size(), fonts.size(), failures.load());
+  return failures.load() ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+  CommandLineFlags::Parse(argc, argv);
+
+  auto font_mgr = sk_sp<SkFontMgr>(SkFontMgr_New_Custom_Empty());
+
+  if (!FLAGS_manifest.isEmpty()) {
+    return run_batch(font_mgr.get());
+  }
+
+  std::unique_ptr<LoadedFont> loaded = load_font(font_mgr.get(), FLAGS_font[0]);
+  SkASSERT(loaded);
+  if (!loaded) {
+    return 1;
+  }
+
+  Job job;
+  job.text = FLAGS_text[0];
+  job.height = FLAGS_height;
+  job.output = FLAGS_output[0];
+  sk_sp<SkData> png = render(*loaded, job, /* verbose */ true);
+  if (!png) {
+    return 1;
+  }
+  write_png(job.output, *png);
 }
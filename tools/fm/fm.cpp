@@ -23,6 +23,7 @@
 #include "tools/AutoreleasePool.h"
 #include "tools/CrashHandler.h"
 #include "tools/HashAndEncode.h"
+#include "tools/SkVMDiskCache.h"
 #include "tools/ToolUtils.h"
 #include "tools/flags/CommandLineFlags.h"
 #include "tools/flags/CommonFlags.h"
@@ -64,6 +65,7 @@ static DEFINE_bool  (legacy,    false, "Use a null SkColorSpace instead of --gam
 static DEFINE_bool  (skvm ,    false, "Use SkVMBlitter when supported?");
 static DEFINE_bool  (jit  ,     true, "JIT SkVM?");
 static DEFINE_bool  (dylib,    false, "JIT SkVM via dylib?");
+static DEFINE_string(skvmCache,    "", "Directory to keep optimized SkVM programs in.");
 
 static DEFINE_bool  (reducedshaders,    false, "Use reduced shader set for any GPU backend.");
 static DEFINE_int   (samples       ,         0, "Samples per pixel in GPU backends.");
@@ -391,6 +393,12 @@ int main(int argc, char** argv) {
     gSkVMAllowJIT    = FLAGS_jit;
     gSkVMJITViaDylib = FLAGS_dylib;
 
+    std::unique_ptr<SkVMDiskCache> skvmCache;
+    if (!FLAGS_skvmCache.isEmpty()) {
+        skvmCache = std::make_unique<SkVMDiskCache>(FLAGS_skvmCache[0]);
+        SkVMBlitter::SetPersistentCache(skvmCache.get());
+    }
+
     initializeEventTracingForTools();
     ToolUtils::SetDefaultFontMgr();
     SetAnalyticAAFromCommonFlags();